@@ -0,0 +1,115 @@
+#include <vector>
+
+#include <ssl_helpers/crypto.h>
+#include <ssl_helpers/crypto_record.h>
+#include <ssl_helpers/shadowing.h>
+
+#include "benchmark_common.h"
+
+
+using namespace ssl_helpers;
+using namespace ssl_helpers::benchmarks;
+
+namespace {
+
+template <typename Func>
+void benchmark_messages(const std::string& name, size_t messages, size_t message_size, Func&& func)
+{
+    auto allocations = allocations_count();
+    stopwatch sw;
+    func();
+    auto seconds = sw.seconds();
+    allocations = allocations_count() - allocations;
+
+    print_messages_result(name + ", message " + std::to_string(message_size),
+                          messages, seconds, static_cast<double>(allocations) / messages);
+}
+
+} // namespace
+
+int main()
+{
+    auto& ctx = default_context_with_crypto_api();
+
+    std::string key { "Benchmark Key" };
+    auto shadowed_key = nxor_encode(key);
+    prepared_aes_key prepared_key(ctx, shadowed_key);
+
+    // Messages are encrypted by batches of 'batch_size'
+    const size_t batch_size = 1000;
+    const size_t rounds = 100;
+    const size_t messages = batch_size * rounds;
+
+    for (size_t message_size : { 16, 100, 1024 })
+    {
+        auto message = create_benchmark_data(message_size);
+
+        std::vector<std::string> plain_messages(batch_size, message);
+        aes_batch_type batch;
+        for (auto&& plain_message : plain_messages)
+            batch.add(plain_message);
+
+        benchmark_messages("aes_encrypt loop", messages, message_size, [&]() {
+            for (size_t round = 0; round < rounds; ++round)
+                for (auto&& plain_message : plain_messages)
+                    aes_encrypt(ctx, plain_message, key);
+        });
+        benchmark_messages("aes_encrypt_batch", messages, message_size, [&]() {
+            for (size_t round = 0; round < rounds; ++round)
+                aes_encrypt_batch(ctx, batch, key);
+        });
+
+        std::vector<char> cbc_cipher_message(message_size + aes_size<aes_128bit_type>());
+        aes_cbc_cipher cbc_cipher(ctx, key);
+        benchmark_messages("aes_cbc_cipher loop", messages, message_size, [&]() {
+            for (size_t round = 0; round < rounds; ++round)
+                for (auto&& plain_message : plain_messages)
+                    cbc_cipher.encrypt(plain_message.data(), plain_message.size(), cbc_cipher_message.data());
+        });
+
+        std::vector<char> cipher_message(message_size);
+        aes_encryption_stream stream(ctx);
+        benchmark_messages("aes_encryption_stream loop (prepared key)", messages, message_size, [&]() {
+            for (size_t round = 0; round < rounds; ++round)
+                for (auto&& plain_message : plain_messages)
+                {
+                    stream.start(prepared_key);
+                    stream.encrypt(plain_message.data(), plain_message.size(), cipher_message.data());
+                    stream.finalize();
+                }
+        });
+        benchmark_messages("aes_encrypt_gcm_batch", messages, message_size, [&]() {
+            for (size_t round = 0; round < rounds; ++round)
+                aes_encrypt_gcm_batch(ctx, batch, shadowed_key);
+        });
+
+        std::vector<char> frame(aes_record_frame_size(message_size));
+        aes_record_sealer sealer(ctx, shadowed_key);
+        benchmark_messages("aes_record_sealer loop", messages, message_size, [&]() {
+            for (size_t round = 0; round < rounds; ++round)
+                for (auto&& plain_message : plain_messages)
+                    sealer.seal(plain_message.data(), plain_message.size(), frame.data(), frame.size());
+        });
+    }
+
+    // Flip sessions are dominated by PBKDF2 of every session
+    const size_t flip_sessions = 200;
+    const size_t flip_message_size = 1024;
+    {
+        auto message = create_benchmark_data(flip_message_size);
+
+        std::vector<flip_session_type> sessions;
+        for (size_t ci = 0; ci < flip_sessions; ++ci)
+            sessions.emplace_back(aes_encrypt_flip(ctx, message, key));
+
+        benchmark_messages("aes_decrypt_flip loop", flip_sessions, flip_message_size, [&]() {
+            for (auto&& session : sessions)
+                aes_decrypt_flip(ctx, session, key);
+        });
+        benchmark_messages("aes_decrypt_flip_batch", flip_sessions, flip_message_size, [&]() {
+            aes_decrypt_flip_batch(ctx, sessions, { key });
+        });
+    }
+
+    return 0;
+}
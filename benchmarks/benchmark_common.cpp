@@ -0,0 +1,76 @@
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include "benchmark_common.h"
+
+
+namespace {
+std::atomic<size_t> __allocations_count { 0 };
+} // namespace
+
+void* operator new(std::size_t sz)
+{
+    ++__allocations_count;
+    if (void* p = std::malloc(sz ? sz : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace ssl_helpers {
+namespace benchmarks {
+
+    size_t allocations_count()
+    {
+        return __allocations_count.load();
+    }
+
+    std::string create_benchmark_data(const size_t size)
+    {
+        std::string data(size, '\0');
+        for (size_t ci = 0; ci < size; ++ci)
+        {
+            data[ci] = static_cast<char>(ci * 31 + 7);
+        }
+        return data;
+    }
+
+    void print_result(const std::string& name, size_t bytes, double seconds, double allocations_per_call)
+    {
+        std::cout << std::left << std::setw(56) << name
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << (seconds > 0 ? bytes / seconds / (1024 * 1024) : 0) << " MB/s"
+                  << std::setprecision(2)
+                  << std::setw(10) << allocations_per_call << " allocs/call"
+                  << std::endl;
+    }
+
+    void print_messages_result(const std::string& name, size_t messages, double seconds, double allocations_per_message)
+    {
+        std::cout << std::left << std::setw(56) << name
+                  << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(10) << (seconds > 0 ? messages / seconds : 0) << " msg/s"
+                  << std::setprecision(2)
+                  << std::setw(10) << allocations_per_message << " allocs/msg"
+                  << std::endl;
+    }
+
+    context& default_context_with_crypto_api()
+    {
+        return context::init(context::configurate().enable_libcrypto_api());
+    }
+
+} // namespace benchmarks
+} // namespace ssl_helpers
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <string>
+
+#include <ssl_helpers/context.h>
+
+
+namespace ssl_helpers {
+namespace benchmarks {
+
+    // Amount of heap allocations (operator new) from the process start.
+    // Counter is provided by replaced global operator new of benchmark executable.
+    size_t allocations_count();
+
+    class stopwatch
+    {
+    public:
+        stopwatch()
+            : _started(std::chrono::steady_clock::now())
+        {
+        }
+
+        double seconds() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - _started).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point _started;
+    };
+
+    std::string create_benchmark_data(const size_t size);
+
+    void print_result(const std::string& name, size_t bytes, double seconds, double allocations_per_call);
+    void print_messages_result(const std::string& name, size_t messages, double seconds, double allocations_per_message);
+
+    context& default_context_with_crypto_api();
+
+} // namespace benchmarks
+} // namespace ssl_helpers
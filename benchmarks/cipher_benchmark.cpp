@@ -0,0 +1,34 @@
+#include <ssl_helpers/crypto_container.h>
+#include <ssl_helpers/shadowing.h>
+
+#include "benchmark_common.h"
+
+
+using namespace ssl_helpers;
+using namespace ssl_helpers::benchmarks;
+
+int main()
+{
+    std::string key { "Benchmark Key" };
+    auto shadowed_key = nxor_encode(key);
+
+    auto data = create_benchmark_data(128 * 1024 * 1024);
+
+    const std::pair<config::AEAD_CIPHER, const char*> ciphers[] = {
+        { config::AEAD_CIPHER_aes256_gcm, "AES-256-GCM" },
+        { config::AEAD_CIPHER_aes128_gcm, "AES-128-GCM" },
+        { config::AEAD_CIPHER_chacha20_poly1305, "ChaCha20-Poly1305" },
+        { config::AEAD_CIPHER_auto, "auto" },
+    };
+
+    for (auto&& cipher : ciphers)
+    {
+        auto& ctx = context::init(context::configurate().enable_libcrypto_api().set_aead_cipher(cipher.first));
+
+        stopwatch sw;
+        aes_container_encrypt(ctx, data, shadowed_key, 0, 1);
+        print_result(std::string { "aes_container_encrypt, " } + cipher.second, data.size(), sw.seconds(), 0);
+    }
+
+    return 0;
+}
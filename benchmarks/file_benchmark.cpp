@@ -0,0 +1,79 @@
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <ssl_helpers/crypto.h>
+#include <ssl_helpers/crypto_container.h>
+#include <ssl_helpers/shadowing.h>
+
+#include "benchmark_common.h"
+
+
+using namespace ssl_helpers;
+using namespace ssl_helpers::benchmarks;
+
+int main(int argc, char* argv[])
+{
+    auto& ctx = default_context_with_crypto_api();
+
+    std::string key { "Benchmark Key" };
+    auto shadowed_key = nxor_encode(key);
+
+    // Files are created in current directory if other one is not set
+    std::string dir = argc > 1 ? std::string { argv[1] } + "/" : std::string {};
+    std::string plain_path = dir + "ssl_helpers_benchmark.plain";
+    std::string encrypted_path = dir + "ssl_helpers_benchmark.encrypted";
+
+    const size_t file_size = 256 * 1024 * 1024;
+    {
+        auto data = create_benchmark_data(file_size);
+        std::ofstream output(plain_path, std::ofstream::binary);
+        output.write(data.data(), data.size());
+    }
+
+    {
+        // Sequential loop over stream (read, encrypt, write one by one)
+
+        stopwatch sw;
+
+        std::ifstream input(plain_path, std::ifstream::binary);
+        std::ofstream output(encrypted_path, std::ofstream::binary);
+
+        std::vector<char> plain_buffer(ctx().file_buffer_size());
+        std::vector<char> cipher_buffer(ctx().file_buffer_size());
+
+        aes_encryption_stream stream(ctx);
+        stream.start(shadowed_key);
+        while (input.read(plain_buffer.data(), plain_buffer.size()) || input.gcount() > 0)
+        {
+            size_t len = static_cast<size_t>(input.gcount());
+            stream.encrypt(plain_buffer.data(), len, cipher_buffer.data());
+            output.write(cipher_buffer.data(), len);
+        }
+        auto tag = aes_to_string(stream.finalize());
+        output.write(tag.data(), tag.size());
+        output.close();
+
+        print_result("aes_encryption_stream loop", file_size, sw.seconds(), 0);
+    }
+
+    {
+        stopwatch sw;
+        aes_encrypt_file(ctx, plain_path, encrypted_path, shadowed_key);
+        print_result("aes_encrypt_file", file_size, sw.seconds(), 0);
+    }
+
+    if (config::is_supported_compression(config::COMPRESSION_zlib))
+    {
+        auto& zlib_ctx = context::init(context::configurate().enable_libcrypto_api().set_compression(config::COMPRESSION_zlib));
+
+        stopwatch sw;
+        aes_encrypt_file(zlib_ctx, plain_path, encrypted_path, shadowed_key);
+        print_result("aes_encrypt_file, COMPRESSION_zlib", file_size, sw.seconds(), 0);
+    }
+
+    std::remove(plain_path.c_str());
+    std::remove(encrypted_path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <thread>
+#include <vector>
+
+#include <ssl_helpers/crypto.h>
+#include <ssl_helpers/shadowing.h>
+
+#include "benchmark_common.h"
+
+
+using namespace ssl_helpers;
+using namespace ssl_helpers::benchmarks;
+
+int main()
+{
+    auto& ctx = default_context_with_crypto_api();
+
+    std::string key { "Benchmark Key" };
+    auto shadowed_key = nxor_encode(key);
+
+    auto data = create_benchmark_data(256 * 1024 * 1024);
+    std::vector<char> cipher_data(data.size());
+
+    {
+        aes_encryption_stream stream(ctx);
+        stream.start(shadowed_key);
+
+        stopwatch sw;
+        stream.encrypt(data.data(), data.size(), cipher_data.data());
+        stream.finalize();
+        print_result("aes_encryption_stream", data.size(), sw.seconds(), 0);
+    }
+
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads_amount = 1; threads_amount <= max_threads; threads_amount *= 2)
+    {
+        aes_tag_type tag;
+
+        stopwatch sw;
+        aes_encrypt_parallel(ctx, data.data(), data.size(), cipher_data.data(), shadowed_key, tag, {}, threads_amount);
+        print_result("aes_encrypt_parallel, threads " + std::to_string(threads_amount), data.size(), sw.seconds(), 0);
+    }
+
+    // AES256-CBC decryption is parallel unlike encryption
+    auto cbc_cipher_data = aes_encrypt(ctx, data, key);
+    {
+        stopwatch sw;
+        aes_decrypt(ctx, cbc_cipher_data, key);
+        print_result("aes_decrypt (CBC)", data.size(), sw.seconds(), 0);
+    }
+    for (size_t threads_amount = 1; threads_amount <= max_threads; threads_amount *= 2)
+    {
+        stopwatch sw;
+        aes_decrypt(ctx, cbc_cipher_data, key, threads_amount);
+        print_result("aes_decrypt (CBC), threads " + std::to_string(threads_amount), data.size(), sw.seconds(), 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <ssl_helpers/crypto.h>
+#include <ssl_helpers/crypto_session_pool.h>
+#include <ssl_helpers/shadowing.h>
+
+#include "benchmark_common.h"
+
+
+using namespace ssl_helpers;
+using namespace ssl_helpers::benchmarks;
+
+namespace {
+
+template <typename Func>
+void benchmark_sessions(const std::string& name, size_t sessions, size_t chunk_size, Func&& func)
+{
+    auto allocations = allocations_count();
+    stopwatch sw;
+    func();
+    auto seconds = sw.seconds();
+    allocations = allocations_count() - allocations;
+
+    print_messages_result(name + ", chunk " + std::to_string(chunk_size),
+                          sessions, seconds, static_cast<double>(allocations) / sessions);
+}
+
+} // namespace
+
+int main()
+{
+    auto& ctx = default_context_with_crypto_api();
+
+    std::string key { "Benchmark Key" };
+    auto shadowed_key = nxor_encode(key);
+    prepared_aes_key prepared_key(ctx, shadowed_key);
+
+    // Every session is open, takes several interleaved chunks and is finalized
+    const size_t sessions = 100000;
+    const size_t chunks = 4;
+
+    for (size_t chunk_size : { 64, 1024 })
+    {
+        auto chunk = create_benchmark_data(chunk_size);
+        std::vector<char> cipher_chunk(chunk_size);
+
+        benchmark_sessions("aes_encryption_stream sessions", sessions, chunk_size, [&]() {
+            std::vector<std::unique_ptr<aes_encryption_stream>> streams;
+            streams.reserve(sessions);
+            for (size_t ci = 0; ci < sessions; ++ci)
+            {
+                streams.emplace_back(std::make_unique<aes_encryption_stream>(ctx));
+                streams.back()->start(prepared_key);
+            }
+            for (size_t round = 0; round < chunks; ++round)
+                for (auto&& stream : streams)
+                    stream->encrypt(chunk.data(), chunk.size(), cipher_chunk.data());
+            for (auto&& stream : streams)
+                stream->finalize();
+        });
+
+        aes_session_pool pool(ctx, shadowed_key);
+        benchmark_sessions("aes_session_pool sessions", sessions, chunk_size, [&]() {
+            std::vector<aes_session_handle> handles;
+            handles.reserve(sessions);
+            for (size_t ci = 0; ci < sessions; ++ci)
+                handles.emplace_back(pool.open_encryption());
+            for (size_t round = 0; round < chunks; ++round)
+                for (auto&& handle : handles)
+                    pool.encrypt(handle, chunk.data(), chunk.size(), cipher_chunk.data());
+            for (auto&& handle : handles)
+                pool.finalize_encryption(handle);
+        });
+        std::cout << "aes_session_pool state: " << aes_session_pool::session_size() << " bytes per session, "
+                  << pool.memory_usage() / 1024 << " KB for " << sessions << " sessions" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <vector>
+
+#include <ssl_helpers/crypto.h>
+#include <ssl_helpers/hash.h>
+#include <ssl_helpers/shadowing.h>
+#include <ssl_helpers/encoding.h>
+#include <ssl_helpers/data_pipeline.h>
+
+#include "benchmark_common.h"
+
+
+using namespace ssl_helpers;
+using namespace ssl_helpers::benchmarks;
+
+namespace {
+
+void benchmark_string_chunks(const context& ctx, const std::string& shadowed_key,
+                             const std::string& data, size_t chunk_size)
+{
+    aes_encryption_stream stream(ctx);
+    stream.start(shadowed_key);
+
+    std::vector<std::string> chunks;
+    for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+        chunks.emplace_back(data.substr(offset, chunk_size));
+
+    size_t calls = 0;
+    auto allocations = allocations_count();
+    stopwatch sw;
+    for (auto&& chunk : chunks)
+    {
+        auto cipher_chunk = stream.encrypt(chunk);
+        ++calls;
+    }
+    auto seconds = sw.seconds();
+    allocations = allocations_count() - allocations;
+    stream.finalize();
+
+    print_result("encrypt(std::string), chunk " + std::to_string(chunk_size),
+                 data.size(), seconds, static_cast<double>(allocations) / calls);
+}
+
+void benchmark_buffer_chunks(const context& ctx, const std::string& shadowed_key,
+                             const std::string& data, size_t chunk_size)
+{
+    aes_encryption_stream stream(ctx);
+    stream.start(shadowed_key);
+
+    std::vector<char> cipher_chunk(chunk_size);
+
+    size_t calls = 0;
+    auto allocations = allocations_count();
+    stopwatch sw;
+    for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+    {
+        auto len = std::min(chunk_size, data.size() - offset);
+        stream.encrypt(data.data() + offset, len, cipher_chunk.data());
+        ++calls;
+    }
+    auto seconds = sw.seconds();
+    allocations = allocations_count() - allocations;
+    stream.finalize();
+
+    print_result("encrypt(const char*, size_t, char*), chunk " + std::to_string(chunk_size),
+                 data.size(), seconds, static_cast<double>(allocations) / calls);
+}
+
+// Whole payload with separate output buffer vs. in place
+void benchmark_payload(const context& ctx, const std::string& shadowed_key, std::string data)
+{
+    aes_encryption_stream stream(ctx);
+
+    {
+        stream.start(shadowed_key);
+
+        stopwatch sw;
+        std::vector<char> cipher_data(data.size());
+        stream.encrypt(data.data(), data.size(), cipher_data.data());
+        auto seconds = sw.seconds();
+        stream.finalize();
+
+        print_result("encrypt(const char*, size_t, char*), payload", data.size(), seconds, 1);
+    }
+
+    {
+        stream.start(shadowed_key);
+
+        stopwatch sw;
+        stream.encrypt_in_place(&data[0], data.size());
+        auto seconds = sw.seconds();
+        stream.finalize();
+
+        print_result("encrypt_in_place, payload", data.size(), seconds, 0);
+    }
+}
+
+// create_sha256 and encryption (two passes over memory) vs. fused digest
+void benchmark_digest(const context& ctx, const std::string& shadowed_key, const std::string& data)
+{
+    aes_encryption_stream stream(ctx);
+    std::vector<char> cipher_data(data.size());
+
+    {
+        stream.start(shadowed_key);
+
+        stopwatch sw;
+        auto digest = create_sha256(data);
+        stream.encrypt(data.data(), data.size(), cipher_data.data());
+        auto seconds = sw.seconds();
+        stream.finalize();
+
+        print_result("create_sha256 + encrypt, payload", data.size(), seconds, 0);
+    }
+
+    {
+        stream.set_digest(AES_DIGEST_sha256);
+        stream.start(shadowed_key);
+
+        std::string digest;
+        stopwatch sw;
+        stream.encrypt(data.data(), data.size(), cipher_data.data());
+        stream.finalize(digest);
+        auto seconds = sw.seconds();
+
+        print_result("encrypt with AES_DIGEST_sha256, payload", data.size(), seconds, 0);
+    }
+}
+
+// to_base64(encrypted data) with whole intermediate strings vs. pipeline by blocks
+void benchmark_pipeline(const context& ctx, const std::string& shadowed_key, const std::string& data)
+{
+    {
+        aes_encryption_stream stream(ctx);
+        stream.start(shadowed_key);
+
+        stopwatch sw;
+        auto cipher_data = stream.encrypt(data);
+        cipher_data += aes_to_string(stream.finalize());
+        auto result = to_base64(cipher_data);
+        auto seconds = sw.seconds();
+
+        print_result("to_base64(encrypt), payload", data.size(), seconds, 0);
+    }
+
+    {
+        std::string result;
+        result.reserve((data.size() + aes_size<aes_tag_type>()) / 3 * 4 + 4);
+
+        stopwatch sw;
+        string_sink sink(result);
+        base64_encoding_stage base64(sink);
+        aes_encrypting_stage encryption(ctx, base64, shadowed_key);
+        pipe(data, encryption);
+        auto seconds = sw.seconds();
+
+        print_result("aes_encrypting_stage -> base64_encoding_stage, payload", data.size(), seconds, 0);
+    }
+}
+
+template <typename key_type>
+void benchmark_short_sessions(const context& ctx, const key_type& key, const std::string& name,
+                              size_t sessions, size_t message_size)
+{
+    aes_encryption_stream stream(ctx);
+
+    auto message = create_benchmark_data(message_size);
+    std::vector<char> cipher_message(message_size);
+
+    auto allocations = allocations_count();
+    stopwatch sw;
+    for (size_t ci = 0; ci < sessions; ++ci)
+    {
+        stream.start(key);
+        stream.encrypt(message.data(), message.size(), cipher_message.data());
+        stream.finalize();
+    }
+    auto seconds = sw.seconds();
+    allocations = allocations_count() - allocations;
+
+    print_result(name + ", message " + std::to_string(message_size),
+                 sessions * message_size, seconds, static_cast<double>(allocations) / sessions);
+}
+
+} // namespace
+
+int main()
+{
+    auto& ctx = default_context_with_crypto_api();
+
+    std::string key { "Benchmark Key" };
+    auto shadowed_key = nxor_encode(key);
+
+    auto data = create_benchmark_data(64 * 1024 * 1024);
+
+    for (size_t chunk_size : { 1024, 16 * 1024, 256 * 1024 })
+    {
+        benchmark_string_chunks(ctx, shadowed_key, data, chunk_size);
+        benchmark_buffer_chunks(ctx, shadowed_key, data, chunk_size);
+    }
+
+    benchmark_payload(ctx, shadowed_key, data);
+    benchmark_digest(ctx, shadowed_key, data);
+    benchmark_pipeline(ctx, shadowed_key, data);
+
+    benchmark_short_sessions(ctx, shadowed_key, "session with shadowed key", 100000, 64);
+    benchmark_short_sessions(ctx, prepared_aes_key(ctx, shadowed_key), "session with prepared key", 100000, 64);
+
+    return 0;
+}
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <ssl_helpers/buffer_view.h>
 #include <ssl_helpers/encoding.h>
 #include <ssl_helpers/hash.h>
 #include <ssl_helpers/utils.h>
 #include <ssl_helpers/random.h>
 #include <ssl_helpers/shadowing.h>
 #include <ssl_helpers/crypto.h>
+#include <ssl_helpers/crypto_container.h>
+#include <ssl_helpers/crypto_streambuf.h>
+#include <ssl_helpers/crypto_session_pool.h>
+#include <ssl_helpers/crypto_record.h>
+#include <ssl_helpers/data_pipeline.h>
 #include <ssl_helpers/dh.h>
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace ssl_helpers {
+
+// Piece of scattered data (like iovec) to process fragmented data
+// (header, body, trailer, etc.) where it is without joining to one string.
+// Array of pieces is processed as one contiguous data:
+//
+//     buffer_view message[] = { header, { body, body_size }, trailer };
+//     auto hash = create_sha256_from_buffers(message, 3);
+//
+
+struct buffer_view
+{
+    buffer_view() = default;
+    buffer_view(const char* data_, size_t size_)
+        : data(data_)
+        , size(size_)
+    {
+    }
+    buffer_view(const std::string& str)
+        : data(str.data())
+        , size(str.size())
+    {
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+// Piece of scattered data for in place processing.
+
+struct mutable_buffer_view
+{
+    mutable_buffer_view() = default;
+    mutable_buffer_view(char* data_, size_t size_)
+        : data(data_)
+        , size(size_)
+    {
+    }
+    mutable_buffer_view(std::string& str)
+        : data(&str[0])
+        , size(str.size())
+    {
+    }
+
+    char* data = nullptr;
+    size_t size = 0;
+};
+
+} // namespace ssl_helpers
@@ -47,6 +47,77 @@ public:
      */
     config& set_ec_domain_group(const EC_GROUP_DOMAIN);
 
+    enum AEAD_CIPHER : char
+    {
+        // AES-256-GCM - Default. The fastest with AES instructions (AES-NI, ARMv8 CE)
+        AEAD_CIPHER_aes256_gcm = 0,
+        // AES-128-GCM - For traffic that doesn't require 256 bit key
+        AEAD_CIPHER_aes128_gcm,
+        // ChaCha20-Poly1305 - The fastest without AES instructions
+        AEAD_CIPHER_chacha20_poly1305,
+        // The fastest of 256 bit key ciphers (AES-256-GCM or ChaCha20-Poly1305)
+        // for host. It is selected at context initialization
+        AEAD_CIPHER_auto
+    };
+
+    /**
+     * AEAD cipher for AES256-GCM streams (aes_encryption_stream,
+     * aes_decryption_stream, streambufs, pipeline stages), aes_*_parallel,
+     * aes_*_gcm_batch and segmented container (aes_container_*,
+     * aes_encrypt_file). Cipher is stored in container header so container
+     * decryption doesn't depend on it. Streams, parallel and batch data
+     * don't keep cipher so both sides should set the same cipher explicitly,
+     * auto mode is not applied to them (they are AES-256-GCM) because
+     * selected cipher depends on host. Every cipher takes own key derived
+     * from the key.
+     */
+    config& set_aead_cipher(const AEAD_CIPHER);
+
+    enum COMPRESSION : char
+    {
+        // Data are encrypted as is - Default
+        COMPRESSION_none = 0,
+        // zlib (deflate) - For text data (JSON, logs) if library
+        // is built with zlib (SSL_HELPERS_WITH_ZLIB)
+        COMPRESSION_zlib
+    };
+
+    /**
+     * Compression of plain data before encryption for AES256-GCM
+     * segmented container (aes_container_*, aes_encrypt_file).
+     * Compression is stored in container header so decryption
+     * doesn't depend on this option.
+     */
+    config& set_compression(const COMPRESSION);
+
+    static bool is_supported_compression(const COMPRESSION);
+
+    enum PBKDF2_PRF : char
+    {
+        // HMAC-SHA1 - Default. Compatible with previous versions
+        PBKDF2_PRF_sha1 = 0,
+        // HMAC-SHA256
+        PBKDF2_PRF_sha256,
+        // HMAC-SHA512
+        PBKDF2_PRF_sha512
+    };
+
+    /**
+     * PBKDF2 for salted keys (aes_create_salted_key, aes_get_salted_key
+     * with context and Flip/Flap). Both sides should use the same
+     * settings. Default is HMAC-SHA1 with 8192 iterations.
+     */
+    config& set_pbkdf2_prf(const PBKDF2_PRF);
+    config& set_pbkdf2_iterations(int iterations);
+
+    /**
+     * Size (entries) of salted key cache in context to skip repeated
+     * PBKDF2 derivation of the same key and salt (aes_get_salted_key
+     * with context, aes_decrypt_flip). Cache is disabled by default (0).
+     * It is created at context initialization.
+     */
+    config& set_salted_key_cache_size(size_t sz);
+
     size_t file_buffer_size() const
     {
         return _file_buffer_size;
@@ -62,10 +133,47 @@ public:
         return _ec_group_domain;
     }
 
+    AEAD_CIPHER aead_cipher() const
+    {
+        return _aead_cipher;
+    }
+
+    // Cipher for data without header (streams, aes_*_parallel, aes_*_gcm_batch)
+    AEAD_CIPHER headerless_aead_cipher() const
+    {
+        return _auto_aead_cipher ? AEAD_CIPHER_aes256_gcm : _aead_cipher;
+    }
+
+    COMPRESSION compression() const
+    {
+        return _compression;
+    }
+
+    size_t salted_key_cache_size() const
+    {
+        return _salted_key_cache_size;
+    }
+
+    PBKDF2_PRF pbkdf2_prf() const
+    {
+        return _pbkdf2_prf;
+    }
+
+    int pbkdf2_iterations() const
+    {
+        return _pbkdf2_iterations;
+    }
+
 private:
     size_t _file_buffer_size = 10 * 1024;
     bool _enabled_libcrypto_api = false;
     EC_GROUP_DOMAIN _ec_group_domain = EC_GROUP_DOMAIN_prime256v1;
+    AEAD_CIPHER _aead_cipher = AEAD_CIPHER_aes256_gcm;
+    bool _auto_aead_cipher = false;
+    COMPRESSION _compression = COMPRESSION_none;
+    size_t _salted_key_cache_size = 0;
+    PBKDF2_PRF _pbkdf2_prf = PBKDF2_PRF_sha1;
+    int _pbkdf2_iterations = 8192;
 };
 
 } // namespace ssl_helpers
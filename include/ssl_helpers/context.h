@@ -1,10 +1,16 @@
 #pragma once
 
+#include <memory>
+
 #include <ssl_helpers/config.h>
 
 
 namespace ssl_helpers {
 
+namespace impl {
+    class __salted_key_cache;
+}
+
 class context
 {
     friend class __internal_context;
@@ -13,6 +19,8 @@ protected:
     context(const config&);
 
 public:
+    ~context();
+
     static config configurate();
 
     static context& init(const config&);
@@ -25,8 +33,12 @@ public:
         return get_config();
     }
 
+    // Cache of salted keys (nullptr if it is disabled in config)
+    impl::__salted_key_cache* salted_key_cache() const;
+
 private:
     config _config;
+    std::unique_ptr<impl::__salted_key_cache> _salted_key_cache;
 };
 
 } // namespace ssl_helpers
@@ -18,20 +18,37 @@ namespace ssl_helpers {
 // ---------------------------------------------------------------------------------
 // aes_encryption_stream,
 // aes_decryption_stream
+// aes_encrypt_parallel
+// aes_decrypt_parallel
+// aes_encrypt_gcm_batch
+// aes_decrypt_gcm_batch
 // aes_encrypt_flip
 // aes_decrypt_flip
+// aes_decrypt_flip_batch
+// aes_flip_cipher_size
+// aes_flip_session_max_size
+// aes_flip_plain_size
+// aes_flip_encryption_stream
+// aes_flip_decryption_stream
 //
 // ---------------------------------------------------------------------------------
 // AES256-CBC
 // ---------------------------------------------------------------------------------
 // aes_encrypt
 // aes_decrypt
+// aes_cbc_cipher
+// aes_cbc_encryption_stream
+// aes_cbc_decryption_stream
+// aes_encrypt_batch
+// aes_decrypt_batch
 //
 // ---------------------------------------------------------------------------------
 // PBKDF2:
 // ---------------------------------------------------------------------------------
 // aes_create_salted_key
 // aes_get_salted_key
+// aes_get_salted_key_cache_stat
+// aes_clear_salted_key_cache
 //
 
 
@@ -61,6 +78,24 @@ namespace ssl_helpers {
 // both for encryption and decryption
 //
 
+// Key material derived from shadowed key once to start
+// many stream sessions without repeated key derivation.
+// Derived key is kept shadowed in memory.
+
+class prepared_aes_key
+{
+    friend class aes_encryption_stream;
+    friend class aes_decryption_stream;
+
+public:
+    prepared_aes_key(const context&, const std::string& shadowed_key);
+    ~prepared_aes_key();
+
+private:
+    std::shared_ptr<const impl::__prepared_aes_key> _impl;
+};
+
+
 // Create ecrypted data stream that additionally includes tag (TAG) of encrypted data
 // and optional marker that is AAD (Additional Authenticated Data).
 // The TAG is subsequently used during the decryption operation to ensure that
@@ -84,12 +119,40 @@ public:
     std::string start(const std::string& shadowed_key = {},
                       const std::string& aad = {});
 
+    // Start encryption session with prepared key.
+    std::string start(const prepared_aes_key& key,
+                      const std::string& aad = {});
+
     // Encrypt chunk of data
     std::string encrypt(const std::string& plain_chunk);
 
+    // Encrypt chunk of data to caller buffer without allocation.
+    // Cipher buffer should have at least 'len' bytes.
+    // Return size of encrypted data (it is equal to 'len').
+    size_t encrypt(const char* plain_chunk, size_t len, char* cipher_chunk);
+
+    // Encrypt chunk of data in place (buffer with plain data is overwritten
+    // by cipher data). Return size of encrypted data (it is equal to 'len').
+    size_t encrypt_in_place(char* buffer, size_t len);
+
+    // Encrypt scattered chunks of data (as one chunk) to caller buffer.
+    // Cipher buffer should have at least total size of chunks.
+    // Return size of encrypted data.
+    size_t encrypt(const buffer_view* plain_chunks, size_t count, char* cipher_chunk);
+
+    // Encrypt scattered chunks of data in place. Return size of encrypted data.
+    size_t encrypt_in_place(const mutable_buffer_view* buffers, size_t count);
+
     // Finalize encryption session and create tag.
     aes_tag_type finalize();
 
+    // Calculate digest of plain data (by the same pass over memory
+    // as encryption) for sessions started after this call.
+    void set_digest(AES_DIGEST type);
+
+    // Finalize encryption session and create tag and digest of plain data.
+    aes_tag_type finalize(std::string& plain_digest);
+
 private:
     std::unique_ptr<impl::__aes_encryption_stream> _impl;
 };
@@ -109,29 +172,138 @@ public:
     void start(const std::string& shadowed_key = {},
                const std::string& aad = {});
 
+    // Start decryption session with prepared key.
+    void start(const prepared_aes_key& key,
+               const std::string& aad = {});
+
     // Decrypt chunk of cipher data.
     std::string decrypt(const std::string& cipher_chunk);
 
+    // Decrypt chunk of cipher data to caller buffer without allocation.
+    // Plain buffer should have at least 'len' bytes.
+    // Return size of decrypted data (it is equal to 'len').
+    size_t decrypt(const char* cipher_chunk, size_t len, char* plain_chunk);
+
+    // Decrypt chunk of cipher data in place (buffer with cipher data is overwritten
+    // by plain data). Return size of decrypted data (it is equal to 'len').
+    size_t decrypt_in_place(char* buffer, size_t len);
+
+    // Decrypt scattered chunks of cipher data (as one chunk) to caller buffer.
+    // Plain buffer should have at least total size of chunks.
+    // Return size of decrypted data.
+    size_t decrypt(const buffer_view* cipher_chunks, size_t count, char* plain_chunk);
+
+    // Decrypt scattered chunks of cipher data in place. Return size of decrypted data.
+    size_t decrypt_in_place(const mutable_buffer_view* buffers, size_t count);
+
     // Finalize decryption session and check stream tag.
     void finalize(const aes_tag_type& tag);
 
     // Finalize decryption without check (for custom implementation)
     void finalize();
 
+    // Calculate digest of decrypted data (by the same pass over memory
+    // as decryption) for sessions started after this call.
+    void set_digest(AES_DIGEST type);
+
+    // Finalize decryption session, check stream tag (null tag is checked too)
+    // and get digest of plain data.
+    void finalize(const aes_tag_type& tag, std::string& plain_digest);
+
 private:
     std::unique_ptr<impl::__aes_decryption_stream> _impl;
 };
 
 
-// Improve crypto resistance by using PBKDF2.
-
-// Create random salt apply PBKDF2.
+// Encrypt data at once by several threads (threads_amount = 0 to use all
+// hardware threads). Result and tag are identical to aes_encryption_stream
+// session with the same key and AAD. AAD is not included to result.
+
+std::string aes_encrypt_parallel(const context&,
+                                 const std::string& plain_data,
+                                 const std::string& shadowed_key,
+                                 aes_tag_type& tag,
+                                 const std::string& aad = {},
+                                 size_t threads_amount = 0);
+
+// Cipher buffer should have at least 'len' bytes.
+// It can be the same as plain buffer (in-place encryption).
+size_t aes_encrypt_parallel(const context&,
+                            const char* plain_data, size_t len, char* cipher_data,
+                            const std::string& shadowed_key,
+                            aes_tag_type& tag,
+                            const std::string& aad = {},
+                            size_t threads_amount = 0);
+
+// Decrypt data (created by aes_encryption_stream or aes_encrypt_parallel)
+// at once by several threads and check tag.
+
+std::string aes_decrypt_parallel(const context&,
+                                 const std::string& cipher_data,
+                                 const std::string& shadowed_key,
+                                 const aes_tag_type& tag,
+                                 const std::string& aad = {},
+                                 size_t threads_amount = 0);
+
+// Plain buffer should have at least 'len' bytes. It is erased if tag is invalid.
+// It can be the same as cipher buffer (in-place decryption).
+size_t aes_decrypt_parallel(const context&,
+                            const char* cipher_data, size_t len, char* plain_data,
+                            const std::string& shadowed_key,
+                            const aes_tag_type& tag,
+                            const std::string& aad = {},
+                            size_t threads_amount = 0);
+
+
+// Encrypt many small messages at once with the same key. Cipher context
+// is set up once. Every message gets own nonce (stored before cipher data)
+// and tag (stored after cipher data) so messages can be decrypted separately.
+
+aes_batch_type aes_encrypt_gcm_batch(const context&,
+                                     const aes_batch_type& plain_batch,
+                                     const std::string& shadowed_key,
+                                     const std::string& aad = {});
+
+// Decrypt messages created by aes_encrypt_gcm_batch and check every tag.
+
+aes_batch_type aes_decrypt_gcm_batch(const context&,
+                                     const aes_batch_type& cipher_batch,
+                                     const std::string& shadowed_key,
+                                     const std::string& aad = {});
+
+
+// Improve crypto resistance by using PBKDF2 (key blocks are created
+// by several threads).
+
+// Create random salt apply PBKDF2 (config::set_pbkdf2_prf, set_pbkdf2_iterations).
+// Salted key is restored by aes_get_salted_key with context of the same settings.
 salted_key_type aes_create_salted_key(const context&, const std::string& key);
 
-// Apply PBKDF2 for input salt.
+// Apply PBKDF2 (HMAC-SHA1, 8192 iterations) for input salt.
+// Deprecated: it doesn't follow PBKDF2 settings of context so it restores
+// key of aes_create_salted_key for default settings only.
+[[deprecated("Use aes_get_salted_key with context")]]
 std::string aes_get_salted_key(const std::string& key, const std::string& salt);
+[[deprecated("Use aes_get_salted_key with context")]]
 std::string aes_get_salted_key(const std::string& key, const aes_salt_type& salt);
 
+// Apply PBKDF2 of context settings for input salt or take salted key
+// from context cache (config::set_salted_key_cache_size).
+std::string aes_get_salted_key(const context&, const std::string& key, const std::string& salt);
+std::string aes_get_salted_key(const context&, const std::string& key, const aes_salt_type& salt);
+
+struct salted_key_cache_stat
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t size = 0;
+};
+
+// Get statistic of context cache (empty if cache is disabled).
+salted_key_cache_stat aes_get_salted_key_cache_stat(const context&);
+
+void aes_clear_salted_key_cache(const context&);
+
 // Encrypt data at once.
 
 std::string aes_encrypt(const context&, const std::string& plain_data, const std::string& key);
@@ -153,6 +325,123 @@ std::string aes_decrypt(const context&,
                         const std::string& check_tag,
                         std::function<std::string(const std::string& key, const std::string& cipher_data)> create_check_tag);
 
+// Encrypt-then-MAC with built-in HMAC-SHA256 of cipher data. Tag is
+// calculated by the same pass as encryption. MAC key is derived from key.
+
+std::string aes_encrypt(const context&,
+                        const std::string& plain_data, const std::string& key,
+                        aes_hmac_tag_type& created_check_tag);
+
+// Check HMAC-SHA256 tag before decryption. Return empty data
+// if tag is invalid (as for custom check tag).
+
+std::string aes_decrypt(const context&,
+                        const std::string& cipher_data, const std::string& key,
+                        const aes_hmac_tag_type& check_tag);
+
+// Decrypt data at once by several threads (threads_amount = 0 to use all
+// hardware threads). Result is identical to aes_decrypt.
+
+std::string aes_decrypt(const context&,
+                        const std::string& cipher_data, const std::string& key,
+                        size_t threads_amount);
+
+// Cipher for many messages with the same key. Every message is the same
+// as aes_encrypt result but key is hashed and cipher contexts are
+// set up once (only init value is reset for every message).
+// It is not thread safe.
+
+class aes_cbc_cipher
+{
+public:
+    aes_cbc_cipher(const context&, const std::string& key);
+    ~aes_cbc_cipher();
+
+    std::string encrypt(const std::string& plain_data);
+
+    // Cipher buffer should have at least 'len' + 16 bytes.
+    // Return size of encrypted data.
+    size_t encrypt(const char* plain_data, size_t len, char* cipher_data);
+
+    std::string decrypt(const std::string& cipher_data);
+
+    // Plain buffer should have at least 'len' bytes.
+    // Return size of decrypted data.
+    size_t decrypt(const char* cipher_data, size_t len, char* plain_data);
+
+private:
+    std::unique_ptr<impl::aes_block_session> _encryptor;
+    std::unique_ptr<impl::aes_block_session> _decryptor;
+};
+
+
+// Encrypt data by chunks. Joined result of encrypt() and finalize() calls
+// is identical to aes_encrypt result. Result of chunk can be
+// shorter (up to one block is kept till the next chunk or finalize).
+
+class aes_cbc_encryption_stream
+{
+public:
+    aes_cbc_encryption_stream(const context&);
+    ~aes_cbc_encryption_stream();
+
+    // Start encryption session.
+    void start(const std::string& key);
+
+    // Encrypt chunk of data
+    std::string encrypt(const std::string& plain_chunk);
+
+    // Encrypt chunk of data to caller buffer without allocation.
+    // Cipher buffer should have at least 'len' + 16 bytes.
+    // Return size of encrypted data.
+    size_t encrypt(const char* plain_chunk, size_t len, char* cipher_chunk);
+
+    // Finalize encryption session (add padding) and get the last cipher data.
+    std::string finalize();
+
+private:
+    std::unique_ptr<impl::aes_block_stream> _impl;
+};
+
+
+// Decrypt aes_encrypt (or aes_cbc_encryption_stream) data by chunks.
+
+class aes_cbc_decryption_stream
+{
+public:
+    aes_cbc_decryption_stream(const context&);
+    ~aes_cbc_decryption_stream();
+
+    // Start decryption session.
+    void start(const std::string& key);
+
+    // Decrypt chunk of cipher data.
+    std::string decrypt(const std::string& cipher_chunk);
+
+    // Decrypt chunk of cipher data to caller buffer without allocation.
+    // Plain buffer should have at least 'len' + 16 bytes.
+    // Return size of decrypted data.
+    size_t decrypt(const char* cipher_chunk, size_t len, char* plain_chunk);
+
+    // Finalize decryption session (check and remove padding)
+    // and get the last plain data.
+    std::string finalize();
+
+private:
+    std::unique_ptr<impl::aes_block_stream> _impl;
+};
+
+// Encrypt many messages at once with the same key. Every message is
+// the same as aes_encrypt result but cipher context is set up once.
+
+aes_batch_type aes_encrypt_batch(const context&,
+                                 const aes_batch_type& plain_batch, const std::string& key);
+
+// Decrypt many messages at once with the same key.
+
+aes_batch_type aes_decrypt_batch(const context&,
+                                 const aes_batch_type& cipher_batch, const std::string& key);
+
 // 'Flip/Flap' technique to transfer both encrypted data and key through unencrypted network.
 // Idea is suppose data are transferred by three chunks separated in time
 // and useless individually.
@@ -185,4 +474,101 @@ std::string aes_decrypt_flip(const context&,
                              const std::string& instant_key,
                              const std::string& marker = {});
 
+// Decrypt many flip sessions at once by several threads (threads_amount = 0
+// to use all hardware threads). Instant keys are given for every session
+// or one key is for all sessions. Results are in order of sessions.
+// Failed session doesn't break batch (see result status). Every worker
+// derives salted keys by own thread only.
+
+std::vector<flip_batch_result_type> aes_decrypt_flip_batch(const context&,
+                                                           const std::vector<flip_session_type>& sessions,
+                                                           const std::vector<std::string>& instant_keys,
+                                                           const std::string& marker = {},
+                                                           size_t threads_amount = 0);
+
+// Flip/Flap to caller buffers without intermediate copies.
+// Buffers should have at least aes_flip_cipher_size,
+// aes_flip_session_max_size (returns actual session size)
+// and aes_flip_plain_size bytes accordingly.
+
+size_t aes_flip_cipher_size(size_t plain_len, const std::string& marker = {});
+size_t aes_flip_session_max_size(const std::string& marker = {});
+size_t aes_flip_plain_size(size_t cipher_len, const std::string& marker = {});
+
+size_t aes_encrypt_flip(const context&,
+                        const char* plain_data, size_t len,
+                        const std::string& instant_key,
+                        char* cipher_data, char* session_data,
+                        const std::string& marker = {},
+                        bool add_garbage = true);
+
+size_t aes_decrypt_flip(const context&,
+                        const char* cipher_data, size_t cipher_len,
+                        const char* session_data, size_t session_len,
+                        const std::string& instant_key,
+                        char* plain_data,
+                        const std::string& marker = {});
+
+
+// Flip by chunks for data that should not be collected in memory.
+// Cipher data is the result of start() and all encrypt() calls
+// (the same as aes_encrypt_flip cipher data). Session data
+// is created at the end.
+
+class aes_flip_encryption_stream
+{
+public:
+    aes_flip_encryption_stream(const context&,
+                               const std::string& marker = {},
+                               bool add_garbage = true);
+    ~aes_flip_encryption_stream();
+
+    // Start encryption session. Return head of cipher data.
+    std::string start(const std::string& instant_key);
+
+    // Encrypt chunk of data
+    std::string encrypt(const std::string& plain_chunk);
+
+    // Encrypt chunk of data to caller buffer without allocation.
+    // Cipher buffer should have at least 'len' bytes.
+    size_t encrypt(const char* plain_chunk, size_t len, char* cipher_chunk);
+
+    // Finalize encryption session and create session data.
+    std::string finalize();
+
+private:
+    std::unique_ptr<impl::__aes_flip_encryption_stream> _impl;
+};
+
+
+// Flap by chunks. Cipher data can be split anyhow.
+// Plain data are returned before check (in finalize)
+// like for aes_decryption_stream.
+
+class aes_flip_decryption_stream
+{
+public:
+    aes_flip_decryption_stream(const context&,
+                               const std::string& marker = {});
+    ~aes_flip_decryption_stream();
+
+    // Start decryption session.
+    void start(const std::string& session_data,
+               const std::string& instant_key);
+
+    // Decrypt chunk of cipher data.
+    std::string decrypt(const std::string& cipher_chunk);
+
+    // Decrypt chunk of cipher data to caller buffer without allocation.
+    // Plain buffer should have at least 'len' bytes.
+    // Return size of decrypted data (it is less than 'len' for the head of cipher data).
+    size_t decrypt(const char* cipher_chunk, size_t len, char* plain_chunk);
+
+    // Finalize decryption session and check data.
+    void finalize();
+
+private:
+    std::unique_ptr<impl::__aes_flip_decryption_stream> _impl;
+};
+
 } // namespace ssl_helpers
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <functional>
+#include <memory>
+
+#include <ssl_helpers/context.h>
+
+#include "crypto_types.h"
+
+
+namespace ssl_helpers {
+
+// ---------------------------------------------------------------------------------
+// AES256-GCM segmented container
+// ---------------------------------------------------------------------------------
+// aes_container_encryptor
+// aes_container_decryptor
+// aes_container_encrypt
+// aes_container_decrypt
+// aes_container_decrypt_range
+// aes_encrypt_file
+// aes_decrypt_file
+//
+
+// Container for large data with random access. Plain data is split
+// to fixed size segments and every segment is encrypted with own nonce
+// (random prefix from header + segment counter + last segment flag)
+// and has own tag. Segments key is derived from key and random salt
+// from header so containers with the same key don't share keys.
+// Header is authenticated as AAD of every segment.
+// Segment positions are calculated from segment size (stored in header)
+// so any byte range can be decrypted and authenticated by segments
+// that cover it only. Cipher is config::aead_cipher() (AES-256-GCM by default),
+// it is stored in header so decryption follows it.
+// If config::compression() is set plain data are compressed before
+// splitting to segments (compression is stored in header too and data
+// are decompressed after decryption). Compressed container has
+// no random access (plain_size, decrypt_range are not available).
+// Container (from top down to bottom):
+//
+//     |Header (binary with aes_container_header_size() size)|
+//     |Encrypted segment 0 (segment size)|TAG|
+//     ...
+//     |Encrypted last segment (up to segment size)|TAG|
+//
+
+// Size of container header.
+size_t aes_container_header_size();
+
+// Default plain data size of segment.
+size_t aes_container_default_segment_size();
+
+// Read 'len' bytes of container from 'offset' (from container beginning)
+// to the buffer. Return amount of read bytes.
+using aes_container_reader_type = std::function<size_t(uint64_t offset, char* buffer, size_t len)>;
+
+
+// Create container by chunks.
+
+class aes_container_encryptor
+{
+public:
+    aes_container_encryptor(const context&,
+                            const std::string& shadowed_key,
+                            size_t segment_size = 0);
+    ~aes_container_encryptor();
+
+    // Start new container and return header.
+    std::string start();
+
+    // Encrypt chunk of data and return completed segments (if any).
+    // The last segment is held until finalize().
+    std::string encrypt(const std::string& plain_chunk);
+
+    // Finalize container and return the last segment.
+    std::string finalize();
+
+private:
+    std::unique_ptr<impl::__aes_container_encryptor> _impl;
+};
+
+
+// Decrypt container by chunks or read plain data ranges.
+
+class aes_container_decryptor
+{
+public:
+    aes_container_decryptor(const context&,
+                            const std::string& shadowed_key);
+    ~aes_container_decryptor();
+
+    // Start decryption with container header.
+    void start(const std::string& header);
+
+    size_t segment_size() const;
+
+    // Size of plain data for container with 'container_size' size (including header).
+    // Not available for compressed container.
+    uint64_t plain_size(uint64_t container_size) const;
+
+    // Decrypt chunk of container data (after header) and return
+    // decrypted segments (if any). The last segment is held until finalize().
+    std::string decrypt(const std::string& cipher_chunk);
+
+    // Finalize decryption and return the last segment.
+    std::string finalize();
+
+    // Decrypt plain data range [offset, offset + len) by reading only
+    // segments that cover range.
+    std::string decrypt_range(const aes_container_reader_type& read,
+                              uint64_t container_size,
+                              uint64_t offset, size_t len);
+
+private:
+    std::unique_ptr<impl::__aes_container_decryptor> _impl;
+};
+
+
+// Create container at once by several threads (threads_amount = 0 to use
+// all hardware threads).
+
+std::string aes_container_encrypt(const context&,
+                                  const std::string& plain_data,
+                                  const std::string& shadowed_key,
+                                  size_t segment_size = 0,
+                                  size_t threads_amount = 0);
+
+// Decrypt container at once by several threads.
+
+std::string aes_container_decrypt(const context&,
+                                  const std::string& container_data,
+                                  const std::string& shadowed_key,
+                                  size_t threads_amount = 0);
+
+// Decrypt plain data range of container at once.
+
+std::string aes_container_decrypt_range(const context&,
+                                        const std::string& container_data,
+                                        const std::string& shadowed_key,
+                                        uint64_t offset, size_t len);
+
+
+// Progress of file processing (plain data bytes or compressed data
+// bytes for decryption of compressed container). Return false to cancel.
+using aes_file_progress_type = std::function<bool(uint64_t processed, uint64_t total)>;
+
+// Encrypt file to container with config::file_buffer_size() segment size.
+// Reading, encryption and writing run at the same time over a few
+// buffers so memory doesn't depend on file size.
+// Return false if cancelled (output file is removed).
+
+bool aes_encrypt_file(const context&,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      const aes_file_progress_type& progress = {});
+
+// Encrypt file and calculate digest of plain data by the same pass.
+
+bool aes_encrypt_file(const context&,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      AES_DIGEST digest,
+                      std::string& plain_digest,
+                      const aes_file_progress_type& progress = {});
+
+// Decrypt container file (every segment is authenticated before writing).
+// Return false if cancelled (output file is removed).
+
+bool aes_decrypt_file(const context&,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      const aes_file_progress_type& progress = {});
+
+// Decrypt file and calculate digest of decrypted data by the same pass.
+
+bool aes_decrypt_file(const context&,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      AES_DIGEST digest,
+                      std::string& plain_digest,
+                      const aes_file_progress_type& progress = {});
+
+} // namespace ssl_helpers
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <functional>
+#include <memory>
+
+#include <ssl_helpers/context.h>
+
+#include "crypto_types.h"
+
+
+namespace ssl_helpers {
+
+// ---------------------------------------------------------------------------------
+// AES256-GCM records
+// ---------------------------------------------------------------------------------
+// aes_record_sealer
+// aes_record_opener
+//
+
+// Many messages (records) with the same key by one keyed cipher context.
+// Every record is framed as:
+//
+//     |Length of encrypted data (4 bytes, big-endian)|
+//     |Encrypted data (binary)|
+//     |TAG (binary with 16 size)|
+//
+// Every sealer creates random salt and record key and init value are
+// derived from key and this salt, so sealers with the same key (both
+// directions of connection, reconnects, other peers) never share nonces.
+// Salt is not secret and it should be passed to opener (like handshake)
+// before records.
+//
+// Nonce of record is derived init value XOR 64-bit record sequence number.
+// Sequence is not transferred: opener should get records in the same order
+// as sealer has created them (like TLS records). Length field is
+// authenticated as AAD.
+//
+
+// Size of frame for plain data with 'len' size.
+size_t aes_record_frame_size(size_t len);
+
+// Called for every opened record with its plain data
+// (it points to the receive buffer).
+using aes_record_handler_type = std::function<void(const char* plain_data, size_t len)>;
+
+
+class aes_record_sealer
+{
+public:
+    aes_record_sealer(const context&, const std::string& shadowed_key);
+    ~aes_record_sealer();
+
+    // Create record frame.
+    std::string seal(const std::string& plain_data);
+
+    // Create record frame in caller buffer without allocation.
+    // Frame buffer should have at least aes_record_frame_size('len') bytes.
+    // Return size of frame.
+    size_t seal(const char* plain_data, size_t len, char* frame, size_t frame_capacity);
+
+    // Sequence number of next record.
+    uint64_t sequence() const;
+
+    // Random salt of this sealer for opener.
+    aes_salt_type salt() const;
+
+private:
+    std::unique_ptr<impl::__aes_record_sealer> _impl;
+};
+
+
+//     aes_record_opener opener(ctx, shadowed_key, salt_from_peer);
+//     ...
+//     received += socket.read(buffer + received, capacity - received);
+//     auto consumed = opener.open_in_place(buffer, received, [&](const char* data, size_t len) {
+//         process(data, len);
+//     });
+//     std::memmove(buffer, buffer + consumed, received - consumed);
+//     received -= consumed;
+//
+
+class aes_record_opener
+{
+public:
+    // Salt is aes_record_sealer::salt of the peer sealer.
+    aes_record_opener(const context&, const std::string& shadowed_key, const aes_salt_type& salt);
+    ~aes_record_opener();
+
+    // Open one record frame.
+    std::string open(const std::string& frame);
+
+    // Open one record frame to caller buffer without allocation
+    // (it can be 'frame' + 4 to decrypt in place).
+    // Plain buffer should have at least 'len' - 20 bytes.
+    // Return size of plain data.
+    size_t open(const char* frame, size_t len, char* plain_data);
+
+    // Open all complete records from receive buffer. Records are decrypted
+    // in place and 'handler' gets plain data of every record in order.
+    // Return size of processed frames (incomplete frame at the end
+    // is left for next call).
+    size_t open_in_place(char* buffer, size_t len, const aes_record_handler_type& handler);
+
+    // Sequence number of next record.
+    uint64_t sequence() const;
+
+private:
+    std::unique_ptr<impl::__aes_record_opener> _impl;
+};
+
+} // namespace ssl_helpers
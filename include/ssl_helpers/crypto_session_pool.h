@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+#include <memory>
+
+#include <ssl_helpers/context.h>
+
+#include "crypto_types.h"
+
+
+namespace ssl_helpers {
+
+// ---------------------------------------------------------------------------------
+// AES256-GCM session pool
+// ---------------------------------------------------------------------------------
+// aes_session_pool
+//
+
+// Many concurrent AES256-GCM sessions with the same key. Every session
+// is started with own 96-bit nonce (it must be unique for the key)
+// and it produces standard AES256-GCM cipher data and tag.
+// Key is derived from shadowed key like aes_encryption_stream does.
+//
+// Session is addressed by small handle and it keeps only compact state
+// in the pool (aes_session_pool::session_size() bytes) instead of
+// own key and AAD copies and heap stream object. Open session holds
+// cipher context that is keyed once for the pool: it is taken from
+// free list and it is returned there when session is finalized or closed
+// (up to 'contexts_amount' free contexts are kept, 0 - hardware threads
+// amount), so key schedule and allocation are not repeated per session.
+// Pool is thread safe but one session should be processed by one thread
+// at a time.
+//
+//     aes_session_pool pool(ctx, shadowed_key);
+//     auto session = pool.open_encryption(aad);
+//     auto nonce = pool.nonce(session);
+//     auto cipher_data = pool.encrypt(session, chunk1);
+//     cipher_data += pool.encrypt(session, chunk2);
+//     auto tag = pool.finalize_encryption(session);
+//
+
+class aes_session_pool
+{
+public:
+    aes_session_pool(const context&,
+                     const std::string& shadowed_key,
+                     size_t contexts_amount = 0);
+    ~aes_session_pool();
+
+    // Start encryption session with random nonce.
+    aes_session_handle open_encryption(const std::string& aad = {});
+
+    // Start encryption session with caller nonce.
+    aes_session_handle open_encryption(const aes_nonce_type& nonce,
+                                       const std::string& aad = {});
+
+    // Start decryption session.
+    aes_session_handle open_decryption(const aes_nonce_type& nonce,
+                                       const std::string& aad = {});
+
+    // Nonce of started session.
+    aes_nonce_type nonce(const aes_session_handle&) const;
+
+    // Encrypt chunk of data.
+    std::string encrypt(const aes_session_handle&, const std::string& plain_chunk);
+
+    // Encrypt chunk of data to caller buffer (it can be the same as plain one).
+    // Return size of encrypted data (it is equal to 'len').
+    size_t encrypt(const aes_session_handle&, const char* plain_chunk, size_t len, char* cipher_chunk);
+
+    // Decrypt chunk of cipher data.
+    std::string decrypt(const aes_session_handle&, const std::string& cipher_chunk);
+
+    // Decrypt chunk of cipher data to caller buffer (it can be the same as cipher one).
+    // Return size of decrypted data (it is equal to 'len').
+    size_t decrypt(const aes_session_handle&, const char* cipher_chunk, size_t len, char* plain_chunk);
+
+    // Finalize encryption session and create tag. Session is closed.
+    aes_tag_type finalize_encryption(const aes_session_handle&);
+
+    // Finalize decryption session and check tag. Session is closed
+    // even if tag is invalid.
+    void finalize_decryption(const aes_session_handle&, const aes_tag_type& tag);
+
+    // Close session without finalization.
+    void close(const aes_session_handle&);
+
+    // Amount of open sessions.
+    size_t sessions_amount() const;
+
+    // Memory of session states (open and recycled ones).
+    // Cipher contexts (of open sessions and free ones) are not included.
+    size_t memory_usage() const;
+
+    // Memory of one session state.
+    static size_t session_size();
+
+private:
+    std::unique_ptr<impl::__aes_session_pool> _impl;
+};
+
+} // namespace ssl_helpers
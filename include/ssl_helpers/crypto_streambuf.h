@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+#include <streambuf>
+#include <memory>
+#include <vector>
+
+#include <ssl_helpers/context.h>
+
+#include "crypto_types.h"
+
+
+namespace ssl_helpers {
+
+// ---------------------------------------------------------------------------------
+// AES256-GCM streambuf adapters
+// ---------------------------------------------------------------------------------
+// aes_encrypting_streambuf
+// aes_decrypting_streambuf
+//
+
+// Adapters that make std::ostream/std::istream encrypt or decrypt data on the fly.
+// Cipher data are the same as aes_encryption_stream creates (tag is not included).
+// Data are copied only once (between internal buffer and underlying streambuf).
+// Buffer size is config::file_buffer_size() if 'buffer_size' = 0.
+// Session requires at least one byte of data (as aes_encryption_stream does).
+// Encryption fails for good after write error of underlying streambuf
+// (cipher data are not complete).
+//
+//     std::ofstream file(path, std::ofstream::binary);
+//     aes_encrypting_streambuf buf(ctx, file.rdbuf(), shadowed_key);
+//     std::ostream out(&buf);
+//     out << data;
+//     auto tag = buf.finalize();
+//
+
+class aes_encrypting_streambuf : public std::streambuf
+{
+public:
+    aes_encrypting_streambuf(const context&,
+                             std::streambuf* sink,
+                             const std::string& shadowed_key,
+                             const std::string& aad = {},
+                             size_t buffer_size = 0);
+    ~aes_encrypting_streambuf() override;
+
+    // Write the rest of data to sink and finalize encryption session.
+    aes_tag_type finalize();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize len) override;
+    int sync() override;
+
+private:
+    void flush_buffer();
+    void write(const char* plain_data, size_t len);
+    void send(const char* cipher_data, size_t len);
+
+    std::unique_ptr<impl::__aes_encryption_stream> _impl;
+    std::streambuf* _sink = nullptr;
+    std::vector<char> _buffer;
+    // Write error (streambuf can't be used after it)
+    std::string _error;
+};
+
+
+// Decrypted data are available before finalize() but they are
+// authenticated only if finalize() succeeds. Read or decryption error
+// is thrown from the buffer (std::istream sets badbit), data decrypted
+// before error are returned first.
+//
+//     std::ifstream file(path, std::ifstream::binary);
+//     aes_decrypting_streambuf buf(ctx, file.rdbuf(), shadowed_key);
+//     std::istream in(&buf);
+//     std::string data { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+//     buf.finalize(tag);
+//
+
+class aes_decrypting_streambuf : public std::streambuf
+{
+public:
+    aes_decrypting_streambuf(const context&,
+                             std::streambuf* source,
+                             const std::string& shadowed_key,
+                             const std::string& aad = {},
+                             size_t buffer_size = 0);
+    ~aes_decrypting_streambuf() override;
+
+    // Finalize decryption session and check stream tag (null tag is checked too).
+    void finalize(const aes_tag_type& tag);
+
+protected:
+    int_type underflow() override;
+    std::streamsize xsgetn(char* data, std::streamsize len) override;
+
+private:
+    size_t read(char* plain_data, size_t len);
+
+    std::unique_ptr<impl::__aes_decryption_stream> _impl;
+    std::streambuf* _source = nullptr;
+    std::vector<char> _buffer;
+    // Error that is delayed to return data read before it
+    std::string _error;
+};
+
+} // namespace ssl_helpers
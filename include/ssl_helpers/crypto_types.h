@@ -1,7 +1,11 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include <ssl_helpers/buffer_view.h>
 
 
 namespace ssl_helpers {
@@ -9,9 +13,15 @@ namespace ssl_helpers {
 using aes_512bit_type = std::array<char, 64>;
 using aes_256bit_type = std::array<char, 32>;
 using aes_128bit_type = std::array<char, 16>;
+using aes_96bit_type = std::array<char, 12>;
 
 using aes_tag_type = aes_128bit_type;
 
+// HMAC-SHA256 of AES256-CBC cipher data
+using aes_hmac_tag_type = aes_256bit_type;
+
+using aes_nonce_type = aes_96bit_type;
+
 using aes_salt_type = aes_128bit_type;
 using salted_key_type = std::pair<std::string /*encryption key*/, aes_salt_type /*random salt*/>;
 
@@ -24,11 +34,91 @@ constexpr size_t aes_size()
     return _aes_type {}.size();
 }
 
+// Digest of plain data calculated by the same pass as encryption/decryption
+enum AES_DIGEST : char
+{
+    AES_DIGEST_none = 0,
+    AES_DIGEST_sha256,
+    AES_DIGEST_sha512,
+    AES_DIGEST_sha1,
+    AES_DIGEST_md5,
+    AES_DIGEST_ripemd160,
+};
+
 using flip_session_type = std::pair<std::string /*cipher data*/, std::string /*session key*/>;
 
+// Result of one flip session decryption in batch (aes_decrypt_flip_batch).
+struct flip_batch_result_type
+{
+    bool ok = false;
+    std::string plain_data;
+    // Reason if session is not decrypted
+    std::string error;
+};
+
+// Many messages in one contiguous buffer.
+// Message 'i' is [offsets[i], offsets[i + 1]) range of data.
+struct aes_batch_type
+{
+    std::string data;
+    std::vector<size_t> offsets { 0 };
+
+    size_t size() const
+    {
+        return offsets.size() - 1;
+    }
+
+    void add(const char* message, size_t len)
+    {
+        data.append(message, len);
+        offsets.push_back(data.size());
+    }
+
+    void add(const std::string& message)
+    {
+        add(message.data(), message.size());
+    }
+
+    const char* item_data(size_t i) const
+    {
+        return data.data() + offsets[i];
+    }
+
+    size_t item_size(size_t i) const
+    {
+        return offsets[i + 1] - offsets[i];
+    }
+
+    std::string item(size_t i) const
+    {
+        return data.substr(offsets[i], item_size(i));
+    }
+};
+
+// Session of aes_session_pool. Handle of closed session is invalid
+// (generation is changed when pool reuses session slot).
+struct aes_session_handle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
 namespace impl {
     class __aes_encryption_stream;
     class __aes_decryption_stream;
+    class __prepared_aes_key;
+    class __aes_container_encryptor;
+    class __aes_container_decryptor;
+    class __aes_session_pool;
+    class __aes_record_sealer;
+    class __aes_record_opener;
+    class __aes_flip_encryption_stream;
+    class __aes_flip_decryption_stream;
+    class aes_block_stream;
+    class aes_block_session;
+    class digest_encoder;
+    class data_compressor;
+    class data_decompressor;
 } // namespace impl
 
 } // namespace ssl_helpers
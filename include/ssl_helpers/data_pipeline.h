@@ -0,0 +1,332 @@
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <fstream>
+
+#include <ssl_helpers/context.h>
+
+#include "crypto_types.h"
+
+
+namespace ssl_helpers {
+
+// ---------------------------------------------------------------------------------
+// Data pipeline
+// ---------------------------------------------------------------------------------
+// pipeline_stage
+// aes_encrypting_stage
+// aes_decrypting_stage
+// aes_flip_encrypting_stage
+// aes_flip_decrypting_stage
+// compressing_stage
+// decompressing_stage
+// base64_encoding_stage
+// hex_encoding_stage
+// digest_stage
+// string_sink
+// file_sink
+// pipe
+// pipe_file
+//
+
+// Chain of stages where every stage transforms data by blocks and pushes
+// result to the next one. Whole data is never collected between stages
+// so memory is bounded by stage buffers (block size) and every block
+// passes all stages while it is hot in cache.
+// Stages are created from the end of chain:
+//
+//     file_sink sink(out_path);
+//     base64_encoding_stage base64(sink);
+//     aes_encrypting_stage encryption(ctx, base64, shadowed_key);
+//     pipe_file(ctx, in_path, encryption);
+//
+// instead of
+//
+//     to_base64(aes_encrypt(...))
+//
+
+// Default size of stage block.
+size_t pipeline_default_block_size();
+
+
+class pipeline_stage
+{
+public:
+    virtual ~pipeline_stage() = default;
+
+    // Push chunk of data (any size).
+    virtual void write(const char* data, size_t len) = 0;
+
+    // Push the rest of data to the next stage and finish it.
+    virtual void finish() = 0;
+};
+
+
+// AES256-GCM encryption (as aes_encryption_stream). TAG is written after
+// cipher data (this is data stream from aes_encryption_stream description
+// without AAD).
+
+class aes_encrypting_stage : public pipeline_stage
+{
+public:
+    aes_encrypting_stage(const context&,
+                         pipeline_stage& next,
+                         const std::string& shadowed_key,
+                         const std::string& aad = {},
+                         size_t block_size = 0);
+    ~aes_encrypting_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+    // Tag of finished encryption.
+    const aes_tag_type& tag() const
+    {
+        return _tag;
+    }
+
+private:
+    std::unique_ptr<impl::__aes_encryption_stream> _impl;
+    pipeline_stage& _next;
+    std::vector<char> _buffer;
+    aes_tag_type _tag;
+};
+
+
+// Decryption of aes_encrypting_stage result (TAG at the end of data).
+// Plain data are pushed before check. finish() throws exception
+// if tag is invalid.
+
+class aes_decrypting_stage : public pipeline_stage
+{
+public:
+    aes_decrypting_stage(const context&,
+                         pipeline_stage& next,
+                         const std::string& shadowed_key,
+                         const std::string& aad = {},
+                         size_t block_size = 0);
+    ~aes_decrypting_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    void decrypt(const char* data, size_t len);
+
+    std::unique_ptr<impl::__aes_decryption_stream> _impl;
+    pipeline_stage& _next;
+    std::vector<char> _buffer;
+    // The last received bytes that can be tag
+    std::string _tail;
+};
+
+
+// Flip encryption (as aes_flip_encryption_stream). Cipher data is pushed
+// to the next stage, session data is ready when stage is finished.
+
+class aes_flip_encrypting_stage : public pipeline_stage
+{
+public:
+    aes_flip_encrypting_stage(const context&,
+                              pipeline_stage& next,
+                              const std::string& instant_key,
+                              const std::string& marker = {},
+                              bool add_garbage = true,
+                              size_t block_size = 0);
+    ~aes_flip_encrypting_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+    // Session data of finished encryption.
+    const std::string& session_data() const
+    {
+        return _session_data;
+    }
+
+private:
+    // Marker is the head of cipher data
+    void write_head();
+
+    std::unique_ptr<impl::__aes_flip_encryption_stream> _impl;
+    pipeline_stage& _next;
+    std::vector<char> _buffer;
+    std::string _session_data;
+    bool _started = false;
+};
+
+
+// Flap decryption of cipher data with known session data.
+// Plain data are pushed before check. finish() throws exception
+// if data are not authentic.
+
+class aes_flip_decrypting_stage : public pipeline_stage
+{
+public:
+    aes_flip_decrypting_stage(const context&,
+                              pipeline_stage& next,
+                              const std::string& session_data,
+                              const std::string& instant_key,
+                              const std::string& marker = {},
+                              size_t block_size = 0);
+    ~aes_flip_decrypting_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    std::unique_ptr<impl::__aes_flip_decryption_stream> _impl;
+    pipeline_stage& _next;
+    std::vector<char> _buffer;
+};
+
+
+// Compression of data before encryption stage. Data stream:
+//
+//     |compression (config::COMPRESSION, 1)|Compressed data|
+//
+
+class compressing_stage : public pipeline_stage
+{
+public:
+    compressing_stage(config::COMPRESSION type,
+                      pipeline_stage& next);
+    ~compressing_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    void write_header();
+
+    std::unique_ptr<impl::data_compressor> _compressor;
+    pipeline_stage& _next;
+    bool _started = false;
+};
+
+
+// Decompression of compressing_stage result (after decryption stage).
+// Compression is taken from data stream.
+
+class decompressing_stage : public pipeline_stage
+{
+public:
+    decompressing_stage(pipeline_stage& next);
+    ~decompressing_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    std::unique_ptr<impl::data_decompressor> _decompressor;
+    pipeline_stage& _next;
+};
+
+
+// Base64 encoding (as to_base64).
+
+class base64_encoding_stage : public pipeline_stage
+{
+public:
+    base64_encoding_stage(pipeline_stage& next,
+                          size_t block_size = 0);
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    pipeline_stage& _next;
+    std::vector<char> _buffer;
+    // Bytes of incomplete 3-byte group
+    char _pending[2];
+    size_t _pending_len = 0;
+};
+
+
+// Hexadecimal encoding (as to_hex).
+
+class hex_encoding_stage : public pipeline_stage
+{
+public:
+    hex_encoding_stage(pipeline_stage& next,
+                       size_t block_size = 0);
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    pipeline_stage& _next;
+    std::vector<char> _buffer;
+};
+
+
+// Hash of data (as create_sha256, create_sha512, etc.).
+// Data are passed to the next stage as is if it is provided.
+
+class digest_stage : public pipeline_stage
+{
+public:
+    digest_stage(AES_DIGEST type,
+                 pipeline_stage* next = nullptr);
+    ~digest_stage() override;
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+    // Digest of finished data.
+    const std::string& digest() const
+    {
+        return _digest;
+    }
+
+private:
+    std::unique_ptr<impl::digest_encoder> _encoder;
+    pipeline_stage* _next = nullptr;
+    std::string _digest;
+};
+
+
+// Append data to string.
+
+class string_sink : public pipeline_stage
+{
+public:
+    string_sink(std::string& result);
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    std::string& _result;
+};
+
+
+// Write data to file.
+
+class file_sink : public pipeline_stage
+{
+public:
+    file_sink(const std::string& path);
+
+    void write(const char* data, size_t len) override;
+    void finish() override;
+
+private:
+    std::ofstream _output;
+};
+
+
+// Push data to the first stage by blocks and finish pipeline.
+
+void pipe(const std::string& data, pipeline_stage& first, size_t block_size = 0);
+
+// Push file data to the first stage (by config::file_buffer_size() blocks)
+// and finish pipeline.
+
+void pipe_file(const context&, const std::string& path, pipeline_stage& first);
+
+} // namespace ssl_helpers
@@ -3,6 +3,7 @@
 #include <string>
 
 #include <ssl_helpers/context.h>
+#include <ssl_helpers/buffer_view.h>
 
 
 namespace ssl_helpers {
@@ -19,6 +20,19 @@ std::string create_sha1(const std::string& data, const size_t limit = 0);
 
 std::string create_md5(const std::string& data, const size_t limit = 0);
 
+// Create hash from scattered data (as from joined data) and return
+// left bytes (or all by default)
+
+std::string create_ripemd160_from_buffers(const buffer_view* buffers, size_t count, const size_t limit = 0);
+
+std::string create_sha256_from_buffers(const buffer_view* buffers, size_t count, const size_t limit = 0);
+
+std::string create_sha512_from_buffers(const buffer_view* buffers, size_t count, const size_t limit = 0);
+
+std::string create_sha1_from_buffers(const buffer_view* buffers, size_t count, const size_t limit = 0);
+
+std::string create_md5_from_buffers(const buffer_view* buffers, size_t count, const size_t limit = 0);
+
 std::string create_ripemd160_from_file(const context&, const std::string& path, const size_t limit = 0);
 
 std::string create_sha256_from_file(const context&, const std::string& path, const size_t limit = 0);
@@ -31,10 +45,18 @@ std::string create_md5_from_file(const context&, const std::string& path, const
 
 
 // Password-Based Key Derivation Function 2 (PBKDF2) to create hash
-// from password to use like the key
+// from password to use like the key (HMAC-SHA1 by calling thread)
 
 std::string create_pbkdf2(const std::string& password, const std::string& salt, int iterations, int key_size);
 
+// PBKDF2 with chosen PRF. Output blocks (hash size of PRF) are independent
+// and they are created by several threads (threads_amount = 0 to use
+// all hardware threads) so wide key costs about one block time.
+// Use threads_amount = 1 if caller is already parallel.
+
+std::string create_pbkdf2(const std::string& password, const std::string& salt, int iterations, int key_size,
+                          config::PBKDF2_PRF prf, size_t threads_amount = 0);
+
 std::string create_pbkdf2_512(const std::string& password, const std::string& salt, const size_t limit = 0);
 
 } // namespace ssl_helpers
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 #include "ssl_helpers_defines.h"
 #include "aes256.h"
+#include "hmac.h"
 
 
 namespace ssl_helpers {
@@ -61,35 +66,182 @@ namespace impl {
         return to_string_impl<aes_128bit_type>(data);
     }
 
+    const EVP_CIPHER* get_aead_cipher(config::AEAD_CIPHER cipher)
+    {
+        switch (cipher)
+        {
+        case config::AEAD_CIPHER_aes256_gcm:
+            return EVP_aes_256_gcm();
+        case config::AEAD_CIPHER_aes128_gcm:
+            return EVP_aes_128_gcm();
+#ifndef OPENSSL_NO_CHACHA
+        case config::AEAD_CIPHER_chacha20_poly1305:
+            return EVP_chacha20_poly1305();
+#endif
+        default:;
+        }
+
+        SSL_HELPERS_ERROR("Unsupported cipher");
+        return NULL;
+    }
+
+    namespace {
+
+        // AES-256-GCM takes the key as is. Other ciphers take own key
+        // derived from it so one key is never used by different ciphers
+        // (AES-128-GCM takes the first half of derived key)
+        void get_cipher_key(config::AEAD_CIPHER cipher, const gcm_key_type& key, gcm_key_type& cipher_key)
+        {
+            if (cipher == config::AEAD_CIPHER_aes256_gcm)
+            {
+                cipher_key = key;
+                return;
+            }
+
+            static const std::string label { "AEAD cipher key" };
+            const char cipher_id = static_cast<char>(cipher);
+
+            hmac_sha256 kdf(key.data(), key.size());
+            kdf.write(label.data(), label.size());
+            kdf.write(&cipher_id, sizeof(cipher_id));
+            auto derived_key = kdf.result();
+
+            std::memcpy(cipher_key.data(), derived_key.data(), cipher_key.size());
+            OPENSSL_cleanse(derived_key.data(), derived_key.data_size());
+        }
+
+        // ChaCha20-Poly1305 takes 96-bit nonce (the left part of longer
+        // init value). GCM takes any init value
+        size_t get_iv_size(config::AEAD_CIPHER cipher, size_t init_value_len)
+        {
+            constexpr size_t CHACHA20_POLY1305_MAX_IV_SIZE = 12;
+
+            if (cipher == config::AEAD_CIPHER_chacha20_poly1305)
+                return std::min(init_value_len, CHACHA20_POLY1305_MAX_IV_SIZE);
+            return init_value_len;
+        }
+
+        double benchmark_aead_cipher(config::AEAD_CIPHER cipher)
+        {
+            constexpr size_t DATA_SIZE = 64 * 1024;
+            constexpr size_t ROUNDS = 8;
+
+            gcm_key_type key = {};
+            const char iv[12] = {};
+            std::vector<char> data(DATA_SIZE);
+            gcm_tag_type tag;
+
+            aes_stream_encryptor encryptor(cipher);
+
+            // The first round is warming up
+            auto started = std::chrono::steady_clock::now();
+            for (size_t round = 0; round <= ROUNDS; ++round)
+            {
+                if (round == 1)
+                    started = std::chrono::steady_clock::now();
+
+                encryptor.init(key, iv, sizeof(iv));
+                encryptor.process(data.data(), data.size(), data.data());
+                encryptor.finalize(tag);
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        }
+
+        config::AEAD_CIPHER benchmark_aead_ciphers()
+        {
+            config::AEAD_CIPHER result = config::AEAD_CIPHER_aes256_gcm;
+#ifndef OPENSSL_NO_CHACHA
+            try
+            {
+                if (benchmark_aead_cipher(config::AEAD_CIPHER_chacha20_poly1305) < benchmark_aead_cipher(config::AEAD_CIPHER_aes256_gcm))
+                    result = config::AEAD_CIPHER_chacha20_poly1305;
+            }
+            catch (std::exception&)
+            {
+                // Keep default if cipher is not provided
+            }
+#endif
+            return result;
+        }
+
+    } // namespace
+
+    config::AEAD_CIPHER select_fastest_aead_cipher()
+    {
+        static const config::AEAD_CIPHER selected = benchmark_aead_ciphers();
+        return selected;
+    }
+
+    aes_stream_encryptor::aes_stream_encryptor(config::AEAD_CIPHER cipher)
+        : _cipher(cipher)
+    {
+    }
+
     aes_stream_encryptor::~aes_stream_encryptor()
     {
         if (_ctx)
         {
             EVP_CIPHER_CTX_free(_ctx);
         }
+        OPENSSL_cleanse(_key.data(), _key.size());
     }
 
     void aes_stream_encryptor::init(const gcm_key_type& key, const gcm_iv_type& init_value)
     {
-        SSL_HELPERS_ASSERT(_ctx == nullptr, "Previous context should be deleted before");
+        init(key, init_value.data(), init_value.size());
+    }
 
-        _ctx = EVP_CIPHER_CTX_new();
+    void aes_stream_encryptor::init(const gcm_key_type& key, const char* init_value, size_t init_value_len)
+    {
+        SSL_HELPERS_ASSERT(init_value && init_value_len > 0, "Init value required");
 
-        SSL_HELPERS_ASSERT(_ctx != nullptr, ERR_error_string(ERR_get_error(), nullptr));
+        init_value_len = get_iv_size(_cipher, init_value_len);
 
-        auto cypher_init_result = (1 == EVP_EncryptInit_ex(_ctx, EVP_aes_256_gcm(), NULL, NULL, NULL));
-        SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+        if (!_ctx)
+        {
+            _ctx = EVP_CIPHER_CTX_new();
 
-        auto cypher_init_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_SET_IVLEN, aes_size<gcm_iv_type>(), NULL));
-        SSL_HELPERS_ASSERT(cypher_init_result_2, ERR_error_string(ERR_get_error(), nullptr));
+            SSL_HELPERS_ASSERT(_ctx != nullptr, ERR_error_string(ERR_get_error(), nullptr));
 
-        auto cypher_init_result_3 = (1 == EVP_EncryptInit_ex(_ctx, NULL, NULL, (unsigned char*)key.data(), (unsigned char*)init_value.data()));
+            auto cypher_init_result = (1 == EVP_EncryptInit_ex(_ctx, get_aead_cipher(_cipher), NULL, NULL, NULL));
+            SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+        }
+
+        if (_iv_len != init_value_len)
+        {
+            _iv_len = 0;
+
+            auto cypher_init_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_AEAD_SET_IVLEN, (int)init_value_len, NULL));
+            SSL_HELPERS_ASSERT(cypher_init_result_2, ERR_error_string(ERR_get_error(), nullptr));
+
+            _iv_len = init_value_len;
+        }
+
+        // Skip key expansion for the same key
+        gcm_key_type cipher_key;
+        const unsigned char* pkey = NULL;
+        if (!_key_set || CRYPTO_memcmp(_key.data(), key.data(), key.size()))
+        {
+            _key = key;
+            _key_set = true;
+            get_cipher_key(_cipher, _key, cipher_key);
+            pkey = (const unsigned char*)cipher_key.data();
+        }
+
+        _session = false;
+
+        auto cypher_init_result_3 = (1 == EVP_EncryptInit_ex(_ctx, NULL, NULL, pkey, (const unsigned char*)init_value));
+        OPENSSL_cleanse(cipher_key.data(), cipher_key.size());
+        if (!cypher_init_result_3)
+            _key_set = false;
         SSL_HELPERS_ASSERT(cypher_init_result_3, ERR_error_string(ERR_get_error(), nullptr));
+
+        _session = true;
     }
 
     void aes_stream_encryptor::set_aad(const char* aad, size_t len)
     {
-        SSL_HELPERS_ASSERT(_ctx != nullptr, "Context required");
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
         int len_ = 0;
 
@@ -99,7 +251,7 @@ namespace impl {
 
     size_t aes_stream_encryptor::process(const char* plain_chunk, size_t len, char* cipher_chunk)
     {
-        SSL_HELPERS_ASSERT(_ctx != nullptr, "Context required");
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
         int cipher_data_len = 0;
 
@@ -112,7 +264,7 @@ namespace impl {
 
     void aes_stream_encryptor::finalize(gcm_tag_type& tag)
     {
-        SSL_HELPERS_ASSERT(_ctx != nullptr, "Context required");
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
         int len_ = 0;
 
@@ -121,12 +273,15 @@ namespace impl {
 
         SSL_HELPERS_ASSERT(!len_);
 
-        auto cypher_fin_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_GET_TAG, aes_size<gcm_tag_type>(), tag.data()));
+        auto cypher_fin_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_AEAD_GET_TAG, aes_size<gcm_tag_type>(), tag.data()));
         SSL_HELPERS_ASSERT(cypher_fin_result_2, ERR_error_string(ERR_get_error(), nullptr));
 
-        EVP_CIPHER_CTX_free(_ctx);
+        _session = false;
+    }
 
-        _ctx = nullptr;
+    aes_stream_decryptor::aes_stream_decryptor(config::AEAD_CIPHER cipher)
+        : _cipher(cipher)
+    {
     }
 
     aes_stream_decryptor::~aes_stream_decryptor()
@@ -135,29 +290,65 @@ namespace impl {
         {
             EVP_CIPHER_CTX_free(_ctx);
         }
+        OPENSSL_cleanse(_key.data(), _key.size());
     }
 
     void aes_stream_decryptor::init(const gcm_key_type& key, const gcm_iv_type& init_value)
     {
-        SSL_HELPERS_ASSERT(_ctx == nullptr, "Previous context should be deleted before");
+        init(key, init_value.data(), init_value.size());
+    }
 
-        _ctx = EVP_CIPHER_CTX_new();
+    void aes_stream_decryptor::init(const gcm_key_type& key, const char* init_value, size_t init_value_len)
+    {
+        SSL_HELPERS_ASSERT(init_value && init_value_len > 0, "Init value required");
 
-        SSL_HELPERS_ASSERT(_ctx != nullptr, ERR_error_string(ERR_get_error(), nullptr));
+        init_value_len = get_iv_size(_cipher, init_value_len);
 
-        auto cypher_init_result = (1 == EVP_DecryptInit_ex(_ctx, EVP_aes_256_gcm(), NULL, NULL, NULL));
-        SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+        if (!_ctx)
+        {
+            _ctx = EVP_CIPHER_CTX_new();
+
+            SSL_HELPERS_ASSERT(_ctx != nullptr, ERR_error_string(ERR_get_error(), nullptr));
+
+            auto cypher_init_result = (1 == EVP_DecryptInit_ex(_ctx, get_aead_cipher(_cipher), NULL, NULL, NULL));
+            SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+        }
+
+        if (_iv_len != init_value_len)
+        {
+            _iv_len = 0;
 
-        auto cypher_init_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_SET_IVLEN, aes_size<gcm_iv_type>(), NULL));
-        SSL_HELPERS_ASSERT(cypher_init_result_2, ERR_error_string(ERR_get_error(), nullptr));
+            auto cypher_init_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_AEAD_SET_IVLEN, (int)init_value_len, NULL));
+            SSL_HELPERS_ASSERT(cypher_init_result_2, ERR_error_string(ERR_get_error(), nullptr));
 
-        auto cypher_init_result_3 = (1 == EVP_DecryptInit_ex(_ctx, NULL, NULL, (unsigned char*)key.data(), (unsigned char*)init_value.data()));
+            _iv_len = init_value_len;
+        }
+
+        // Skip key expansion for the same key
+        gcm_key_type cipher_key;
+        const unsigned char* pkey = NULL;
+        if (!_key_set || CRYPTO_memcmp(_key.data(), key.data(), key.size()))
+        {
+            _key = key;
+            _key_set = true;
+            get_cipher_key(_cipher, _key, cipher_key);
+            pkey = (const unsigned char*)cipher_key.data();
+        }
+
+        _session = false;
+
+        auto cypher_init_result_3 = (1 == EVP_DecryptInit_ex(_ctx, NULL, NULL, pkey, (const unsigned char*)init_value));
+        OPENSSL_cleanse(cipher_key.data(), cipher_key.size());
+        if (!cypher_init_result_3)
+            _key_set = false;
         SSL_HELPERS_ASSERT(cypher_init_result_3, ERR_error_string(ERR_get_error(), nullptr));
+
+        _session = true;
     }
 
     void aes_stream_decryptor::set_aad(const char* aad, size_t len)
     {
-        SSL_HELPERS_ASSERT(_ctx != nullptr, "Context required");
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
         int len_ = 0;
 
@@ -167,7 +358,7 @@ namespace impl {
 
     size_t aes_stream_decryptor::process(const char* cipher_chunk, size_t len, char* plain_chunk)
     {
-        SSL_HELPERS_ASSERT(_ctx != nullptr, "Context required");
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
         int plain_data_len = 0;
 
@@ -180,25 +371,33 @@ namespace impl {
 
     void aes_stream_decryptor::finalize(gcm_tag_type& tag)
     {
-        SSL_HELPERS_ASSERT(_ctx != nullptr, "Context required");
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
         static gcm_tag_type null_tag = { 0 };
-        int len_ = 0;
 
         if (std::memcmp(tag.data(), null_tag.data(), tag.size()))
         {
-            auto cypher_fin_result_1 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_SET_TAG, aes_size<gcm_tag_type>(), (void*)tag.data()));
-            SSL_HELPERS_ASSERT(cypher_fin_result_1, ERR_error_string(ERR_get_error(), nullptr));
+            finalize_checked(tag);
+        }
 
-            auto cypher_fin_result_2 = (1 == EVP_DecryptFinal_ex(_ctx, NULL, &len_));
-            SSL_HELPERS_ASSERT(cypher_fin_result_2, ERR_error_string(ERR_get_error(), nullptr));
+        _session = false;
+    }
 
-            SSL_HELPERS_ASSERT(!len_);
-        }
+    void aes_stream_decryptor::finalize_checked(const gcm_tag_type& tag)
+    {
+        SSL_HELPERS_ASSERT(_session, "Context required");
 
-        EVP_CIPHER_CTX_free(_ctx);
+        int len_ = 0;
+
+        auto cypher_fin_result_1 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_AEAD_SET_TAG, aes_size<gcm_tag_type>(), (void*)tag.data()));
+        SSL_HELPERS_ASSERT(cypher_fin_result_1, ERR_error_string(ERR_get_error(), nullptr));
 
-        _ctx = nullptr;
+        auto cypher_fin_result_2 = (1 == EVP_DecryptFinal_ex(_ctx, NULL, &len_));
+        SSL_HELPERS_ASSERT(cypher_fin_result_2, ERR_error_string(ERR_get_error(), nullptr));
+
+        SSL_HELPERS_ASSERT(!len_);
+
+        _session = false;
     }
 
     unsigned aes_block::encrypt(unsigned char* plain_data, int plain_data_len, unsigned char* key,
@@ -273,6 +472,99 @@ namespace impl {
         return plain_data;
     }
 
+    aes_block_session::aes_block_session(const sha512& key, bool encryption)
+    {
+        _ctx = EVP_CIPHER_CTX_new();
+
+        SSL_HELPERS_ASSERT(_ctx, ERR_error_string(ERR_get_error(), nullptr));
+
+        _iv = create_from_string<aes_128bit_type>(key.data() + aes_size<aes_256bit_type>(), aes_size<aes_128bit_type>());
+
+        auto cypher_init_result = (1 == EVP_CipherInit_ex(_ctx, EVP_aes_256_cbc(), NULL,
+                                                          (const unsigned char*)key.data(), (const unsigned char*)_iv.data(),
+                                                          encryption ? 1 : 0));
+        if (!cypher_init_result)
+            EVP_CIPHER_CTX_free(_ctx);
+        SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+    }
+
+    aes_block_session::~aes_block_session()
+    {
+        EVP_CIPHER_CTX_free(_ctx);
+        OPENSSL_cleanse(_iv.data(), _iv.size());
+    }
+
+    size_t aes_block_session::process(const char* input_data, size_t len, char* output_data)
+    {
+        // Reset state and init value only
+        auto cypher_init_result = (1 == EVP_CipherInit_ex(_ctx, NULL, NULL, NULL, (const unsigned char*)_iv.data(), -1));
+        SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+
+        int len_ = 0;
+        size_t output_len = 0;
+
+        auto cypher_update_result = (1 == EVP_CipherUpdate(_ctx, (unsigned char*)output_data, &len_, (const unsigned char*)input_data, (int)len));
+        SSL_HELPERS_ASSERT(cypher_update_result, ERR_error_string(ERR_get_error(), nullptr));
+        output_len = len_;
+
+        auto cypher_final_result = (1 == EVP_CipherFinal_ex(_ctx, (unsigned char*)output_data + output_len, &len_));
+        SSL_HELPERS_ASSERT(cypher_final_result, ERR_error_string(ERR_get_error(), nullptr));
+        output_len += len_;
+
+        return output_len;
+    }
+
+
+    aes_block_stream::aes_block_stream(bool encryption)
+        : _encryption(encryption)
+    {
+        _ctx = EVP_CIPHER_CTX_new();
+
+        SSL_HELPERS_ASSERT(_ctx, ERR_error_string(ERR_get_error(), nullptr));
+    }
+
+    aes_block_stream::~aes_block_stream()
+    {
+        EVP_CIPHER_CTX_free(_ctx);
+    }
+
+    void aes_block_stream::init(const sha512& key)
+    {
+        auto cypher_init_result = (1 == EVP_CipherInit_ex(_ctx, EVP_aes_256_cbc(), NULL,
+                                                          (const unsigned char*)key.data(),
+                                                          (const unsigned char*)key.data() + aes_size<aes_256bit_type>(),
+                                                          _encryption ? 1 : 0));
+        SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+
+        _session = true;
+    }
+
+    size_t aes_block_stream::process(const char* input_chunk, size_t len, char* output_chunk)
+    {
+        SSL_HELPERS_ASSERT(_session, "Context required");
+        SSL_HELPERS_ASSERT(len <= static_cast<size_t>(std::numeric_limits<int>::max()) - aes_size<aes_128bit_type>(), "Chunk is too large");
+
+        int len_ = 0;
+
+        auto cypher_update_result = (1 == EVP_CipherUpdate(_ctx, (unsigned char*)output_chunk, &len_, (const unsigned char*)input_chunk, (int)len));
+        SSL_HELPERS_ASSERT(cypher_update_result, ERR_error_string(ERR_get_error(), nullptr));
+
+        return static_cast<size_t>(len_);
+    }
+
+    size_t aes_block_stream::finalize(char* output_chunk)
+    {
+        SSL_HELPERS_ASSERT(_session, "Context required");
+
+        _session = false;
+
+        int len_ = 0;
+
+        auto cypher_final_result = (1 == EVP_CipherFinal_ex(_ctx, (unsigned char*)output_chunk, &len_));
+        SSL_HELPERS_ASSERT(cypher_final_result, ERR_error_string(ERR_get_error(), nullptr));
+
+        return static_cast<size_t>(len_);
+    }
 
 } // namespace impl
 } // namespace ssl_helpers
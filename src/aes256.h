@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ssl_helpers/crypto_types.h>
+#include <ssl_helpers/config.h>
 
 #include <string>
 #include <vector>
@@ -33,6 +34,12 @@ namespace impl {
     template <class aes_array_type>
     std::string to_string(const aes_array_type&);
 
+    const EVP_CIPHER* get_aead_cipher(config::AEAD_CIPHER);
+
+    // Compare 256 bit key AEAD ciphers by short self-benchmark.
+    // Result is calculated once per process
+    config::AEAD_CIPHER select_fastest_aead_cipher();
+
 
     // AES256 + 128iv, AEAD-GSM mode
     //
@@ -41,10 +48,17 @@ namespace impl {
     class aes_stream_encryptor
     {
     public:
-        aes_stream_encryptor() = default;
+        // AES256-GCM by default. Other AEAD cipher (config::AEAD_CIPHER)
+        // takes own key derived from the key (HMAC-SHA256 with cipher id)
+        // and ChaCha20-Poly1305 takes the left 96 bits of init value
+        explicit aes_stream_encryptor(config::AEAD_CIPHER cipher = config::AEAD_CIPHER_aes256_gcm);
         ~aes_stream_encryptor();
 
+        // Cipher context is kept alive between sessions.
+        // Key schedule is reused if the key has not changed
+        // since previous session (only init value is reset).
         void init(const gcm_key_type& key, const gcm_iv_type& init_value);
+        void init(const gcm_key_type& key, const char* init_value, size_t init_value_len);
 
         // This can be called zero or more times as required
         // to set public authorization information.
@@ -58,7 +72,12 @@ namespace impl {
         void finalize(gcm_tag_type&);
 
     private:
+        config::AEAD_CIPHER _cipher;
         EVP_CIPHER_CTX* _ctx = NULL;
+        gcm_key_type _key;
+        size_t _iv_len = 0;
+        bool _key_set = false;
+        bool _session = false;
     };
 
 
@@ -69,10 +88,15 @@ namespace impl {
     class aes_stream_decryptor
     {
     public:
-        aes_stream_decryptor() = default;
+        // Cipher keys are the same as for aes_stream_encryptor
+        explicit aes_stream_decryptor(config::AEAD_CIPHER cipher = config::AEAD_CIPHER_aes256_gcm);
         ~aes_stream_decryptor();
 
+        // Cipher context is kept alive between sessions.
+        // Key schedule is reused if the key has not changed
+        // since previous session (only init value is reset).
         void init(const gcm_key_type& key, const gcm_iv_type& init_value);
+        void init(const gcm_key_type& key, const char* init_value, size_t init_value_len);
 
         // This can be called zero or more times as required
         // to set public authorization information.
@@ -83,10 +107,19 @@ namespace impl {
         size_t process(const char* cipher_chunk, size_t len, char* plain_chunk);
 
         // Finish decryption and check by tag.
+        // Check is skipped for null tag.
         void finalize(gcm_tag_type&);
 
+        // Finish decryption and check by tag (for any tag).
+        void finalize_checked(const gcm_tag_type&);
+
     private:
+        config::AEAD_CIPHER _cipher;
         EVP_CIPHER_CTX* _ctx = NULL;
+        gcm_key_type _key;
+        size_t _iv_len = 0;
+        bool _key_set = false;
+        bool _session = false;
     };
 
 
@@ -113,5 +146,55 @@ namespace impl {
                          unsigned char* iv, unsigned char* plain_data);
     };
 
+
+    // The same as aes_block but cipher context and key schedule are
+    // created once for many messages (init value is reset for every message).
+    class aes_block_session
+    {
+    public:
+        aes_block_session(const sha512& key, bool encryption);
+        ~aes_block_session();
+
+        aes_block_session(const aes_block_session&) = delete;
+        aes_block_session& operator=(const aes_block_session&) = delete;
+
+        // Output buffer requires 'len' + block size bytes for encryption
+        // and 'len' bytes for decryption
+        size_t process(const char* input_data, size_t len, char* output_data);
+
+    private:
+        EVP_CIPHER_CTX* _ctx = NULL;
+        aes_128bit_type _iv;
+    };
+
+
+    // AES256 + fixed 128iv, CBC mode by chunks. Result is identical
+    // to aes_block for joined chunks. Up to one block is kept
+    // in context between chunks (for padding).
+    class aes_block_stream
+    {
+    public:
+        explicit aes_block_stream(bool encryption);
+        ~aes_block_stream();
+
+        aes_block_stream(const aes_block_stream&) = delete;
+        aes_block_stream& operator=(const aes_block_stream&) = delete;
+
+        void init(const sha512& key);
+
+        // Output buffer requires 'len' + block size bytes.
+        // Return size of output data
+        size_t process(const char* input_chunk, size_t len, char* output_chunk);
+
+        // Output buffer requires block size bytes.
+        // Return size of output data
+        size_t finalize(char* output_chunk);
+
+    private:
+        EVP_CIPHER_CTX* _ctx = NULL;
+        bool _encryption = true;
+        bool _session = false;
+    };
+
 } // namespace impl
 } // namespace ssl_helpers
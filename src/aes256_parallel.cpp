@@ -0,0 +1,441 @@
+#include <limits>
+#include <vector>
+
+#include "ssl_helpers_defines.h"
+#include "parallel_helper.h"
+#include "aes256_parallel.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+
+        // Minimal segment to be worth of separate thread
+        constexpr size_t MIN_SEGMENT_SIZE = 64 * 1024;
+
+        // Segment is processed by pieces to keep data hot in cache
+        // between CTR and GHASH passes
+        constexpr size_t PIECE_SIZE = 16 * 1024;
+
+        constexpr size_t BLOCK_SIZE = 16;
+
+        uint64_t blocks_count(uint64_t len)
+        {
+            return (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        }
+
+        class cipher_context
+        {
+        public:
+            cipher_context()
+                : _ctx(EVP_CIPHER_CTX_new())
+            {
+                SSL_HELPERS_ASSERT(_ctx != nullptr, ERR_error_string(ERR_get_error(), nullptr));
+            }
+            cipher_context(const cipher_context&) = delete;
+            ~cipher_context()
+            {
+                EVP_CIPHER_CTX_free(_ctx);
+            }
+
+            EVP_CIPHER_CTX* get() const
+            {
+                return _ctx;
+            }
+
+        private:
+            EVP_CIPHER_CTX* _ctx = NULL;
+        };
+
+        void encrypt_blocks(const gcm_key_type& key, const unsigned char* blocks, size_t len, unsigned char* result)
+        {
+            cipher_context ctx;
+
+            auto cypher_init_result = (1 == EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_ecb(), NULL, (const unsigned char*)key.data(), NULL));
+            SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+
+            EVP_CIPHER_CTX_set_padding(ctx.get(), 0);
+
+            int len_ = 0;
+            auto cypher_encode_result = (1 == EVP_EncryptUpdate(ctx.get(), result, &len_, blocks, (int)len));
+            SSL_HELPERS_ASSERT(cypher_encode_result && len_ == (int)len, ERR_error_string(ERR_get_error(), nullptr));
+        }
+
+        // CTR keystream with 32-bit counter increment (inc32) like GCM requires.
+        // EVP CTR mode increments whole 128-bit counter, so it is restarted
+        // when low 32 bits are overflowed.
+        class gcm_ctr_stream
+        {
+        public:
+            gcm_ctr_stream(const gcm_key_type& key, const gf128& counter)
+                : _counter(counter)
+            {
+                unsigned char counter_block[BLOCK_SIZE];
+                _counter.store(counter_block);
+
+                auto cypher_init_result = (1 == EVP_EncryptInit_ex(_ctx.get(), EVP_aes_256_ctr(), NULL, (const unsigned char*)key.data(), counter_block));
+                SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+
+                _blocks_to_wrap = 0x100000000ULL - (_counter.lo & 0xffffffffULL);
+            }
+
+            void process(const char* input, size_t len, char* output)
+            {
+                while (len > 0)
+                {
+                    if (!_blocks_to_wrap)
+                    {
+                        _counter.lo &= 0xffffffff00000000ULL;
+
+                        unsigned char counter_block[BLOCK_SIZE];
+                        _counter.store(counter_block);
+
+                        auto cypher_init_result = (1 == EVP_EncryptInit_ex(_ctx.get(), NULL, NULL, NULL, counter_block));
+                        SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+
+                        _blocks_to_wrap = 0x100000000ULL;
+                    }
+
+                    size_t piece = len;
+                    if (blocks_count(piece) > _blocks_to_wrap)
+                        piece = static_cast<size_t>(_blocks_to_wrap * BLOCK_SIZE);
+
+                    int len_ = 0;
+                    auto cypher_encode_result = (1 == EVP_EncryptUpdate(_ctx.get(), (unsigned char*)output, &len_, (const unsigned char*)input, (int)piece));
+                    SSL_HELPERS_ASSERT(cypher_encode_result && len_ == (int)piece, ERR_error_string(ERR_get_error(), nullptr));
+
+                    _blocks_to_wrap -= blocks_count(piece);
+                    input += piece;
+                    output += piece;
+                    len -= piece;
+                }
+            }
+
+        private:
+            cipher_context _ctx;
+            gf128 _counter;
+            uint64_t _blocks_to_wrap = 0;
+        };
+
+        // Bulk GHASH by OpenSSL GCM with zero 96-bit IV. Data is passed as AAD
+        // and result tag is  E(K, J0') ^ GHASH(data || length block).
+        class ghash_stream
+        {
+        public:
+            ghash_stream(const gcm_key_type& key)
+            {
+                const unsigned char zero_iv[12] = { 0 };
+
+                auto cypher_init_result = (1 == EVP_EncryptInit_ex(_ctx.get(), EVP_aes_256_gcm(), NULL, (const unsigned char*)key.data(), zero_iv));
+                SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+            }
+
+            void update(const char* data, size_t len)
+            {
+                int len_ = 0;
+                auto cypher_update_result = (1 == EVP_EncryptUpdate(_ctx.get(), NULL, &len_, (const unsigned char*)data, (int)len));
+                SSL_HELPERS_ASSERT(cypher_update_result, ERR_error_string(ERR_get_error(), nullptr));
+            }
+
+            gcm_tag_type finalize()
+            {
+                int len_ = 0;
+                auto cypher_fin_result_1 = (1 == EVP_EncryptFinal_ex(_ctx.get(), NULL, &len_));
+                SSL_HELPERS_ASSERT(cypher_fin_result_1, ERR_error_string(ERR_get_error(), nullptr));
+
+                gcm_tag_type tag;
+                auto cypher_fin_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx.get(), EVP_CTRL_GCM_GET_TAG, aes_size<gcm_tag_type>(), tag.data()));
+                SSL_HELPERS_ASSERT(cypher_fin_result_2, ERR_error_string(ERR_get_error(), nullptr));
+                return tag;
+            }
+
+        private:
+            cipher_context _ctx;
+        };
+
+    } // namespace
+
+    aes_gcm_parallel::aes_gcm_parallel(const gcm_key_type& key, const gcm_iv_type& init_value,
+                                       config::AEAD_CIPHER cipher)
+        : _cipher(cipher)
+        , _key(key)
+        , _iv(init_value)
+    {
+        if (_cipher != config::AEAD_CIPHER_aes256_gcm)
+            return;
+
+        // H = E(K, 0^128), J0' = 0^96 || 1 (for helper GHASH streams)
+        unsigned char blocks[2 * BLOCK_SIZE] = { 0 };
+        blocks[2 * BLOCK_SIZE - 1] = 1;
+        unsigned char encrypted_blocks[2 * BLOCK_SIZE];
+        encrypt_blocks(_key, blocks, sizeof(blocks), encrypted_blocks);
+
+        _h = gf128::load(encrypted_blocks);
+        _ek_helper_j0 = gf128::load(encrypted_blocks + BLOCK_SIZE);
+
+        // J0 = GHASH(IV || 0^64 || [128]64) for 128-bit IV
+        gf128 iv_length;
+        iv_length.lo = 8 * init_value.size();
+        _j0 = gf128::load((const unsigned char*)init_value.data()) * _h;
+        _j0 = (_j0 ^ iv_length) * _h;
+
+        _j0.store(blocks);
+        encrypt_blocks(_key, blocks, BLOCK_SIZE, encrypted_blocks);
+        _ek_j0 = gf128::load(encrypted_blocks);
+
+        OPENSSL_cleanse(encrypted_blocks, sizeof(encrypted_blocks));
+    }
+
+    aes_gcm_parallel::~aes_gcm_parallel()
+    {
+        OPENSSL_cleanse(_key.data(), _key.size());
+        OPENSSL_cleanse(_iv.data(), _iv.size());
+        OPENSSL_cleanse(&_h, sizeof(_h));
+    }
+
+    void aes_gcm_parallel::encrypt(const char* aad, size_t aad_len,
+                                   const char* plain_data, size_t len, char* cipher_data,
+                                   gcm_tag_type& tag, size_t threads_amount)
+    {
+        if (single_pass(len, threads_amount))
+        {
+            aes_stream_encryptor cipher(_cipher);
+            cipher.init(_key, _iv);
+            if (aad_len > 0)
+                cipher.set_aad(aad, aad_len);
+            if (len > 0)
+                cipher.process(plain_data, len, cipher_data);
+            cipher.finalize(tag);
+            return;
+        }
+
+        tag = process(true, aad, aad_len, plain_data, len, cipher_data, threads_amount);
+    }
+
+    void aes_gcm_parallel::decrypt(const char* aad, size_t aad_len,
+                                   const char* cipher_data, size_t len, char* plain_data,
+                                   const gcm_tag_type& tag, size_t threads_amount)
+    {
+        if (single_pass(len, threads_amount))
+        {
+            aes_stream_decryptor cipher(_cipher);
+            cipher.init(_key, _iv);
+            if (aad_len > 0)
+                cipher.set_aad(aad, aad_len);
+            if (len > 0)
+                cipher.process(cipher_data, len, plain_data);
+            try
+            {
+                cipher.finalize_checked(tag);
+            }
+            catch (std::exception&)
+            {
+                OPENSSL_cleanse(plain_data, len);
+                throw;
+            }
+            return;
+        }
+
+        auto calculated_tag = process(false, aad, aad_len, cipher_data, len, plain_data, threads_amount);
+        if (CRYPTO_memcmp(calculated_tag.data(), tag.data(), tag.size()))
+        {
+            OPENSSL_cleanse(plain_data, len);
+            SSL_HELPERS_ERROR("Invalid tag");
+        }
+    }
+
+    size_t aes_gcm_parallel::segments_amount(size_t len, size_t threads_amount)
+    {
+        return get_threads_amount(threads_amount, (len + MIN_SEGMENT_SIZE - 1) / MIN_SEGMENT_SIZE);
+    }
+
+    bool aes_gcm_parallel::single_pass(size_t len, size_t threads_amount) const
+    {
+        if (_cipher != config::AEAD_CIPHER_aes256_gcm)
+            return true;
+
+        // Single pass is faster for one thread
+        return len > 0 && segments_amount(len, threads_amount) == 1;
+    }
+
+    gcm_tag_type aes_gcm_parallel::process(bool encryption,
+                                           const char* aad, size_t aad_len,
+                                           const char* input, size_t len, char* output,
+                                           size_t threads_amount)
+    {
+        // GCM limit for plain data is 2^39 - 256 bits
+        SSL_HELPERS_ASSERT(static_cast<uint64_t>(len) <= (1ULL << 36) - 32, "Data is too large");
+        SSL_HELPERS_ASSERT(len == 0 || (input && output), "Buffer required");
+
+        const uint64_t total_blocks = blocks_count(len);
+
+        gf128 s;
+
+        if (aad_len > 0)
+        {
+            ghash_stream aad_ghash(_key);
+            for (size_t offset = 0; offset < aad_len; offset += PIECE_SIZE)
+            {
+                aad_ghash.update(aad + offset, std::min(PIECE_SIZE, aad_len - offset));
+            }
+            s ^= ghash_term(aad_ghash.finalize(), aad_len, total_blocks);
+        }
+
+        if (len > 0)
+        {
+            size_t segments = segments_amount(len, threads_amount);
+
+            const uint64_t segment_blocks = (total_blocks + segments - 1) / segments;
+
+            std::vector<gf128> terms(segments);
+
+            parallel_run(segments, segments, [&](size_t segment) {
+                uint64_t block_offset = segment * segment_blocks;
+                uint64_t offset = block_offset * BLOCK_SIZE;
+                if (offset >= len)
+                    return;
+
+                size_t segment_len = static_cast<size_t>(std::min<uint64_t>(segment_blocks * BLOCK_SIZE, len - offset));
+                uint64_t blocks_after = total_blocks - block_offset - blocks_count(segment_len);
+
+                terms[segment] = process_segment(encryption, block_offset,
+                                                 input + offset, segment_len, output + offset,
+                                                 blocks_after);
+            });
+
+            for (auto&& term : terms)
+            {
+                s ^= term;
+            }
+        }
+
+        gf128 length_block;
+        length_block.hi = 8 * static_cast<uint64_t>(aad_len);
+        length_block.lo = 8 * static_cast<uint64_t>(len);
+        s ^= length_block * _h;
+
+        gcm_tag_type tag;
+        (s ^ _ek_j0).store((unsigned char*)tag.data());
+        return tag;
+    }
+
+    gf128 aes_gcm_parallel::process_segment(bool encryption, uint64_t block_offset,
+                                            const char* input, size_t len, char* output,
+                                            uint64_t blocks_after)
+    {
+        // Counter for the first block of segment: inc32 of J0 (block_offset + 1) times
+        gf128 counter = _j0;
+        counter.lo = (counter.lo & 0xffffffff00000000ULL) | ((counter.lo + block_offset + 1) & 0xffffffffULL);
+
+        gcm_ctr_stream ctr(_key, counter);
+        ghash_stream cipher_ghash(_key);
+
+        for (size_t offset = 0; offset < len; offset += PIECE_SIZE)
+        {
+            size_t piece = std::min(PIECE_SIZE, len - offset);
+
+            // GHASH is calculated for cipher data. It is taken before
+            // decryption for in-place processing
+            if (!encryption)
+                cipher_ghash.update(input + offset, piece);
+
+            ctr.process(input + offset, piece, output + offset);
+
+            if (encryption)
+                cipher_ghash.update(output + offset, piece);
+        }
+
+        return ghash_term(cipher_ghash.finalize(), len, blocks_after);
+    }
+
+    gf128 aes_gcm_parallel::ghash_term(const gcm_tag_type& helper_tag, size_t len, uint64_t blocks_after)
+    {
+        // Helper tag gives Z = (G ^ L) * H for data G-hash and its length block L.
+        // Required term G * H^(blocks_after + 1) = Z * H^blocks_after ^ L * H^(blocks_after + 1)
+        gf128 z = gf128::load((const unsigned char*)helper_tag.data()) ^ _ek_helper_j0;
+
+        gf128 length_block;
+        length_block.hi = 8 * static_cast<uint64_t>(len);
+
+        gf128 h_power = gf128_pow(_h, blocks_after);
+
+        return z * h_power ^ length_block * (h_power * _h);
+    }
+
+    aes_cbc_parallel::aes_cbc_parallel(const sha512& key)
+    {
+        _key = create_from_string<aes_256bit_type>(key.data(), aes_size<aes_256bit_type>());
+        _iv = create_from_string<aes_128bit_type>(key.data() + aes_size<aes_256bit_type>(), aes_size<aes_128bit_type>());
+    }
+
+    aes_cbc_parallel::~aes_cbc_parallel()
+    {
+        OPENSSL_cleanse(_key.data(), _key.size());
+        OPENSSL_cleanse(_iv.data(), _iv.size());
+    }
+
+    size_t aes_cbc_parallel::decrypt(const char* cipher_data, size_t len, char* plain_data,
+                                     size_t threads_amount)
+    {
+        SSL_HELPERS_ASSERT(cipher_data && plain_data, "Buffer required");
+        SSL_HELPERS_ASSERT(len > 0 && len % BLOCK_SIZE == 0 && len <= static_cast<size_t>(std::numeric_limits<int>::max()), "Invalid cipher data");
+
+        const uint64_t total_blocks = blocks_count(len);
+
+        size_t segments = get_threads_amount(threads_amount, (len + MIN_SEGMENT_SIZE - 1) / MIN_SEGMENT_SIZE);
+
+        const uint64_t segment_blocks = (total_blocks + segments - 1) / segments;
+        segments = static_cast<size_t>((total_blocks + segment_blocks - 1) / segment_blocks);
+
+        // Init values are taken before decryption because
+        // cipher data can be overwritten (in place decryption)
+        std::vector<aes_128bit_type> init_values(segments);
+        init_values[0] = _iv;
+        for (size_t segment = 1; segment < segments; ++segment)
+        {
+            const char* previous_block = cipher_data + segment * segment_blocks * BLOCK_SIZE - BLOCK_SIZE;
+            init_values[segment] = create_from_string<aes_128bit_type>(previous_block, BLOCK_SIZE);
+        }
+
+        size_t plain_len = 0;
+
+        parallel_run(segments, segments, [&](size_t segment) {
+            size_t offset = static_cast<size_t>(segment * segment_blocks * BLOCK_SIZE);
+            size_t segment_len = std::min(static_cast<size_t>(segment_blocks * BLOCK_SIZE), len - offset);
+            bool last = segment + 1 == segments;
+
+            cipher_context ctx;
+
+            auto cypher_init_result = (1 == EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_cbc(), NULL,
+                                                               (const unsigned char*)_key.data(),
+                                                               (const unsigned char*)init_values[segment].data()));
+            SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+
+            if (!last)
+                EVP_CIPHER_CTX_set_padding(ctx.get(), 0);
+
+            int len_ = 0;
+            size_t output_len = 0;
+
+            auto cypher_decode_result = (1 == EVP_DecryptUpdate(ctx.get(), (unsigned char*)plain_data + offset, &len_,
+                                                                (const unsigned char*)cipher_data + offset, (int)segment_len));
+            SSL_HELPERS_ASSERT(cypher_decode_result, ERR_error_string(ERR_get_error(), nullptr));
+            output_len = len_;
+
+            auto cypher_final_result = (1 == EVP_DecryptFinal_ex(ctx.get(), (unsigned char*)plain_data + offset + output_len, &len_));
+            SSL_HELPERS_ASSERT(cypher_final_result, ERR_error_string(ERR_get_error(), nullptr));
+            output_len += len_;
+
+            if (last)
+                plain_len = offset + output_len;
+        });
+
+        for (auto&& init_value : init_values)
+            OPENSSL_cleanse(init_value.data(), init_value.size());
+
+        return plain_len;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "aes256.h"
+#include "gf128.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // AES256 + 128iv, AEAD-GSM mode by several threads
+    //
+    // Result and tag are identical to aes_stream_encryptor/aes_stream_decryptor
+    // session with the same key, init value and AAD. Data is split
+    // to segments (aligned to AES block) and every thread
+    // makes CTR keystream and GHASH for own segment. Separate GHASH values
+    // are combined at the end by multiplication to powers of hash key.
+    // Other AEAD cipher (config::AEAD_CIPHER) is processed in one pass
+    // (the same as aes_stream_encryptor/aes_stream_decryptor).
+    //
+    class aes_gcm_parallel
+    {
+    public:
+        aes_gcm_parallel(const gcm_key_type& key, const gcm_iv_type& init_value,
+                         config::AEAD_CIPHER cipher = config::AEAD_CIPHER_aes256_gcm);
+        ~aes_gcm_parallel();
+
+        void encrypt(const char* aad, size_t aad_len,
+                     const char* plain_data, size_t len, char* cipher_data,
+                     gcm_tag_type& tag, size_t threads_amount);
+
+        // Throw exception if tag does not correspond to data
+        void decrypt(const char* aad, size_t aad_len,
+                     const char* cipher_data, size_t len, char* plain_data,
+                     const gcm_tag_type& tag, size_t threads_amount);
+
+    private:
+        static size_t segments_amount(size_t len, size_t threads_amount);
+
+        gcm_tag_type process(bool encryption,
+                             const char* aad, size_t aad_len,
+                             const char* input, size_t len, char* output,
+                             size_t threads_amount);
+
+        // Encrypt/decrypt segment that starts from 'block_offset' block
+        // and return its GHASH term for 'blocks_after' following blocks
+        gf128 process_segment(bool encryption, uint64_t block_offset,
+                              const char* input, size_t len, char* output,
+                              uint64_t blocks_after);
+
+        // GHASH term of 'len' bytes already hashed with helper tag
+        gf128 ghash_term(const gcm_tag_type& helper_tag, size_t len, uint64_t blocks_after);
+
+        // Data are split for AES256-GCM only
+        bool single_pass(size_t len, size_t threads_amount) const;
+
+        config::AEAD_CIPHER _cipher;
+        gcm_key_type _key;
+        gcm_iv_type _iv;
+        gf128 _h;
+        gf128 _j0;
+        gf128 _ek_j0;
+        gf128 _ek_helper_j0;
+    };
+
+
+    // AES256 + fixed 128iv, CBC mode decryption by several threads
+    //
+    // Result is identical to aes_block::decrypt. Every plain block depends
+    // on two cipher blocks only, so cipher data is split to segments
+    // (aligned to AES block) and every thread decrypts own segment
+    // with the previous cipher block as init value. Padding is removed
+    // from the last segment only.
+    //
+    class aes_cbc_parallel
+    {
+    public:
+        aes_cbc_parallel(const sha512& key);
+        ~aes_cbc_parallel();
+
+        // Plain buffer should have at least 'len' bytes (it can be
+        // the same as cipher buffer). Return size of plain data
+        size_t decrypt(const char* cipher_data, size_t len, char* plain_data,
+                       size_t threads_amount);
+
+    private:
+        aes_256bit_type _key;
+        aes_128bit_type _iv;
+    };
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -121,6 +121,32 @@ namespace impl {
         return std::string();
     }
 
+    size_t to_base64(const char* d, size_t s, char* out_data)
+    {
+        const BYTE* buf = reinterpret_cast<const BYTE*>(d);
+        char* out_pos = out_data;
+
+        for (; s >= 3; s -= 3, buf += 3)
+        {
+            *out_pos++ = base64_chars[(buf[0] & 0xfc) >> 2];
+            *out_pos++ = base64_chars[((buf[0] & 0x03) << 4) + ((buf[1] & 0xf0) >> 4)];
+            *out_pos++ = base64_chars[((buf[1] & 0x0f) << 2) + ((buf[2] & 0xc0) >> 6)];
+            *out_pos++ = base64_chars[buf[2] & 0x3f];
+        }
+
+        if (s)
+        {
+            BYTE char_array_3[3] = { buf[0], s > 1 ? buf[1] : BYTE(0), 0 };
+
+            *out_pos++ = base64_chars[(char_array_3[0] & 0xfc) >> 2];
+            *out_pos++ = base64_chars[((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4)];
+            *out_pos++ = s > 1 ? base64_chars[((char_array_3[1] & 0x0f) << 2)] : '=';
+            *out_pos++ = '=';
+        }
+
+        return static_cast<size_t>(out_pos - out_data);
+    }
+
     std::vector<char> from_base64(const char* d, size_t s)
     {
         std::vector<BYTE> out = base64_decode(d, s);
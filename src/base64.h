@@ -9,6 +9,8 @@ namespace impl {
 
     std::string to_base64(const char* d, size_t s);
     std::string to_base64(const std::vector<char>& data);
+    // Output buffer should have at least 4 * ((s + 2) / 3) bytes. Return encoded size
+    size_t to_base64(const char* d, size_t s, char* out_data);
     std::vector<char> from_base64(const char* d, size_t s);
     size_t from_base64(const char* d, size_t s, char* out_data, size_t out_data_len);
 
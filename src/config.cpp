@@ -1,6 +1,7 @@
 #include <ssl_helpers/config.h>
 
 #include "ssl_helpers_defines.h"
+#include "data_compressor.h"
 
 
 namespace ssl_helpers {
@@ -25,4 +26,48 @@ config& config::set_ec_domain_group(const EC_GROUP_DOMAIN ec_group_domain)
     return *this;
 }
 
+config& config::set_aead_cipher(const AEAD_CIPHER aead_cipher)
+{
+    SSL_HELPERS_ASSERT(aead_cipher >= AEAD_CIPHER_aes256_gcm && aead_cipher <= AEAD_CIPHER_auto, "Invalid cipher");
+
+    _aead_cipher = aead_cipher;
+    _auto_aead_cipher = aead_cipher == AEAD_CIPHER_auto;
+    return *this;
+}
+
+config& config::set_compression(const COMPRESSION compression)
+{
+    SSL_HELPERS_ASSERT(is_supported_compression(compression), "Unsupported compression");
+
+    _compression = compression;
+    return *this;
+}
+
+bool config::is_supported_compression(const COMPRESSION compression)
+{
+    return impl::is_supported_compression(compression);
+}
+
+config& config::set_salted_key_cache_size(size_t sz)
+{
+    _salted_key_cache_size = sz;
+    return *this;
+}
+
+config& config::set_pbkdf2_prf(const PBKDF2_PRF prf)
+{
+    SSL_HELPERS_ASSERT(prf >= PBKDF2_PRF_sha1 && prf <= PBKDF2_PRF_sha512, "Invalid PRF");
+
+    _pbkdf2_prf = prf;
+    return *this;
+}
+
+config& config::set_pbkdf2_iterations(int iterations)
+{
+    SSL_HELPERS_ASSERT(iterations > 0, "Invalid iterations");
+
+    _pbkdf2_iterations = iterations;
+    return *this;
+}
+
 } // namespace ssl_helpers
@@ -3,6 +3,8 @@
 #include <ssl_helpers/context.h>
 
 #include "openssl_crypto_api.h"
+#include "aes256.h"
+#include "salted_key_cache.h"
 
 
 namespace ssl_helpers {
@@ -28,6 +30,10 @@ context::context(const config& config_)
 {
 }
 
+context::~context()
+{
+}
+
 config context::configurate()
 {
     return {};
@@ -39,6 +45,13 @@ context& context::init(const config& config_)
     if (ctx().is_enabled_libcrypto_api())
     {
         impl::init_openssl_crypto_api();
+
+        // Data without header don't follow auto mode (config::headerless_aead_cipher)
+        if (ctx().aead_cipher() == config::AEAD_CIPHER_auto)
+            ctx._config._aead_cipher = impl::select_fastest_aead_cipher();
+
+        if (ctx().salted_key_cache_size() > 0)
+            ctx._salted_key_cache = std::make_unique<impl::__salted_key_cache>(ctx().salted_key_cache_size());
     }
     return ctx;
 }
@@ -53,4 +66,9 @@ const config& context::get_config() const
     return _config;
 }
 
+impl::__salted_key_cache* context::salted_key_cache() const
+{
+    return _salted_key_cache.get();
+}
+
 } // namespace ssl_helpers
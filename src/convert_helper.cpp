@@ -50,6 +50,18 @@ namespace impl {
         return to_hex((const uint8_t*)d, s);
     }
 
+    size_t to_hex(const char* d, size_t s, char* out_data)
+    {
+        const char* to_hex = "0123456789abcdef";
+        const uint8_t* d8 = (const uint8_t*)d;
+        for (size_t i = 0; i < s; ++i)
+        {
+            *out_data++ = to_hex[(d8[i] >> 4)];
+            *out_data++ = to_hex[(d8[i] & 0x0f)];
+        }
+        return 2 * s;
+    }
+
     size_t from_hex(const std::string& hex_str, uint8_t* out_data, size_t out_data_len)
     {
         std::string::const_iterator i = hex_str.begin();
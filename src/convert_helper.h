@@ -14,6 +14,8 @@ namespace impl {
 
     std::string to_hex(const char* d, uint32_t s);
     std::string to_hex(const uint8_t* d, uint32_t s);
+    // Output buffer should have at least 2 * s bytes. Return encoded size
+    size_t to_hex(const char* d, size_t s, char* out_data);
 
     template <typename T>
     std::string to_hex(const T& data)
@@ -1,5 +1,6 @@
-#include <sstream>
+#include <cstring>
 
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
 
 #include <ssl_helpers/crypto.h>
@@ -8,30 +9,890 @@
 #include <ssl_helpers/shadowing.h>
 
 #include "crypto_stream_impl.h"
+#include "aes256_parallel.h"
+#include "crypto_batch_impl.h"
+#include "crypto_flip_impl.h"
+#include "salted_key_cache.h"
 #include "sha256.h"
+#include "hmac.h"
 
 
 namespace ssl_helpers {
 
+namespace {
+    // MAC is calculated by pieces of cipher data while they are hot in cache
+    constexpr size_t CBC_MAC_PIECE_SIZE = 16 * 1024;
+
+    // MAC key is derived from the same key material as AES256-CBC key
+    // and init value but it is independent of them
+    impl::sha256 cbc_mac_key(const impl::sha512& key_hash)
+    {
+        static const std::string label { "AES256-CBC HMAC-SHA256" };
+
+        impl::hmac_sha256 kdf(key_hash.data(), key_hash.data_size());
+        kdf.write(label.data(), label.size());
+        return kdf.result();
+    }
+
+    // PBKDF2 of previous versions (context-free aes_get_salted_key)
+    std::string get_legacy_salted_key(const std::string& key, const std::string& salt)
+    {
+        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
+        SSL_HELPERS_ASSERT(!salt.empty(), "Salt required");
+
+        // The same as create_pbkdf2_512 but by several threads
+        return create_pbkdf2(key, salt, 8192, 512 / 8, config::PBKDF2_PRF_sha1, 0);
+    }
+} // namespace
+
 std::string aes_to_string(const aes_128bit_type& data)
 {
     return impl::to_string(data);
 }
 
-aes_128bit_type aes_from_string(const std::string& tag)
+aes_128bit_type aes_from_string(const std::string& tag)
+{
+    return impl::create_from_string<aes_128bit_type>(tag.data(), tag.size());
+}
+
+prepared_aes_key::prepared_aes_key(const context& ctx, const std::string& shadowed_key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_shared<impl::__prepared_aes_key>(ctx, shadowed_key);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+prepared_aes_key::~prepared_aes_key()
+{
+}
+
+aes_encryption_stream::aes_encryption_stream(const context& ctx,
+                                             const std::string& default_shadowed_key,
+                                             const std::string& default_aad)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_encryption_stream>(ctx, default_shadowed_key, default_aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_encryption_stream::~aes_encryption_stream()
+{
+}
+
+std::string aes_encryption_stream::start(const std::string& shadowed_key, const std::string& aad)
+{
+    try
+    {
+        return _impl->start(shadowed_key, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_encryption_stream::start(const prepared_aes_key& key, const std::string& aad)
+{
+    try
+    {
+        return _impl->start(*key._impl, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_encryption_stream::encrypt(const std::string& plain_chunk)
+{
+    try
+    {
+        return _impl->encrypt(plain_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_encryption_stream::encrypt(const char* plain_chunk, size_t len, char* cipher_chunk)
+{
+    try
+    {
+        return _impl->encrypt(plain_chunk, len, cipher_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_encryption_stream::encrypt_in_place(char* buffer, size_t len)
+{
+    try
+    {
+        return _impl->encrypt(buffer, len, buffer);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_encryption_stream::encrypt(const buffer_view* plain_chunks, size_t count, char* cipher_chunk)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(plain_chunks || !count, "Buffers required");
+
+        size_t result = 0;
+        for (size_t ci = 0; ci < count; ++ci)
+        {
+            if (!plain_chunks[ci].size)
+                continue;
+            result += _impl->encrypt(plain_chunks[ci].data, plain_chunks[ci].size, cipher_chunk + result);
+        }
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_encryption_stream::encrypt_in_place(const mutable_buffer_view* buffers, size_t count)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(buffers || !count, "Buffers required");
+
+        size_t result = 0;
+        for (size_t ci = 0; ci < count; ++ci)
+        {
+            if (!buffers[ci].size)
+                continue;
+            result += _impl->encrypt(buffers[ci].data, buffers[ci].size, buffers[ci].data);
+        }
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+aes_tag_type aes_encryption_stream::finalize()
+{
+    try
+    {
+        return _impl->finalize();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+void aes_encryption_stream::set_digest(AES_DIGEST type)
+{
+    try
+    {
+        _impl->set_digest(type);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_tag_type aes_encryption_stream::finalize(std::string& plain_digest)
+{
+    try
+    {
+        return _impl->finalize(plain_digest);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+aes_decryption_stream::aes_decryption_stream(const context& ctx,
+                                             const std::string& default_shadowed_key,
+                                             const std::string& default_aad)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_decryption_stream>(ctx, default_shadowed_key, default_aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_decryption_stream::~aes_decryption_stream()
+{
+}
+
+void aes_decryption_stream::start(const std::string& shadowed_key, const std::string& aad)
+{
+    try
+    {
+        _impl->start(shadowed_key, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_decryption_stream::start(const prepared_aes_key& key, const std::string& aad)
+{
+    try
+    {
+        _impl->start(*key._impl, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+std::string aes_decryption_stream::decrypt(const std::string& cipher_chunk)
+{
+    try
+    {
+        return _impl->decrypt(cipher_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_decryption_stream::decrypt(const char* cipher_chunk, size_t len, char* plain_chunk)
+{
+    try
+    {
+        return _impl->decrypt(cipher_chunk, len, plain_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_decryption_stream::decrypt_in_place(char* buffer, size_t len)
+{
+    try
+    {
+        return _impl->decrypt(buffer, len, buffer);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_decryption_stream::decrypt(const buffer_view* cipher_chunks, size_t count, char* plain_chunk)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(cipher_chunks || !count, "Buffers required");
+
+        size_t result = 0;
+        for (size_t ci = 0; ci < count; ++ci)
+        {
+            if (!cipher_chunks[ci].size)
+                continue;
+            result += _impl->decrypt(cipher_chunks[ci].data, cipher_chunks[ci].size, plain_chunk + result);
+        }
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_decryption_stream::decrypt_in_place(const mutable_buffer_view* buffers, size_t count)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(buffers || !count, "Buffers required");
+
+        size_t result = 0;
+        for (size_t ci = 0; ci < count; ++ci)
+        {
+            if (!buffers[ci].size)
+                continue;
+            result += _impl->decrypt(buffers[ci].data, buffers[ci].size, buffers[ci].data);
+        }
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+void aes_decryption_stream::finalize(const aes_tag_type& tag)
+{
+    try
+    {
+        _impl->finalize(tag);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_decryption_stream::finalize()
+{
+    try
+    {
+        _impl->finalize({ 0 });
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_decryption_stream::set_digest(AES_DIGEST type)
+{
+    try
+    {
+        _impl->set_digest(type);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_decryption_stream::finalize(const aes_tag_type& tag, std::string& plain_digest)
+{
+    try
+    {
+        _impl->finalize(tag, plain_digest);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+std::string aes_encrypt_parallel(const context& ctx,
+                                 const std::string& plain_data,
+                                 const std::string& shadowed_key,
+                                 aes_tag_type& tag,
+                                 const std::string& aad,
+                                 size_t threads_amount)
+{
+    try
+    {
+        std::string result(plain_data.size(), '\0');
+        aes_encrypt_parallel(ctx, plain_data.data(), plain_data.size(), &result[0], shadowed_key, tag, aad, threads_amount);
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_encrypt_parallel(const context& ctx,
+                            const char* plain_data, size_t len, char* cipher_data,
+                            const std::string& shadowed_key,
+                            aes_tag_type& tag,
+                            const std::string& aad,
+                            size_t threads_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::gcm_key_material key_material;
+        impl::derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        impl::aes_gcm_parallel cipher(key_material.key, key_material.iv, ctx().headerless_aead_cipher());
+        cipher.encrypt(aad.data(), aad.size(), plain_data, len, cipher_data, tag, threads_amount);
+        return len;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+std::string aes_decrypt_parallel(const context& ctx,
+                                 const std::string& cipher_data,
+                                 const std::string& shadowed_key,
+                                 const aes_tag_type& tag,
+                                 const std::string& aad,
+                                 size_t threads_amount)
+{
+    try
+    {
+        std::string result(cipher_data.size(), '\0');
+        aes_decrypt_parallel(ctx, cipher_data.data(), cipher_data.size(), &result[0], shadowed_key, tag, aad, threads_amount);
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_decrypt_parallel(const context& ctx,
+                            const char* cipher_data, size_t len, char* plain_data,
+                            const std::string& shadowed_key,
+                            const aes_tag_type& tag,
+                            const std::string& aad,
+                            size_t threads_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::gcm_key_material key_material;
+        impl::derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        impl::aes_gcm_parallel cipher(key_material.key, key_material.iv, ctx().headerless_aead_cipher());
+        cipher.decrypt(aad.data(), aad.size(), cipher_data, len, plain_data, tag, threads_amount);
+        return len;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+salted_key_type aes_create_salted_key(const context& ctx, const std::string& key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
+
+        aes_salt_type salt;
+        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)salt.data(), salt.size()), "Can't get random data for salt");
+
+        std::string salt_str { salt.data(), salt.size() };
+        return { impl::create_salted_key(ctx, key, salt_str, 0), salt };
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_get_salted_key(const std::string& key, const std::string& salt)
+{
+    try
+    {
+        return get_legacy_salted_key(key, salt);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_get_salted_key(const std::string& key, const aes_salt_type& salt)
+{
+    try
+    {
+        return get_legacy_salted_key(key, std::string { salt.data(), salt.size() });
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_get_salted_key(const context& ctx, const std::string& key, const std::string& salt)
+{
+    try
+    {
+        return impl::get_salted_key(ctx, key, salt, 0);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_get_salted_key(const context& ctx, const std::string& key, const aes_salt_type& salt)
+{
+    return aes_get_salted_key(ctx, key, std::string { salt.data(), salt.size() });
+}
+
+salted_key_cache_stat aes_get_salted_key_cache_stat(const context& ctx)
+{
+    salted_key_cache_stat result;
+
+    auto cache = ctx.salted_key_cache();
+    if (cache)
+    {
+        result.hits = cache->hits();
+        result.misses = cache->misses();
+        result.size = cache->size();
+    }
+    return result;
+}
+
+void aes_clear_salted_key_cache(const context& ctx)
+{
+    auto cache = ctx.salted_key_cache();
+    if (cache)
+        cache->clear();
+}
+
+std::string aes_encrypt(const context& ctx,
+                        const std::string& plain_data, const std::string& key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::aes_block cipher;
+        std::vector<char> result = cipher.encrypt(impl::sha512::hash(key), plain_data.data(), plain_data.size());
+        return { result.data(), result.size() };
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_encrypt(const context& ctx,
+                        const std::string& plain_data, const std::string& key,
+                        std::function<std::string(const std::string& key, const std::string& cipher_data)> create_check_tag,
+                        std::string& created_check_tag)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::aes_block cipher;
+        std::string result_str;
+        {
+            std::vector<char> result = cipher.encrypt(impl::sha512::hash(key), plain_data.data(), plain_data.size());
+            result_str = { result.data(), result.size() };
+        }
+        created_check_tag = create_check_tag(key, result_str);
+        return result_str;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_decrypt(const context& ctx,
+                        const std::string& cipher_data, const std::string& key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::aes_block cipher;
+        std::vector<char> result = cipher.decrypt(impl::sha512::hash(key), cipher_data.data(), cipher_data.size());
+        return { result.data(), result.size() };
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_decrypt(const context& ctx,
+                        const std::string& cipher_data, const std::string& key,
+                        const std::string& check_tag,
+                        std::function<std::string(const std::string& key, const std::string& cipher_data)> create_check_tag)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::aes_block cipher;
+        auto input_check_tag = create_check_tag(key, cipher_data);
+        if (check_tag != input_check_tag)
+            return {};
+
+        std::vector<char> result = cipher.decrypt(impl::sha512::hash(key), cipher_data.data(), cipher_data.size());
+        return { result.data(), result.size() };
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_encrypt(const context& ctx,
+                        const std::string& plain_data, const std::string& key,
+                        aes_hmac_tag_type& created_check_tag)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        auto key_hash = impl::sha512::hash(key);
+
+        auto mac_key = cbc_mac_key(key_hash);
+        impl::hmac_sha256 mac(mac_key.data(), mac_key.data_size());
+        OPENSSL_cleanse(mac_key.data(), mac_key.data_size());
+
+        impl::aes_block_stream cipher(true);
+        cipher.init(key_hash);
+
+        std::string result(plain_data.size() + aes_size<aes_128bit_type>(), '\0');
+
+        // MAC is updated while cipher data is hot in cache
+        const char* pplain = plain_data.data();
+        char* presult = &result[0];
+        size_t pos = 0;
+        for (size_t offset = 0; offset < plain_data.size(); offset += CBC_MAC_PIECE_SIZE)
+        {
+            size_t len = cipher.process(pplain + offset, std::min(CBC_MAC_PIECE_SIZE, plain_data.size() - offset), presult + pos);
+            mac.write(presult + pos, len);
+            pos += len;
+        }
+        size_t len = cipher.finalize(presult + pos);
+        mac.write(presult + pos, len);
+        pos += len;
+
+        result.resize(pos);
+
+        auto tag = mac.result();
+        std::memcpy(created_check_tag.data(), tag.data(), created_check_tag.size());
+
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_decrypt(const context& ctx,
+                        const std::string& cipher_data, const std::string& key,
+                        const aes_hmac_tag_type& check_tag)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        auto key_hash = impl::sha512::hash(key);
+
+        // Tampered data are rejected without decryption
+        {
+            auto mac_key = cbc_mac_key(key_hash);
+            impl::hmac_sha256 mac(mac_key.data(), mac_key.data_size());
+            OPENSSL_cleanse(mac_key.data(), mac_key.data_size());
+
+            mac.write(cipher_data.data(), cipher_data.size());
+            auto tag = mac.result();
+
+            if (CRYPTO_memcmp(tag.data(), check_tag.data(), check_tag.size()))
+                return {};
+        }
+
+        impl::aes_block cipher;
+        std::vector<char> result = cipher.decrypt(key_hash, cipher_data.data(), cipher_data.size());
+        return { result.data(), result.size() };
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+std::string aes_decrypt(const context& ctx,
+                        const std::string& cipher_data, const std::string& key,
+                        size_t threads_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::aes_cbc_parallel cipher(impl::sha512::hash(key));
+
+        std::string result(cipher_data.size(), '\0');
+        result.resize(cipher.decrypt(cipher_data.data(), cipher_data.size(), &result[0], threads_amount));
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+
+    return {};
+}
+
+aes_cbc_cipher::aes_cbc_cipher(const context& ctx, const std::string& key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
+
+        auto key_hash = impl::sha512::hash(key);
+        _encryptor = std::make_unique<impl::aes_block_session>(key_hash, true);
+        _decryptor = std::make_unique<impl::aes_block_session>(key_hash, false);
+        OPENSSL_cleanse(key_hash.data(), key_hash.data_size());
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_cbc_cipher::~aes_cbc_cipher()
+{
+}
+
+std::string aes_cbc_cipher::encrypt(const std::string& plain_data)
+{
+    try
+    {
+        std::string result(plain_data.size() + aes_size<aes_128bit_type>(), '\0');
+        result.resize(_encryptor->process(plain_data.data(), plain_data.size(), &result[0]));
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_cbc_cipher::encrypt(const char* plain_data, size_t len, char* cipher_data)
+{
+    try
+    {
+        return _encryptor->process(plain_data, len, cipher_data);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+std::string aes_cbc_cipher::decrypt(const std::string& cipher_data)
+{
+    try
+    {
+        std::string result(cipher_data.size(), '\0');
+        result.resize(_decryptor->process(cipher_data.data(), cipher_data.size(), &result[0]));
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_cbc_cipher::decrypt(const char* cipher_data, size_t len, char* plain_data)
+{
+    try
+    {
+        return _decryptor->process(cipher_data, len, plain_data);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+aes_cbc_encryption_stream::aes_cbc_encryption_stream(const context& ctx)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::aes_block_stream>(true);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_cbc_encryption_stream::~aes_cbc_encryption_stream()
 {
-    return impl::create_from_string<aes_128bit_type>(tag.data(), tag.size());
 }
 
-aes_encryption_stream::aes_encryption_stream(const context& ctx,
-                                             const std::string& default_shadowed_key,
-                                             const std::string& default_aad)
+void aes_cbc_encryption_stream::start(const std::string& key)
 {
     try
     {
-        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
 
-        _impl = std::make_unique<impl::__aes_encryption_stream>(ctx, default_shadowed_key, default_aad);
+        _impl->init(impl::sha512::hash(key));
     }
     catch (std::exception& e)
     {
@@ -39,15 +900,13 @@ aes_encryption_stream::aes_encryption_stream(const context& ctx,
     }
 }
 
-aes_encryption_stream::~aes_encryption_stream()
-{
-}
-
-std::string aes_encryption_stream::start(const std::string& shadowed_key, const std::string& aad)
+std::string aes_cbc_encryption_stream::encrypt(const std::string& plain_chunk)
 {
     try
     {
-        return _impl->start(shadowed_key, aad);
+        std::string result(plain_chunk.size() + aes_size<aes_128bit_type>(), '\0');
+        result.resize(_impl->process(plain_chunk.data(), plain_chunk.size(), &result[0]));
+        return result;
     }
     catch (std::exception& e)
     {
@@ -56,24 +915,26 @@ std::string aes_encryption_stream::start(const std::string& shadowed_key, const
     return {};
 }
 
-std::string aes_encryption_stream::encrypt(const std::string& plain_chunk)
+size_t aes_cbc_encryption_stream::encrypt(const char* plain_chunk, size_t len, char* cipher_chunk)
 {
     try
     {
-        return _impl->encrypt(plain_chunk);
+        return _impl->process(plain_chunk, len, cipher_chunk);
     }
     catch (std::exception& e)
     {
         SSL_HELPERS_ERROR(e.what());
     }
-    return {};
+    return 0;
 }
 
-aes_tag_type aes_encryption_stream::finalize()
+std::string aes_cbc_encryption_stream::finalize()
 {
     try
     {
-        return _impl->finalize();
+        std::string result(aes_size<aes_128bit_type>(), '\0');
+        result.resize(_impl->finalize(&result[0]));
+        return result;
     }
     catch (std::exception& e)
     {
@@ -82,15 +943,13 @@ aes_tag_type aes_encryption_stream::finalize()
     return {};
 }
 
-aes_decryption_stream::aes_decryption_stream(const context& ctx,
-                                             const std::string& default_shadowed_key,
-                                             const std::string& default_aad)
+aes_cbc_decryption_stream::aes_cbc_decryption_stream(const context& ctx)
 {
     try
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        _impl = std::make_unique<impl::__aes_decryption_stream>(ctx, default_shadowed_key, default_aad);
+        _impl = std::make_unique<impl::aes_block_stream>(false);
     }
     catch (std::exception& e)
     {
@@ -98,15 +957,17 @@ aes_decryption_stream::aes_decryption_stream(const context& ctx,
     }
 }
 
-aes_decryption_stream::~aes_decryption_stream()
+aes_cbc_decryption_stream::~aes_cbc_decryption_stream()
 {
 }
 
-void aes_decryption_stream::start(const std::string& shadowed_key, const std::string& aad)
+void aes_cbc_decryption_stream::start(const std::string& key)
 {
     try
     {
-        _impl->start(shadowed_key, aad);
+        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
+
+        _impl->init(impl::sha512::hash(key));
     }
     catch (std::exception& e)
     {
@@ -114,11 +975,13 @@ void aes_decryption_stream::start(const std::string& shadowed_key, const std::st
     }
 }
 
-std::string aes_decryption_stream::decrypt(const std::string& cipher_chunk)
+std::string aes_cbc_decryption_stream::decrypt(const std::string& cipher_chunk)
 {
     try
     {
-        return _impl->decrypt(cipher_chunk);
+        std::string result(cipher_chunk.size() + aes_size<aes_128bit_type>(), '\0');
+        result.resize(_impl->process(cipher_chunk.data(), cipher_chunk.size(), &result[0]));
+        return result;
     }
     catch (std::exception& e)
     {
@@ -127,43 +990,42 @@ std::string aes_decryption_stream::decrypt(const std::string& cipher_chunk)
     return {};
 }
 
-void aes_decryption_stream::finalize(const aes_tag_type& tag)
+size_t aes_cbc_decryption_stream::decrypt(const char* cipher_chunk, size_t len, char* plain_chunk)
 {
     try
     {
-        _impl->finalize(tag);
+        return _impl->process(cipher_chunk, len, plain_chunk);
     }
     catch (std::exception& e)
     {
         SSL_HELPERS_ERROR(e.what());
     }
+    return 0;
 }
 
-void aes_decryption_stream::finalize()
+std::string aes_cbc_decryption_stream::finalize()
 {
     try
     {
-        _impl->finalize({ 0 });
+        std::string result(aes_size<aes_128bit_type>(), '\0');
+        result.resize(_impl->finalize(&result[0]));
+        return result;
     }
     catch (std::exception& e)
     {
         SSL_HELPERS_ERROR(e.what());
     }
+    return {};
 }
 
-salted_key_type aes_create_salted_key(const context& ctx, const std::string& key)
+aes_batch_type aes_encrypt_batch(const context& ctx,
+                                 const aes_batch_type& plain_batch, const std::string& key)
 {
     try
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
-
-        aes_salt_type salt;
-        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)salt.data(), salt.size()), "Can't get random data for salt");
-
-        std::string salt_str { salt.data(), salt.size() };
-        return { create_pbkdf2_512(key, salt_str), salt };
+        return impl::batch_encrypt(plain_batch, key);
     }
     catch (std::exception& e)
     {
@@ -173,14 +1035,14 @@ salted_key_type aes_create_salted_key(const context& ctx, const std::string& key
     return {};
 }
 
-std::string aes_get_salted_key(const std::string& key, const std::string& salt)
+aes_batch_type aes_decrypt_batch(const context& ctx,
+                                 const aes_batch_type& cipher_batch, const std::string& key)
 {
     try
     {
-        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
-        SSL_HELPERS_ASSERT(!salt.empty(), "Salt required");
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        return create_pbkdf2_512(key, salt);
+        return impl::batch_decrypt(cipher_batch, key);
     }
     catch (std::exception& e)
     {
@@ -190,21 +1052,16 @@ std::string aes_get_salted_key(const std::string& key, const std::string& salt)
     return {};
 }
 
-std::string aes_get_salted_key(const std::string& key, const aes_salt_type& salt)
-{
-    return aes_get_salted_key(key, std::string { salt.data(), salt.size() });
-}
-
-std::string aes_encrypt(const context& ctx,
-                        const std::string& plain_data, const std::string& key)
+aes_batch_type aes_encrypt_gcm_batch(const context& ctx,
+                                     const aes_batch_type& plain_batch,
+                                     const std::string& shadowed_key,
+                                     const std::string& aad)
 {
     try
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        impl::aes_block cipher;
-        std::vector<char> result = cipher.encrypt(impl::sha512::hash(key), plain_data.data(), plain_data.size());
-        return { result.data(), result.size() };
+        return impl::batch_gcm_encrypt(plain_batch, shadowed_key, aad, ctx().headerless_aead_cipher());
     }
     catch (std::exception& e)
     {
@@ -214,23 +1071,16 @@ std::string aes_encrypt(const context& ctx,
     return {};
 }
 
-std::string aes_encrypt(const context& ctx,
-                        const std::string& plain_data, const std::string& key,
-                        std::function<std::string(const std::string& key, const std::string& cipher_data)> create_check_tag,
-                        std::string& created_check_tag)
+aes_batch_type aes_decrypt_gcm_batch(const context& ctx,
+                                     const aes_batch_type& cipher_batch,
+                                     const std::string& shadowed_key,
+                                     const std::string& aad)
 {
     try
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        impl::aes_block cipher;
-        std::string result_str;
-        {
-            std::vector<char> result = cipher.encrypt(impl::sha512::hash(key), plain_data.data(), plain_data.size());
-            result_str = { result.data(), result.size() };
-        }
-        created_check_tag = create_check_tag(key, result_str);
-        return result_str;
+        return impl::batch_gcm_decrypt(cipher_batch, shadowed_key, aad, ctx().headerless_aead_cipher());
     }
     catch (std::exception& e)
     {
@@ -240,110 +1090,75 @@ std::string aes_encrypt(const context& ctx,
     return {};
 }
 
-std::string aes_decrypt(const context& ctx,
-                        const std::string& cipher_data, const std::string& key)
+size_t aes_flip_cipher_size(size_t plain_len, const std::string& marker)
+{
+    return impl::flip_format::cipher_size(plain_len, marker.size());
+}
+
+size_t aes_flip_session_max_size(const std::string& marker)
+{
+    return impl::flip_format::session_max_size(marker.size());
+}
+
+size_t aes_flip_plain_size(size_t cipher_len, const std::string& marker)
 {
     try
     {
-        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
-
-        impl::aes_block cipher;
-        std::vector<char> result = cipher.decrypt(impl::sha512::hash(key), cipher_data.data(), cipher_data.size());
-        return { result.data(), result.size() };
+        return impl::flip_format::plain_size(cipher_len, marker.size());
     }
     catch (std::exception& e)
     {
         SSL_HELPERS_ERROR(e.what());
     }
-
-    return {};
+    return 0;
 }
 
-std::string aes_decrypt(const context& ctx,
-                        const std::string& cipher_data, const std::string& key,
-                        const std::string& check_tag,
-                        std::function<std::string(const std::string& key, const std::string& cipher_data)> create_check_tag)
+flip_session_type aes_encrypt_flip(const context& ctx,
+                                   const std::string& plain_data,
+                                   const std::string& instant_key,
+                                   const std::string& marker,
+                                   bool add_garbage)
 {
     try
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        impl::aes_block cipher;
-        auto input_check_tag = create_check_tag(key, cipher_data);
-        if (check_tag != input_check_tag)
-            return {};
+        std::string cipher_data(impl::flip_format::cipher_size(plain_data.size(), marker.size()), '\0');
+        std::string session_data(impl::flip_format::session_max_size(marker.size()), '\0');
 
-        std::vector<char> result = cipher.decrypt(impl::sha512::hash(key), cipher_data.data(), cipher_data.size());
-        return { result.data(), result.size() };
+        auto session_len = impl::flip_encrypt(ctx, plain_data.data(), plain_data.size(),
+                                              instant_key, marker, add_garbage,
+                                              &cipher_data[0], &session_data[0]);
+        session_data.resize(session_len);
+
+        return std::make_pair(std::move(cipher_data), std::move(session_data));
     }
     catch (std::exception& e)
     {
         SSL_HELPERS_ERROR(e.what());
     }
-
     return {};
 }
 
-flip_session_type aes_encrypt_flip(const context& ctx,
-                                   const std::string& plain_data,
-                                   const std::string& instant_key,
-                                   const std::string& marker,
-                                   bool add_garbage)
+size_t aes_encrypt_flip(const context& ctx,
+                        const char* plain_data, size_t len,
+                        const std::string& instant_key,
+                        char* cipher_data, char* session_data,
+                        const std::string& marker,
+                        bool add_garbage)
 {
     try
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        std::string session_data;
-
-        auto salted_key = aes_create_salted_key(ctx, instant_key);
-
-        std::string cipher_data;
-        aes_tag_type tag;
-
-        {
-            aes_encryption_stream stream(ctx);
-
-            std::ostringstream out;
-
-            out << stream.start(to_shadow(salted_key.first), marker);
-            out << stream.encrypt(plain_data);
-            tag = stream.finalize();
-
-            cipher_data = out.str();
-        }
-
-        {
-            std::ostringstream out;
-
-            out << marker;
-            const auto& salt = salted_key.second;
-            out.write(salt.data(), salt.size());
-            out.write(tag.data(), tag.size());
-
-            if (add_garbage)
-            {
-                aes_salt_type garbage;
-
-                auto garbage_len = create_random(ctx) % garbage.size() + 1;
-                if (garbage_len > garbage.size())
-                    garbage_len = garbage.size();
-
-                SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)garbage.data(), garbage.size()), "Can't get random data for garbage");
-
-                out.write(garbage.data(), garbage_len);
-            }
-
-            session_data = out.str();
-        }
-
-        return std::make_pair(cipher_data, session_data);
+        return impl::flip_encrypt(ctx, plain_data, len, instant_key, marker, add_garbage,
+                                  cipher_data, session_data);
     }
     catch (std::exception& e)
     {
         SSL_HELPERS_ERROR(e.what());
     }
-    return {};
+    return 0;
 }
 
 std::string aes_decrypt_flip(const context& ctx,
@@ -364,62 +1179,176 @@ std::string aes_decrypt_flip(const context& ctx,
     {
         SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-        aes_salt_type salt;
-        aes_tag_type tag;
+        std::string result(impl::flip_format::plain_size(cipher_data.size(), marker.size()), '\0');
 
-        {
-            std::istringstream in(session_data);
+        impl::flip_decrypt(ctx, cipher_data.data(), cipher_data.size(),
+                           session_data.data(), session_data.size(),
+                           user_key, marker, &result[0]);
+
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
 
-            if (!marker.empty())
-            {
-                std::vector<char> marker_buff(marker.size());
-                in.read(marker_buff.data(), marker_buff.size());
-                SSL_HELPERS_ASSERT(!in.fail(), "Insufficient data");
+std::vector<flip_batch_result_type> aes_decrypt_flip_batch(const context& ctx,
+                                                           const std::vector<flip_session_type>& sessions,
+                                                           const std::vector<std::string>& instant_keys,
+                                                           const std::string& marker,
+                                                           size_t threads_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-                SSL_HELPERS_ASSERT(std::string(marker_buff.data(), marker_buff.size()) == marker, "Invalid marker");
-            }
+        return impl::flip_decrypt_batch(ctx, sessions, instant_keys, marker, threads_amount);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
 
-            in.read(salt.data(), salt.size());
-            SSL_HELPERS_ASSERT(!in.fail(), "Insufficient data");
+size_t aes_decrypt_flip(const context& ctx,
+                        const char* cipher_data, size_t cipher_len,
+                        const char* session_data, size_t session_len,
+                        const std::string& instant_key,
+                        char* plain_data,
+                        const std::string& marker)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-            in.read(tag.data(), tag.size());
-            SSL_HELPERS_ASSERT(!in.fail(), "Insufficient data");
-        }
+        return impl::flip_decrypt(ctx, cipher_data, cipher_len, session_data, session_len,
+                                  instant_key, marker, plain_data);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
 
-        std::ostringstream out;
-        {
-            std::istringstream in(cipher_data);
+aes_flip_encryption_stream::aes_flip_encryption_stream(const context& ctx,
+                                                       const std::string& marker,
+                                                       bool add_garbage)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_flip_encryption_stream>(ctx, marker, add_garbage);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_flip_encryption_stream::~aes_flip_encryption_stream()
+{
+}
+
+std::string aes_flip_encryption_stream::start(const std::string& instant_key)
+{
+    try
+    {
+        return _impl->start(instant_key);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
 
-            if (!marker.empty())
-            {
-                std::vector<char> marker_buff(marker.size());
-                in.read(marker_buff.data(), marker_buff.size());
-                SSL_HELPERS_ASSERT(!in.fail(), "Insufficient data");
+std::string aes_flip_encryption_stream::encrypt(const std::string& plain_chunk)
+{
+    try
+    {
+        std::string result(plain_chunk.size(), '\0');
+        _impl->encrypt(plain_chunk.data(), plain_chunk.size(), &result[0]);
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
 
-                SSL_HELPERS_ASSERT(std::string(marker_buff.data(), marker_buff.size()) == marker, "Invalid marker");
-            }
+size_t aes_flip_encryption_stream::encrypt(const char* plain_chunk, size_t len, char* cipher_chunk)
+{
+    try
+    {
+        return _impl->encrypt(plain_chunk, len, cipher_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
 
-            aes_decryption_stream stream(ctx);
+std::string aes_flip_encryption_stream::finalize()
+{
+    try
+    {
+        std::string session_data(impl::flip_format::session_max_size(_impl->marker().size()), '\0');
+        session_data.resize(_impl->finalize(&session_data[0]));
+        return session_data;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
 
-            auto secret_key = aes_get_salted_key(user_key, salt);
-            stream.start(to_shadow(secret_key), marker);
+aes_flip_decryption_stream::aes_flip_decryption_stream(const context& ctx,
+                                                       const std::string& marker)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
 
-            char buff[1024];
+        _impl = std::make_unique<impl::__aes_flip_decryption_stream>(ctx, marker);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
 
-            for (std::streamsize bytes_read = 1; in.read(buff, sizeof(buff)) || bytes_read > 0;)
-            {
-                bytes_read = in.gcount();
-                if (bytes_read > 0)
-                {
-                    std::string cipher_payload { buff, static_cast<uint32_t>(bytes_read) };
-                    out << stream.decrypt(cipher_payload);
-                }
-            }
+aes_flip_decryption_stream::~aes_flip_decryption_stream()
+{
+}
 
-            stream.finalize(tag);
-        }
+void aes_flip_decryption_stream::start(const std::string& session_data,
+                                       const std::string& instant_key)
+{
+    try
+    {
+        _impl->start(session_data.data(), session_data.size(), instant_key);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
 
-        return out.str();
+std::string aes_flip_decryption_stream::decrypt(const std::string& cipher_chunk)
+{
+    try
+    {
+        std::string result(cipher_chunk.size(), '\0');
+        result.resize(_impl->decrypt(cipher_chunk.data(), cipher_chunk.size(), &result[0]));
+        return result;
     }
     catch (std::exception& e)
     {
@@ -428,4 +1357,29 @@ std::string aes_decrypt_flip(const context& ctx,
     return {};
 }
 
+size_t aes_flip_decryption_stream::decrypt(const char* cipher_chunk, size_t len, char* plain_chunk)
+{
+    try
+    {
+        return _impl->decrypt(cipher_chunk, len, plain_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+void aes_flip_decryption_stream::finalize()
+{
+    try
+    {
+        _impl->finalize();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
 } // namespace ssl_helpers
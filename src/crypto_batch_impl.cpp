@@ -0,0 +1,194 @@
+#include <cstring>
+
+#include <openssl/rand.h>
+
+#include "crypto_batch_impl.h"
+#include "crypto_stream_impl.h"
+#include "aes256.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+
+        using batch_nonce_type = std::array<char, 12>;
+
+        void check_batch(const aes_batch_type& batch)
+        {
+            SSL_HELPERS_ASSERT(!batch.offsets.empty() && !batch.offsets.front(), "Invalid batch");
+            SSL_HELPERS_ASSERT(batch.offsets.back() == batch.data.size(), "Invalid batch");
+            for (size_t ci = 1; ci < batch.offsets.size(); ++ci)
+            {
+                SSL_HELPERS_ASSERT(batch.offsets[ci - 1] <= batch.offsets[ci], "Invalid batch");
+            }
+        }
+
+        batch_nonce_type batch_nonce(const batch_nonce_type& base, size_t index)
+        {
+            batch_nonce_type result = base;
+            uint64_t index_ = index;
+            for (size_t ci = 0; ci < sizeof(index_); ++ci)
+                result[result.size() - 1 - ci] ^= static_cast<char>(index_ >> (8 * ci));
+            return result;
+        }
+
+        constexpr size_t GCM_OVERHEAD = std::tuple_size<batch_nonce_type>::value + aes_size<gcm_tag_type>();
+
+    } // namespace
+
+    aes_batch_type batch_encrypt(const aes_batch_type& plain_batch, const std::string& key)
+    {
+        check_batch(plain_batch);
+
+        constexpr size_t BLOCK_SIZE = aes_size<aes_128bit_type>();
+
+        const size_t amount = plain_batch.size();
+
+        // CBC with padding adds 1..BLOCK_SIZE bytes
+        aes_batch_type result;
+        result.offsets.resize(amount + 1);
+        size_t total = 0;
+        for (size_t ci = 0; ci < amount; ++ci)
+        {
+            total += (plain_batch.item_size(ci) / BLOCK_SIZE + 1) * BLOCK_SIZE;
+        }
+        result.data.resize(total);
+
+        aes_block_session cipher(sha512::hash(key), true);
+
+        size_t pos = 0;
+        for (size_t ci = 0; ci < amount; ++ci)
+        {
+            pos += cipher.process(plain_batch.item_data(ci), plain_batch.item_size(ci), &result.data[pos]);
+            result.offsets[ci + 1] = pos;
+        }
+        SSL_HELPERS_ASSERT(pos == total);
+
+        return result;
+    }
+
+    aes_batch_type batch_decrypt(const aes_batch_type& cipher_batch, const std::string& key)
+    {
+        check_batch(cipher_batch);
+
+        const size_t amount = cipher_batch.size();
+
+        aes_batch_type result;
+        result.offsets.resize(amount + 1);
+        result.data.resize(cipher_batch.data.size());
+
+        aes_block_session cipher(sha512::hash(key), false);
+
+        size_t pos = 0;
+        for (size_t ci = 0; ci < amount; ++ci)
+        {
+            pos += cipher.process(cipher_batch.item_data(ci), cipher_batch.item_size(ci), &result.data[pos]);
+            result.offsets[ci + 1] = pos;
+        }
+        result.data.resize(pos);
+
+        return result;
+    }
+
+    aes_batch_type batch_gcm_encrypt(const aes_batch_type& plain_batch,
+                                     const std::string& shadowed_key, const std::string& aad,
+                                     config::AEAD_CIPHER cipher_type)
+    {
+        check_batch(plain_batch);
+
+        const size_t amount = plain_batch.size();
+
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        batch_nonce_type nonce_base;
+        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)nonce_base.data(), nonce_base.size()), "Can't get random data for nonce");
+
+        aes_batch_type result;
+        result.offsets.resize(amount + 1);
+        result.data.resize(plain_batch.data.size() + amount * GCM_OVERHEAD);
+
+        aes_stream_encryptor cipher(cipher_type);
+        gcm_tag_type tag;
+
+        char* presult = &result.data[0];
+        size_t pos = 0;
+        for (size_t ci = 0; ci < amount; ++ci)
+        {
+            auto nonce = batch_nonce(nonce_base, ci);
+            std::memcpy(presult + pos, nonce.data(), nonce.size());
+            pos += nonce.size();
+
+            cipher.init(key_material.key, nonce.data(), nonce.size());
+            if (!aad.empty())
+                cipher.set_aad(aad.data(), aad.size());
+
+            size_t len = plain_batch.item_size(ci);
+            if (len > 0)
+                pos += cipher.process(plain_batch.item_data(ci), len, presult + pos);
+
+            cipher.finalize(tag);
+            std::memcpy(presult + pos, tag.data(), tag.size());
+            pos += tag.size();
+
+            result.offsets[ci + 1] = pos;
+        }
+
+        return result;
+    }
+
+    aes_batch_type batch_gcm_decrypt(const aes_batch_type& cipher_batch,
+                                     const std::string& shadowed_key, const std::string& aad,
+                                     config::AEAD_CIPHER cipher_type)
+    {
+        check_batch(cipher_batch);
+
+        const size_t amount = cipher_batch.size();
+
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        aes_batch_type result;
+        result.offsets.resize(amount + 1);
+        result.data.resize(cipher_batch.data.size());
+
+        aes_stream_decryptor cipher(cipher_type);
+
+        char* presult = &result.data[0];
+        size_t pos = 0;
+        try
+        {
+            for (size_t ci = 0; ci < amount; ++ci)
+            {
+                const char* pmessage = cipher_batch.item_data(ci);
+                size_t len = cipher_batch.item_size(ci);
+
+                SSL_HELPERS_ASSERT(len >= GCM_OVERHEAD, "Invalid message");
+                len -= GCM_OVERHEAD;
+
+                cipher.init(key_material.key, pmessage, std::tuple_size<batch_nonce_type>::value);
+                pmessage += std::tuple_size<batch_nonce_type>::value;
+                if (!aad.empty())
+                    cipher.set_aad(aad.data(), aad.size());
+
+                if (len > 0)
+                    pos += cipher.process(pmessage, len, presult + pos);
+
+                cipher.finalize_checked(create_from_string<gcm_tag_type>(pmessage + len, aes_size<gcm_tag_type>()));
+
+                result.offsets[ci + 1] = pos;
+            }
+        }
+        catch (std::exception&)
+        {
+            OPENSSL_cleanse(presult, result.data.size());
+            throw;
+        }
+        result.data.resize(pos);
+
+        return result;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+#include <ssl_helpers/crypto_types.h>
+#include <ssl_helpers/config.h>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // AES256-CBC (aes_block compatible) for every message with the same key
+    aes_batch_type batch_encrypt(const aes_batch_type& plain_batch, const std::string& key);
+    aes_batch_type batch_decrypt(const aes_batch_type& cipher_batch, const std::string& key);
+
+    // AES256-GCM with own nonce for every message. Cipher message:
+    //
+    //     |nonce (12)|cipher data|tag (16)|
+    //
+    // Nonce is random (per batch) value XOR message index.
+    // Cipher is config::AEAD_CIPHER (AES256-GCM by default)
+    aes_batch_type batch_gcm_encrypt(const aes_batch_type& plain_batch,
+                                     const std::string& shadowed_key, const std::string& aad,
+                                     config::AEAD_CIPHER cipher_type = config::AEAD_CIPHER_aes256_gcm);
+    aes_batch_type batch_gcm_decrypt(const aes_batch_type& cipher_batch,
+                                     const std::string& shadowed_key, const std::string& aad,
+                                     config::AEAD_CIPHER cipher_type = config::AEAD_CIPHER_aes256_gcm);
+
+} // namespace impl
+} // namespace ssl_helpers
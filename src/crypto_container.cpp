@@ -0,0 +1,338 @@
+#include <cstring>
+
+#include <ssl_helpers/crypto_container.h>
+
+#include "crypto_container_impl.h"
+
+
+namespace ssl_helpers {
+
+size_t aes_container_header_size()
+{
+    return impl::container_header::SIZE;
+}
+
+size_t aes_container_default_segment_size()
+{
+    return impl::container_default_segment_size();
+}
+
+aes_container_encryptor::aes_container_encryptor(const context& ctx,
+                                                 const std::string& shadowed_key,
+                                                 size_t segment_size)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_container_encryptor>(ctx, shadowed_key, segment_size);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_container_encryptor::~aes_container_encryptor()
+{
+}
+
+std::string aes_container_encryptor::start()
+{
+    try
+    {
+        return _impl->start();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_encryptor::encrypt(const std::string& plain_chunk)
+{
+    try
+    {
+        return _impl->encrypt(plain_chunk.data(), plain_chunk.size());
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_encryptor::finalize()
+{
+    try
+    {
+        return _impl->finalize();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+aes_container_decryptor::aes_container_decryptor(const context& ctx,
+                                                 const std::string& shadowed_key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_container_decryptor>(ctx, shadowed_key);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_container_decryptor::~aes_container_decryptor()
+{
+}
+
+void aes_container_decryptor::start(const std::string& header)
+{
+    try
+    {
+        _impl->start(header);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+size_t aes_container_decryptor::segment_size() const
+{
+    try
+    {
+        return _impl->segment_size();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+uint64_t aes_container_decryptor::plain_size(uint64_t container_size) const
+{
+    try
+    {
+        return _impl->plain_size(container_size);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_decryptor::decrypt(const std::string& cipher_chunk)
+{
+    try
+    {
+        return _impl->decrypt(cipher_chunk.data(), cipher_chunk.size());
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_decryptor::finalize()
+{
+    try
+    {
+        return _impl->finalize();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_decryptor::decrypt_range(const aes_container_reader_type& read,
+                                                   uint64_t container_size,
+                                                   uint64_t offset, size_t len)
+{
+    try
+    {
+        return _impl->decrypt_range(read, container_size, offset, len);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_encrypt(const context& ctx,
+                                  const std::string& plain_data,
+                                  const std::string& shadowed_key,
+                                  size_t segment_size,
+                                  size_t threads_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        return impl::container_encrypt(ctx, plain_data.data(), plain_data.size(),
+                                       shadowed_key, segment_size, threads_amount);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_decrypt(const context& ctx,
+                                  const std::string& container_data,
+                                  const std::string& shadowed_key,
+                                  size_t threads_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        return impl::container_decrypt(ctx, container_data.data(), container_data.size(),
+                                       shadowed_key, threads_amount);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_container_decrypt_range(const context& ctx,
+                                        const std::string& container_data,
+                                        const std::string& shadowed_key,
+                                        uint64_t offset, size_t len)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::__aes_container_decryptor decryptor(ctx, shadowed_key);
+        decryptor.start(container_data.substr(0, impl::container_header::SIZE));
+        return decryptor.decrypt_range(
+            [&container_data](uint64_t offset, char* buffer, size_t len) -> size_t {
+                if (offset >= container_data.size())
+                    return 0;
+                len = std::min<size_t>(len, container_data.size() - offset);
+                std::memcpy(buffer, container_data.data() + offset, len);
+                return len;
+            },
+            container_data.size(), offset, len);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+bool aes_encrypt_file(const context& ctx,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      const aes_file_progress_type& progress)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        return impl::container_encrypt_file(ctx, in_path, out_path, shadowed_key, progress);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+bool aes_encrypt_file(const context& ctx,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      AES_DIGEST digest,
+                      std::string& plain_digest,
+                      const aes_file_progress_type& progress)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::digest_encoder encoder(digest);
+        SSL_HELPERS_ASSERT(encoder.enabled(), "Digest type required");
+
+        if (!impl::container_encrypt_file(ctx, in_path, out_path, shadowed_key, progress, &encoder))
+            return false;
+
+        plain_digest = encoder.result();
+        return true;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+bool aes_decrypt_file(const context& ctx,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      const aes_file_progress_type& progress)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        return impl::container_decrypt_file(ctx, in_path, out_path, shadowed_key, progress);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+bool aes_decrypt_file(const context& ctx,
+                      const std::string& in_path,
+                      const std::string& out_path,
+                      const std::string& shadowed_key,
+                      AES_DIGEST digest,
+                      std::string& plain_digest,
+                      const aes_file_progress_type& progress)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        impl::digest_encoder encoder(digest);
+        SSL_HELPERS_ASSERT(encoder.enabled(), "Digest type required");
+
+        if (!impl::container_decrypt_file(ctx, in_path, out_path, shadowed_key, progress, &encoder))
+            return false;
+
+        plain_digest = encoder.result();
+        return true;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+} // namespace ssl_helpers
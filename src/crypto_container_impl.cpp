@@ -0,0 +1,831 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "crypto_container_impl.h"
+#include "crypto_stream_impl.h"
+#include "parallel_helper.h"
+#include "pipeline_helper.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+
+        constexpr const char* CONTAINER_MAGIC = "BSHC";
+        constexpr size_t CONTAINER_MAGIC_SIZE = 4;
+
+        constexpr size_t DEFAULT_SEGMENT_SIZE = 64 * 1024;
+        constexpr size_t MAX_SEGMENT_SIZE = 0x7fffffff;
+
+        // Enough to keep read, encryption and write busy
+        constexpr size_t FILE_PIPELINE_SLOTS = 4;
+        // Several small segments are passed between threads at once
+        // to reduce synchronization overhead
+        constexpr size_t FILE_PIPELINE_SLOT_SIZE = 256 * 1024;
+
+        void write_u32(char* data, uint32_t value)
+        {
+            for (size_t ci = 0; ci < 4; ++ci)
+                data[ci] = static_cast<char>(value >> (8 * (3 - ci)));
+        }
+
+        uint32_t read_u32(const char* data)
+        {
+            uint32_t result = 0;
+            for (size_t ci = 0; ci < 4; ++ci)
+                result = (result << 8) | static_cast<uint8_t>(data[ci]);
+            return result;
+        }
+
+        size_t get_segment_size(size_t segment_size)
+        {
+            if (!segment_size)
+                return DEFAULT_SEGMENT_SIZE;
+
+            SSL_HELPERS_ASSERT(segment_size <= MAX_SEGMENT_SIZE, "Segment size is too large");
+            return segment_size;
+        }
+
+        container_header create_header(config::AEAD_CIPHER cipher, size_t segment_size,
+                                       config::COMPRESSION compression)
+        {
+            container_header header;
+            header.cipher = static_cast<uint8_t>(cipher);
+            SSL_HELPERS_ASSERT(header.cipher < config::AEAD_CIPHER_auto, "Cipher is not selected");
+            header.compression = static_cast<uint8_t>(compression);
+            header.segment_size = static_cast<uint32_t>(get_segment_size(segment_size));
+
+            SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)header.salt.data(), header.salt.size()), "Can't get random data for salt");
+            SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)header.nonce_prefix.data(), header.nonce_prefix.size()), "Can't get random data for nonce");
+            return header;
+        }
+
+        gcm_key_type derive_segments_key(const gcm_key_type& key, const aes_salt_type& salt)
+        {
+            static const std::string label { "BSHC segments" };
+
+            std::string kdf_data;
+            kdf_data.reserve(label.size() + salt.size());
+            kdf_data.append(label);
+            kdf_data.append(salt.data(), salt.size());
+
+            unsigned char segments_key[EVP_MAX_MD_SIZE];
+            unsigned int segments_key_len = 0;
+            SSL_HELPERS_ASSERT(HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+                                    (const unsigned char*)kdf_data.data(), kdf_data.size(),
+                                    segments_key, &segments_key_len),
+                               "Can't derive segments key");
+
+            gcm_key_type result;
+            static_assert(sizeof(result) == 256 / 8, "Invalid key size");
+            std::memcpy(result.data(), segments_key, result.size());
+            OPENSSL_cleanse(segments_key, sizeof(segments_key));
+            return result;
+        }
+
+        std::string compress(config::COMPRESSION compression, const char* data, size_t len)
+        {
+            std::string result;
+            auto output = [&](const char* compressed_data, size_t compressed_len) {
+                result.append(compressed_data, compressed_len);
+            };
+
+            data_compressor compressor(compression);
+            compressor.write(data, len, output);
+            compressor.finish(output);
+            return result;
+        }
+
+        std::string decompress(config::COMPRESSION compression, const char* data, size_t len)
+        {
+            std::string result;
+            auto output = [&](const char* plain_data, size_t plain_len) {
+                result.append(plain_data, plain_len);
+            };
+
+            data_decompressor decompressor(compression);
+            decompressor.write(data, len, output);
+            decompressor.finish(output);
+            return result;
+        }
+
+        size_t get_slot_segments(size_t segment_size)
+        {
+            return std::max<size_t>(1, FILE_PIPELINE_SLOT_SIZE / segment_size);
+        }
+
+        uint64_t get_file_size(std::ifstream& input)
+        {
+            input.seekg(0, std::ifstream::end);
+            auto size = input.tellg();
+            input.seekg(0, std::ifstream::beg);
+            SSL_HELPERS_ASSERT(size >= 0 && input, "Can't read input file");
+            return static_cast<uint64_t>(size);
+        }
+
+        // Output file is removed if it was not completed
+        template <typename Pipeline>
+        bool write_file(const std::string& out_path, Pipeline&& pipeline)
+        {
+            std::ofstream output(out_path, std::ofstream::binary | std::ofstream::trunc);
+            SSL_HELPERS_ASSERT(output, "Can't open output file");
+
+            bool completed = false;
+            try
+            {
+                completed = pipeline(output);
+                if (completed)
+                {
+                    output.close();
+                    SSL_HELPERS_ASSERT(output, "Can't write output file");
+                }
+            }
+            catch (...)
+            {
+                output.close();
+                std::remove(out_path.c_str());
+                throw;
+            }
+
+            if (!completed)
+            {
+                output.close();
+                std::remove(out_path.c_str());
+            }
+            return completed;
+        }
+
+    } // namespace
+
+    size_t container_default_segment_size()
+    {
+        return DEFAULT_SEGMENT_SIZE;
+    }
+
+    std::string container_header::serialize() const
+    {
+        std::string result(SIZE, '\0');
+
+        char* pdata = &result[0];
+        std::memcpy(pdata, CONTAINER_MAGIC, CONTAINER_MAGIC_SIZE);
+        pdata[4] = static_cast<char>(version);
+        pdata[5] = static_cast<char>(cipher);
+        pdata[6] = static_cast<char>(flags);
+        pdata[7] = static_cast<char>(compression);
+        write_u32(pdata + 8, segment_size);
+        std::memcpy(pdata + 12, salt.data(), salt.size());
+        std::memcpy(pdata + 12 + salt.size(), nonce_prefix.data(), nonce_prefix.size());
+
+        return result;
+    }
+
+    container_header container_header::parse(const char* data, size_t len)
+    {
+        SSL_HELPERS_ASSERT(data && len >= SIZE, "Insufficient data");
+        SSL_HELPERS_ASSERT(!std::memcmp(data, CONTAINER_MAGIC, CONTAINER_MAGIC_SIZE), "Invalid container");
+
+        container_header header;
+        header.version = static_cast<uint8_t>(data[4]);
+        header.cipher = static_cast<uint8_t>(data[5]);
+        header.flags = static_cast<uint8_t>(data[6]);
+        header.compression = static_cast<uint8_t>(data[7]);
+        header.segment_size = read_u32(data + 8);
+        std::memcpy(header.salt.data(), data + 12, header.salt.size());
+        std::memcpy(header.nonce_prefix.data(), data + 12 + header.salt.size(), header.nonce_prefix.size());
+
+        SSL_HELPERS_ASSERT(header.version == VERSION, "Unsupported container version");
+        SSL_HELPERS_ASSERT(header.cipher < config::AEAD_CIPHER_auto, "Unsupported cipher");
+        SSL_HELPERS_ASSERT(is_supported_compression(static_cast<config::COMPRESSION>(header.compression)), "Unsupported compression");
+        SSL_HELPERS_ASSERT(header.segment_size > 0 && header.segment_size <= MAX_SEGMENT_SIZE, "Invalid segment size");
+
+        return header;
+    }
+
+    container_segments::container_segments(const gcm_key_type& key, const container_header& header)
+        : _key(derive_segments_key(key, header.salt))
+        , _header(header)
+        , _aad(header.serialize())
+    {
+    }
+
+    container_segments::~container_segments()
+    {
+        OPENSSL_cleanse(_key.data(), _key.size());
+    }
+
+    uint64_t container_segments::segments_count(uint64_t container_size) const
+    {
+        SSL_HELPERS_ASSERT(container_size > container_header::SIZE, "Invalid container size");
+
+        const uint64_t body_size = container_size - container_header::SIZE;
+        const uint64_t count = (body_size + cipher_segment_size() - 1) / cipher_segment_size();
+        const uint64_t last_size = body_size - (count - 1) * cipher_segment_size();
+
+        SSL_HELPERS_ASSERT(last_size >= aes_size<gcm_tag_type>(), "Invalid container size");
+        return count;
+    }
+
+    uint64_t container_segments::plain_size(uint64_t container_size) const
+    {
+        return container_size - container_header::SIZE - segments_count(container_size) * aes_size<gcm_tag_type>();
+    }
+
+    uint64_t container_segments::segment_offset(uint64_t index) const
+    {
+        return container_header::SIZE + index * cipher_segment_size();
+    }
+
+    container_nonce_type container_segments::nonce(uint64_t index, bool last) const
+    {
+        SSL_HELPERS_ASSERT(index <= 0xffffffffULL, "Too many segments");
+
+        container_nonce_type result;
+        std::memcpy(result.data(), _header.nonce_prefix.data(), _header.nonce_prefix.size());
+        write_u32(result.data() + _header.nonce_prefix.size(), static_cast<uint32_t>(index));
+        result[result.size() - 1] = last ? 1 : 0;
+        return result;
+    }
+
+    void container_segments::encrypt(aes_stream_encryptor& cipher, uint64_t index, bool last,
+                                     const char* plain_data, size_t len, char* cipher_data) const
+    {
+        SSL_HELPERS_ASSERT(len <= segment_size() && (last || len == segment_size()), "Invalid segment size");
+
+        auto nonce_ = nonce(index, last);
+        cipher.init(_key, nonce_.data(), nonce_.size());
+        cipher.set_aad(_aad.data(), _aad.size());
+        if (len > 0)
+            cipher.process(plain_data, len, cipher_data);
+
+        gcm_tag_type tag;
+        cipher.finalize(tag);
+        std::memcpy(cipher_data + len, tag.data(), tag.size());
+    }
+
+    size_t container_segments::decrypt(aes_stream_decryptor& cipher, uint64_t index, bool last,
+                                       const char* cipher_data, size_t len, char* plain_data) const
+    {
+        SSL_HELPERS_ASSERT(len >= aes_size<gcm_tag_type>(), "Insufficient data");
+
+        const size_t plain_len = len - aes_size<gcm_tag_type>();
+        SSL_HELPERS_ASSERT(plain_len <= segment_size() && (last || plain_len == segment_size()), "Invalid segment size");
+
+        auto nonce_ = nonce(index, last);
+        cipher.init(_key, nonce_.data(), nonce_.size());
+        cipher.set_aad(_aad.data(), _aad.size());
+        if (plain_len > 0)
+            cipher.process(cipher_data, plain_len, plain_data);
+
+        try
+        {
+            cipher.finalize_checked(create_from_string<gcm_tag_type>(cipher_data + plain_len, aes_size<gcm_tag_type>()));
+        }
+        catch (std::exception&)
+        {
+            OPENSSL_cleanse(plain_data, plain_len);
+            throw;
+        }
+        return plain_len;
+    }
+
+    __aes_container_encryptor::__aes_container_encryptor(const context& ctx,
+                                                         const std::string& shadowed_key, size_t segment_size)
+        : _segment_size(get_segment_size(segment_size))
+        , _cipher_type(ctx().aead_cipher())
+        , _compression(ctx().compression())
+        , _cipher(_cipher_type)
+    {
+        derive_gcm_key_from_shadow(shadowed_key, _key_material);
+    }
+
+    std::string __aes_container_encryptor::start()
+    {
+        auto header = create_header(_cipher_type, _segment_size, _compression);
+        _segments = std::make_unique<container_segments>(_key_material.key, header);
+        _compressor.reset();
+        if (_compression != config::COMPRESSION_none)
+            _compressor = std::make_unique<data_compressor>(_compression);
+        _pending.clear();
+        _pending.reserve(_segment_size);
+        _segment_index = 0;
+        return header.serialize();
+    }
+
+    std::string __aes_container_encryptor::encrypt(const char* plain_chunk, size_t len)
+    {
+        SSL_HELPERS_ASSERT(_segments, "Invalid state");
+        SSL_HELPERS_ASSERT(plain_chunk || !len, "Buffer required");
+
+        std::string result;
+        if (_compressor)
+        {
+            _compressor->write(plain_chunk, len, [&](const char* data, size_t data_len) {
+                append(data, data_len, result);
+            });
+        }
+        else
+        {
+            result.reserve(((_pending.size() + len) / _segment_size) * _segments->cipher_segment_size());
+            append(plain_chunk, len, result);
+        }
+
+        return result;
+    }
+
+    std::string __aes_container_encryptor::finalize()
+    {
+        SSL_HELPERS_ASSERT(_segments, "Invalid state");
+
+        std::string result;
+        if (_compressor)
+        {
+            _compressor->finish([&](const char* data, size_t data_len) {
+                append(data, data_len, result);
+            });
+            _compressor.reset();
+        }
+        flush(_pending.data(), _pending.size(), true, result);
+
+        OPENSSL_cleanse(&_pending[0], _pending.size());
+        _pending.clear();
+        _segments.reset();
+
+        return result;
+    }
+
+    void __aes_container_encryptor::append(const char* data, size_t len, std::string& output)
+    {
+        while (len > 0)
+        {
+            // Full segment is flushed only if there are more data after it
+            if (_pending.size() == _segment_size)
+            {
+                flush(_pending.data(), _pending.size(), false, output);
+                _pending.clear();
+            }
+
+            if (_pending.empty() && len > _segment_size)
+            {
+                flush(data, _segment_size, false, output);
+                data += _segment_size;
+                len -= _segment_size;
+                continue;
+            }
+
+            size_t piece = std::min(_segment_size - _pending.size(), len);
+            _pending.append(data, piece);
+            data += piece;
+            len -= piece;
+        }
+    }
+
+    void __aes_container_encryptor::flush(const char* plain_data, size_t len, bool last, std::string& output)
+    {
+        size_t pos = output.size();
+        output.resize(pos + len + aes_size<gcm_tag_type>());
+        _segments->encrypt(_cipher, _segment_index++, last, plain_data, len, &output[pos]);
+    }
+
+    __aes_container_decryptor::__aes_container_decryptor(const context&,
+                                                         const std::string& shadowed_key)
+    {
+        derive_gcm_key_from_shadow(shadowed_key, _key_material);
+    }
+
+    void __aes_container_decryptor::start(const std::string& header)
+    {
+        _segments = std::make_unique<container_segments>(_key_material.key, container_header::parse(header.data(), header.size()));
+        if (!_cipher || _cipher_type != _segments->cipher())
+        {
+            _cipher = std::make_unique<aes_stream_decryptor>(_segments->cipher());
+            _cipher_type = _segments->cipher();
+        }
+        _decompressor.reset();
+        if (_segments->compression() != config::COMPRESSION_none)
+            _decompressor = std::make_unique<data_decompressor>(_segments->compression());
+        _pending.clear();
+        _segment_index = 0;
+    }
+
+    size_t __aes_container_decryptor::segment_size() const
+    {
+        SSL_HELPERS_ASSERT(_segments, "Header required");
+
+        return _segments->segment_size();
+    }
+
+    uint64_t __aes_container_decryptor::plain_size(uint64_t container_size) const
+    {
+        SSL_HELPERS_ASSERT(_segments, "Header required");
+        SSL_HELPERS_ASSERT(!_decompressor, "Plain size of compressed container is unknown");
+
+        return _segments->plain_size(container_size);
+    }
+
+    std::string __aes_container_decryptor::decrypt(const char* cipher_chunk, size_t len)
+    {
+        SSL_HELPERS_ASSERT(_segments, "Header required");
+        SSL_HELPERS_ASSERT(cipher_chunk || !len, "Buffer required");
+
+        const size_t cipher_segment_size = _segments->cipher_segment_size();
+
+        std::string result;
+        result.reserve(((_pending.size() + len) / cipher_segment_size) * _segments->segment_size());
+
+        while (len > 0)
+        {
+            // Full segment is decrypted only if there are more data after it
+            if (_pending.size() == cipher_segment_size)
+            {
+                flush(_pending.data(), _pending.size(), false, result);
+                _pending.clear();
+            }
+
+            if (_pending.empty() && len > cipher_segment_size)
+            {
+                flush(cipher_chunk, cipher_segment_size, false, result);
+                cipher_chunk += cipher_segment_size;
+                len -= cipher_segment_size;
+                continue;
+            }
+
+            size_t piece = std::min(cipher_segment_size - _pending.size(), len);
+            _pending.append(cipher_chunk, piece);
+            cipher_chunk += piece;
+            len -= piece;
+        }
+
+        return decompress(std::move(result), false);
+    }
+
+    std::string __aes_container_decryptor::finalize()
+    {
+        SSL_HELPERS_ASSERT(_segments, "Header required");
+
+        std::string result;
+        flush(_pending.data(), _pending.size(), true, result);
+        result = decompress(std::move(result), true);
+
+        _pending.clear();
+        _segments.reset();
+        _decompressor.reset();
+
+        return result;
+    }
+
+    std::string __aes_container_decryptor::decrypt_range(const aes_container_reader_type& read,
+                                                         uint64_t container_size,
+                                                         uint64_t offset, size_t len)
+    {
+        SSL_HELPERS_ASSERT(_segments, "Header required");
+        SSL_HELPERS_ASSERT(read, "Reader required");
+        SSL_HELPERS_ASSERT(!_decompressor, "Compressed container has no random access");
+
+        const uint64_t count = _segments->segments_count(container_size);
+        const uint64_t total = _segments->plain_size(container_size);
+
+        SSL_HELPERS_ASSERT(offset <= total && len <= total - offset, "Range is out of data");
+
+        std::string result;
+        if (!len)
+            return result;
+
+        result.reserve(len);
+
+        const uint64_t segment_size = _segments->segment_size();
+
+        std::vector<char> cipher_data(_segments->cipher_segment_size());
+        std::vector<char> plain_data(_segments->segment_size());
+
+        for (uint64_t index = offset / segment_size; index <= (offset + len - 1) / segment_size; ++index)
+        {
+            const bool last = index + 1 == count;
+            const uint64_t cipher_offset = _segments->segment_offset(index);
+            const size_t cipher_len = last ? static_cast<size_t>(container_size - cipher_offset) : cipher_data.size();
+
+            SSL_HELPERS_ASSERT(read(cipher_offset, cipher_data.data(), cipher_len) == cipher_len, "Insufficient data");
+
+            size_t plain_len = _segments->decrypt(*_cipher, index, last, cipher_data.data(), cipher_len, plain_data.data());
+
+            const uint64_t segment_offset = index * segment_size;
+            size_t from = static_cast<size_t>(offset > segment_offset ? offset - segment_offset : 0);
+            size_t to = static_cast<size_t>(std::min<uint64_t>(plain_len, offset + len - segment_offset));
+            result.append(plain_data.data() + from, to - from);
+        }
+
+        OPENSSL_cleanse(plain_data.data(), plain_data.size());
+
+        return result;
+    }
+
+    void __aes_container_decryptor::flush(const char* cipher_data, size_t len, bool last, std::string& output)
+    {
+        SSL_HELPERS_ASSERT(len >= aes_size<gcm_tag_type>(), "Insufficient data");
+
+        size_t pos = output.size();
+        output.resize(pos + len - aes_size<gcm_tag_type>());
+        _segments->decrypt(*_cipher, _segment_index++, last, cipher_data, len, &output[pos]);
+    }
+
+    std::string __aes_container_decryptor::decompress(std::string&& data, bool last)
+    {
+        if (!_decompressor)
+            return std::move(data);
+
+        std::string result;
+        auto output = [&](const char* plain_data, size_t len) {
+            result.append(plain_data, len);
+        };
+        _decompressor->write(data.data(), data.size(), output);
+        if (last)
+            _decompressor->finish(output);
+        return result;
+    }
+
+    std::string container_encrypt(const context& ctx, const char* plain_data, size_t len,
+                                  const std::string& shadowed_key, size_t segment_size,
+                                  size_t threads_amount)
+    {
+        SSL_HELPERS_ASSERT(plain_data || !len, "Buffer required");
+
+        std::string compressed_data;
+        if (ctx().compression() != config::COMPRESSION_none)
+        {
+            compressed_data = compress(ctx().compression(), plain_data, len);
+            plain_data = compressed_data.data();
+            len = compressed_data.size();
+        }
+
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        auto header = create_header(ctx().aead_cipher(), segment_size, ctx().compression());
+        container_segments segments(key_material.key, header);
+
+        segment_size = segments.segment_size();
+        const uint64_t count = std::max<uint64_t>(1, (len + segment_size - 1) / segment_size);
+
+        std::string result(container_header::SIZE + len + count * aes_size<gcm_tag_type>(), '\0');
+        char* presult = &result[0];
+        std::memcpy(presult, header.serialize().data(), container_header::SIZE);
+
+        threads_amount = get_threads_amount(threads_amount, static_cast<size_t>(count));
+        const uint64_t job_segments = (count + threads_amount - 1) / threads_amount;
+
+        parallel_run(threads_amount, threads_amount, [&](size_t job) {
+            aes_stream_encryptor cipher(segments.cipher());
+
+            for (uint64_t index = job * job_segments; index < std::min(count, (job + 1) * job_segments); ++index)
+            {
+                const uint64_t plain_offset = index * segment_size;
+                const size_t plain_len = static_cast<size_t>(std::min<uint64_t>(segment_size, len - plain_offset));
+
+                segments.encrypt(cipher, index, index + 1 == count,
+                                 plain_data + plain_offset, plain_len,
+                                 presult + segments.segment_offset(index));
+            }
+        });
+
+        return result;
+    }
+
+    std::string container_decrypt(const context&, const char* container_data, size_t len,
+                                  const std::string& shadowed_key, size_t threads_amount)
+    {
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        container_segments segments(key_material.key, container_header::parse(container_data, len));
+
+        const uint64_t count = segments.segments_count(len);
+        const size_t segment_size = segments.segment_size();
+
+        std::string result(static_cast<size_t>(segments.plain_size(len)), '\0');
+        char* presult = &result[0];
+
+        threads_amount = get_threads_amount(threads_amount, static_cast<size_t>(count));
+        const uint64_t job_segments = (count + threads_amount - 1) / threads_amount;
+
+        parallel_run(threads_amount, threads_amount, [&](size_t job) {
+            aes_stream_decryptor cipher(segments.cipher());
+
+            for (uint64_t index = job * job_segments; index < std::min(count, (job + 1) * job_segments); ++index)
+            {
+                const bool last = index + 1 == count;
+                const uint64_t cipher_offset = segments.segment_offset(index);
+                const size_t cipher_len = last ? static_cast<size_t>(len - cipher_offset) : segments.cipher_segment_size();
+
+                segments.decrypt(cipher, index, last,
+                                 container_data + cipher_offset, cipher_len,
+                                 presult + index * segment_size);
+            }
+        });
+
+        if (segments.compression() != config::COMPRESSION_none)
+            return decompress(segments.compression(), result.data(), result.size());
+
+        return result;
+    }
+
+    bool container_encrypt_file(const context& ctx,
+                                const std::string& in_path, const std::string& out_path,
+                                const std::string& shadowed_key,
+                                const aes_file_progress_type& progress,
+                                digest_encoder* digest)
+    {
+        std::ifstream input(in_path, std::ifstream::binary);
+        SSL_HELPERS_ASSERT(input, "Can't open input file");
+
+        const uint64_t total = get_file_size(input);
+
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        auto header = create_header(ctx().aead_cipher(), ctx().file_buffer_size(), ctx().compression());
+        container_segments segments(key_material.key, header);
+
+        std::unique_ptr<data_compressor> compressor;
+        if (segments.compression() != config::COMPRESSION_none)
+            compressor = std::make_unique<data_compressor>(segments.compression());
+
+        const size_t segment_size = segments.segment_size();
+        const size_t slot_segments = get_slot_segments(segment_size);
+
+        return write_file(out_path, [&](std::ofstream& output) {
+            output.write(header.serialize().data(), container_header::SIZE);
+            SSL_HELPERS_ASSERT(output, "Can't write output file");
+
+            aes_stream_encryptor cipher(segments.cipher());
+            uint64_t read_total = 0;
+            uint64_t written_total = 0;
+            // Progress is counted by plain data that were read
+            // if compressed data are written
+            std::atomic<uint64_t> plain_progress { 0 };
+
+            std::vector<char> plain_buffer(compressor ? slot_segments * segment_size : 0);
+            std::string compressed;
+            bool compressed_last = false;
+            auto append_compressed = [&](const char* data, size_t len) {
+                compressed.append(data, len);
+            };
+
+            auto read_plain = [&](char* buffer, size_t size) {
+                size_t len = static_cast<size_t>(std::min<uint64_t>(size, total - read_total));
+                if (len > 0)
+                {
+                    input.read(buffer, len);
+                    SSL_HELPERS_ASSERT(input.gcount() == static_cast<std::streamsize>(len), "Can't read input file");
+                }
+                read_total += len;
+                return len;
+            };
+
+            return pipeline_run(
+                FILE_PIPELINE_SLOTS, slot_segments * segment_size, slot_segments * segments.cipher_segment_size(),
+                [&](pipeline_slot& slot) {
+                    if (!compressor)
+                    {
+                        slot.input_len = read_plain(slot.input.data(), slot.input.size());
+                        slot.last = read_total == total;
+                        return;
+                    }
+
+                    // Compressed data are collected up to slot size
+                    while (compressed.size() < slot.input.size() && !compressed_last)
+                    {
+                        size_t len = read_plain(plain_buffer.data(), plain_buffer.size());
+                        if (digest)
+                            digest->write(plain_buffer.data(), len);
+                        compressor->write(plain_buffer.data(), len, append_compressed);
+                        if (read_total == total)
+                        {
+                            compressor->finish(append_compressed);
+                            compressed_last = true;
+                        }
+                    }
+                    slot.input_len = std::min(slot.input.size(), compressed.size());
+                    std::memcpy(slot.input.data(), compressed.data(), slot.input_len);
+                    compressed.erase(0, slot.input_len);
+                    slot.last = compressed_last && compressed.empty();
+                    plain_progress = read_total;
+                },
+                [&](pipeline_slot& slot) {
+                    // The last slot has at least one (probably empty) segment
+                    uint64_t index = slot.index * slot_segments;
+                    size_t pos = 0;
+                    do
+                    {
+                        size_t len = std::min(segment_size, slot.input_len - pos);
+                        bool last = slot.last && pos + len == slot.input_len;
+                        if (digest && !compressor)
+                            digest->write(slot.input.data() + pos, len);
+                        segments.encrypt(cipher, index++, last,
+                                         slot.input.data() + pos, len, slot.output.data() + slot.output_len);
+                        pos += len;
+                        slot.output_len += len + aes_size<gcm_tag_type>();
+                    } while (pos < slot.input_len);
+                },
+                [&](const pipeline_slot& slot) {
+                    output.write(slot.output.data(), slot.output_len);
+                    SSL_HELPERS_ASSERT(output, "Can't write output file");
+                    written_total += slot.input_len;
+                    return !progress || progress(compressor ? plain_progress.load() : written_total, total);
+                });
+        });
+    }
+
+    bool container_decrypt_file(const context&,
+                                const std::string& in_path, const std::string& out_path,
+                                const std::string& shadowed_key,
+                                const aes_file_progress_type& progress,
+                                digest_encoder* digest)
+    {
+        std::ifstream input(in_path, std::ifstream::binary);
+        SSL_HELPERS_ASSERT(input, "Can't open input file");
+
+        const uint64_t container_size = get_file_size(input);
+
+        char header_data[container_header::SIZE];
+        input.read(header_data, sizeof(header_data));
+        SSL_HELPERS_ASSERT(input, "Invalid container");
+
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        container_segments segments(key_material.key, container_header::parse(header_data, sizeof(header_data)));
+
+        const uint64_t count = segments.segments_count(container_size);
+        const uint64_t total = segments.plain_size(container_size);
+
+        const size_t cipher_segment_size = segments.cipher_segment_size();
+        const size_t slot_segments = get_slot_segments(segments.segment_size());
+
+        // Progress is counted by compressed data for compressed container
+        std::unique_ptr<data_decompressor> decompressor;
+        if (segments.compression() != config::COMPRESSION_none)
+            decompressor = std::make_unique<data_decompressor>(segments.compression());
+
+        return write_file(out_path, [&](std::ofstream& output) {
+            aes_stream_decryptor cipher(segments.cipher());
+            uint64_t read_total = container_header::SIZE;
+            uint64_t written_total = 0;
+
+            auto write_plain = [&](const char* data, size_t len) {
+                if (digest)
+                    digest->write(data, len);
+                output.write(data, len);
+                SSL_HELPERS_ASSERT(output, "Can't write output file");
+            };
+
+            bool completed = pipeline_run(
+                FILE_PIPELINE_SLOTS, slot_segments * cipher_segment_size, slot_segments * segments.segment_size(),
+                [&](pipeline_slot& slot) {
+                    size_t len = static_cast<size_t>(std::min<uint64_t>(slot.input.size(), container_size - read_total));
+                    input.read(slot.input.data(), len);
+                    SSL_HELPERS_ASSERT(input.gcount() == static_cast<std::streamsize>(len), "Can't read input file");
+                    slot.input_len = len;
+                    read_total += len;
+                    slot.last = read_total == container_size;
+                },
+                [&](pipeline_slot& slot) {
+                    uint64_t index = slot.index * slot_segments;
+                    for (size_t pos = 0; pos < slot.input_len; pos += cipher_segment_size)
+                    {
+                        size_t len = std::min(cipher_segment_size, slot.input_len - pos);
+                        bool last = index + 1 == count;
+                        size_t plain_len = segments.decrypt(cipher, index++, last,
+                                                            slot.input.data() + pos, len, slot.output.data() + slot.output_len);
+                        if (digest && !decompressor)
+                            digest->write(slot.output.data() + slot.output_len, plain_len);
+                        slot.output_len += plain_len;
+                    }
+                },
+                [&](const pipeline_slot& slot) {
+                    if (decompressor)
+                    {
+                        decompressor->write(slot.output.data(), slot.output_len, write_plain);
+                    }
+                    else
+                    {
+                        output.write(slot.output.data(), slot.output_len);
+                        SSL_HELPERS_ASSERT(output, "Can't write output file");
+                    }
+                    written_total += slot.output_len;
+                    return !progress || progress(written_total, total);
+                });
+
+            if (completed && decompressor)
+                decompressor->finish(write_plain);
+            return completed;
+        });
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
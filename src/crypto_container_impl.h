@@ -0,0 +1,189 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include <ssl_helpers/context.h>
+#include <ssl_helpers/crypto_container.h>
+
+#include "ssl_helpers_defines.h"
+#include "aes256.h"
+#include "crypto_stream_impl.h"
+#include "data_compressor.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    using container_nonce_prefix_type = std::array<char, 7>;
+    using container_nonce_type = std::array<char, 12>;
+
+    size_t container_default_segment_size();
+
+    // Container header (binary, big-endian, cipher is config::AEAD_CIPHER,
+    // compression is config::COMPRESSION):
+    //
+    //     |magic (4)|version (1)|cipher (1)|flags (1)|compression (1)|
+    //     |segment size (4)|salt (16)|nonce prefix (7)|reserved (5)|
+    //
+    // Segments key is derived from key and random salt, so every container
+    // has own key and segment nonces are not shared between containers
+    // with the same key (like Tink streaming AEAD).
+    struct container_header
+    {
+        static constexpr size_t SIZE = 40;
+        static constexpr uint8_t VERSION = 1;
+
+        uint8_t version = VERSION;
+        uint8_t cipher = 0;
+        uint8_t flags = 0;
+        uint8_t compression = 0;
+        uint32_t segment_size = 0;
+        aes_salt_type salt;
+        container_nonce_prefix_type nonce_prefix;
+
+        std::string serialize() const;
+        static container_header parse(const char* data, size_t len);
+    };
+
+    // Segments layout and encryption. Nonce of segment is
+    //
+    //     |nonce prefix (7)|segment index (4)|last segment flag (1)|
+    //
+    class container_segments
+    {
+    public:
+        // Segments key is derived from 'key' and header salt
+        container_segments(const gcm_key_type& key, const container_header& header);
+        ~container_segments();
+
+        const container_header& header() const
+        {
+            return _header;
+        }
+
+        config::AEAD_CIPHER cipher() const
+        {
+            return static_cast<config::AEAD_CIPHER>(_header.cipher);
+        }
+
+        size_t segment_size() const
+        {
+            return _header.segment_size;
+        }
+
+        config::COMPRESSION compression() const
+        {
+            return static_cast<config::COMPRESSION>(_header.compression);
+        }
+
+        // Segment size in container (including tag)
+        size_t cipher_segment_size() const
+        {
+            return segment_size() + aes_size<gcm_tag_type>();
+        }
+
+        // Segments amount for container size (including header)
+        uint64_t segments_count(uint64_t container_size) const;
+        uint64_t plain_size(uint64_t container_size) const;
+
+        // Offset of segment from container beginning
+        uint64_t segment_offset(uint64_t index) const;
+
+        // Cipher buffer requires 'len' + tag size bytes
+        void encrypt(aes_stream_encryptor&, uint64_t index, bool last,
+                     const char* plain_data, size_t len, char* cipher_data) const;
+
+        // Cipher data includes tag (it is at the end of 'len' bytes).
+        // Return size of plain data
+        size_t decrypt(aes_stream_decryptor&, uint64_t index, bool last,
+                       const char* cipher_data, size_t len, char* plain_data) const;
+
+    private:
+        container_nonce_type nonce(uint64_t index, bool last) const;
+
+        gcm_key_type _key;
+        container_header _header;
+        std::string _aad;
+    };
+
+    class __aes_container_encryptor
+    {
+    public:
+        __aes_container_encryptor(const context& ctx,
+                                  const std::string& shadowed_key, size_t segment_size);
+
+        std::string start();
+        std::string encrypt(const char* plain_chunk, size_t len);
+        std::string finalize();
+
+    private:
+        // Split data (compressed if compression is enabled) to segments
+        void append(const char* data, size_t len, std::string& output);
+        void flush(const char* plain_data, size_t len, bool last, std::string& output);
+
+        gcm_key_material _key_material;
+        size_t _segment_size = 0;
+        config::AEAD_CIPHER _cipher_type;
+        config::COMPRESSION _compression;
+        std::unique_ptr<container_segments> _segments;
+        std::unique_ptr<data_compressor> _compressor;
+        aes_stream_encryptor _cipher;
+        std::string _pending;
+        uint64_t _segment_index = 0;
+    };
+
+    class __aes_container_decryptor
+    {
+    public:
+        __aes_container_decryptor(const context& ctx,
+                                  const std::string& shadowed_key);
+
+        void start(const std::string& header);
+        size_t segment_size() const;
+        uint64_t plain_size(uint64_t container_size) const;
+        std::string decrypt(const char* cipher_chunk, size_t len);
+        std::string finalize();
+        std::string decrypt_range(const aes_container_reader_type& read,
+                                  uint64_t container_size,
+                                  uint64_t offset, size_t len);
+
+    private:
+        void flush(const char* cipher_data, size_t len, bool last, std::string& output);
+        // Decompress decrypted data if container is compressed
+        std::string decompress(std::string&& data, bool last);
+
+        gcm_key_material _key_material;
+        std::unique_ptr<container_segments> _segments;
+        std::unique_ptr<data_decompressor> _decompressor;
+        // Cipher is known from header
+        config::AEAD_CIPHER _cipher_type = config::AEAD_CIPHER_aes256_gcm;
+        std::unique_ptr<aes_stream_decryptor> _cipher;
+        std::string _pending;
+        uint64_t _segment_index = 0;
+    };
+
+    // Create/decrypt container at once by several threads.
+    // Plain data are compressed at once before encryption
+    // if compression is enabled (config::compression())
+    std::string container_encrypt(const context& ctx, const char* plain_data, size_t len,
+                                  const std::string& shadowed_key, size_t segment_size,
+                                  size_t threads_amount);
+    std::string container_decrypt(const context& ctx, const char* container_data, size_t len,
+                                  const std::string& shadowed_key, size_t threads_amount);
+
+    // File to file with overlapped read, encryption and write.
+    // Plain data are hashed by optional 'digest' segment by segment
+    bool container_encrypt_file(const context& ctx,
+                                const std::string& in_path, const std::string& out_path,
+                                const std::string& shadowed_key,
+                                const aes_file_progress_type& progress,
+                                digest_encoder* digest = nullptr);
+    bool container_decrypt_file(const context& ctx,
+                                const std::string& in_path, const std::string& out_path,
+                                const std::string& shadowed_key,
+                                const aes_file_progress_type& progress,
+                                digest_encoder* digest = nullptr);
+
+} // namespace impl
+} // namespace ssl_helpers
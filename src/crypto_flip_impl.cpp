@@ -0,0 +1,241 @@
+#include "crypto_flip_impl.h"
+
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include <openssl/rand.h>
+
+#include <ssl_helpers/crypto.h>
+#include <ssl_helpers/random.h>
+
+#include "parallel_helper.h"
+#include "salted_key_cache.h"
+
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+        // Salted key is erased at the end of scope
+        struct flip_key_material : public gcm_key_material
+        {
+            flip_key_material(std::string&& salted_key)
+            {
+                derive_gcm_key(salted_key, *this);
+                OPENSSL_cleanse(&salted_key[0], salted_key.size());
+            }
+        };
+    } // namespace
+
+    __aes_flip_encryption_stream::__aes_flip_encryption_stream(const context& ctx,
+                                                               const std::string& marker,
+                                                               bool add_garbage)
+        : _ctx(ctx)
+        , _marker(marker)
+        , _add_garbage(add_garbage)
+    {
+    }
+
+    const std::string& __aes_flip_encryption_stream::start(const std::string& instant_key)
+    {
+        auto salted_key = aes_create_salted_key(_ctx, instant_key);
+        _salt = salted_key.second;
+
+        flip_key_material key_material { std::move(salted_key.first) };
+        _sm.start(key_material, _marker);
+
+        return _marker;
+    }
+
+    size_t __aes_flip_encryption_stream::encrypt(const char* plain_chunk, size_t len, char* cipher_chunk)
+    {
+        return _sm.process(plain_chunk, len, cipher_chunk);
+    }
+
+    size_t __aes_flip_encryption_stream::finalize(char* session_data)
+    {
+        SSL_HELPERS_ASSERT(session_data, "Buffer required");
+
+        auto tag = _sm.finalize();
+
+        char* p = session_data;
+
+        std::memcpy(p, _marker.data(), _marker.size());
+        p += _marker.size();
+        std::memcpy(p, _salt.data(), _salt.size());
+        p += _salt.size();
+        std::memcpy(p, tag.data(), tag.size());
+        p += tag.size();
+
+        if (_add_garbage)
+        {
+            size_t garbage_len = create_random(_ctx) % flip_format::MAX_GARBAGE_SIZE + 1;
+
+            SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)p, static_cast<int>(garbage_len)), "Can't get random data for garbage");
+            p += garbage_len;
+        }
+
+        return static_cast<size_t>(p - session_data);
+    }
+
+    __aes_flip_decryption_stream::__aes_flip_decryption_stream(const context& ctx,
+                                                               const std::string& marker,
+                                                               size_t kdf_threads_amount)
+        : _ctx(ctx)
+        , _marker(marker)
+        , _kdf_threads_amount(kdf_threads_amount)
+    {
+    }
+
+    void __aes_flip_decryption_stream::start(const char* session_data, size_t session_len,
+                                             const std::string& instant_key)
+    {
+        SSL_HELPERS_ASSERT(session_data, "Buffer required");
+
+        SSL_HELPERS_ASSERT(session_len >= _marker.size() + flip_format::SALT_SIZE + flip_format::TAG_SIZE, "Insufficient data");
+        SSL_HELPERS_ASSERT(!std::memcmp(session_data, _marker.data(), _marker.size()), "Invalid marker");
+
+        const char* p = session_data + _marker.size();
+
+        aes_salt_type salt;
+        std::memcpy(salt.data(), p, salt.size());
+        p += salt.size();
+
+        std::memcpy(_tag.data(), p, _tag.size());
+
+        flip_key_material key_material { get_salted_key(_ctx, instant_key, std::string { salt.data(), salt.size() }, _kdf_threads_amount) };
+        _sm.start(key_material, _marker);
+
+        _marker_read = 0;
+    }
+
+    size_t __aes_flip_decryption_stream::decrypt(const char* cipher_chunk, size_t len, char* plain_chunk)
+    {
+        SSL_HELPERS_ASSERT(cipher_chunk && plain_chunk, "Buffer required");
+
+        if (_marker_read < _marker.size())
+        {
+            size_t piece = std::min(len, _marker.size() - _marker_read);
+            SSL_HELPERS_ASSERT(!std::memcmp(cipher_chunk, _marker.data() + _marker_read, piece), "Invalid marker");
+
+            _marker_read += piece;
+            cipher_chunk += piece;
+            len -= piece;
+        }
+
+        if (!len)
+            return 0;
+
+        return _sm.process(cipher_chunk, len, plain_chunk);
+    }
+
+    void __aes_flip_decryption_stream::finalize()
+    {
+        SSL_HELPERS_ASSERT(_marker_read == _marker.size(), "Insufficient data");
+
+        _sm.finalize_checked(_tag);
+    }
+
+    size_t flip_encrypt(const context& ctx,
+                        const char* plain_data, size_t len,
+                        const std::string& instant_key,
+                        const std::string& marker,
+                        bool add_garbage,
+                        char* cipher_data, char* session_data)
+    {
+        SSL_HELPERS_ASSERT(cipher_data, "Buffer required");
+
+        __aes_flip_encryption_stream stream(ctx, marker, add_garbage);
+
+        stream.start(instant_key);
+        std::memcpy(cipher_data, marker.data(), marker.size());
+        stream.encrypt(plain_data, len, cipher_data + marker.size());
+
+        return stream.finalize(session_data);
+    }
+
+    size_t flip_decrypt(const context& ctx,
+                        const char* cipher_data, size_t cipher_len,
+                        const char* session_data, size_t session_len,
+                        const std::string& instant_key,
+                        const std::string& marker,
+                        char* plain_data)
+    {
+        auto len = flip_format::plain_size(cipher_len, marker.size());
+
+        __aes_flip_decryption_stream stream(ctx, marker);
+
+        stream.start(session_data, session_len, instant_key);
+
+        try
+        {
+            stream.decrypt(cipher_data, cipher_len, plain_data);
+            stream.finalize();
+        }
+        catch (...)
+        {
+            OPENSSL_cleanse(plain_data, len);
+            throw;
+        }
+
+        return len;
+    }
+
+    std::vector<flip_batch_result_type> flip_decrypt_batch(const context& ctx,
+                                                           const std::vector<flip_session_type>& sessions,
+                                                           const std::vector<std::string>& instant_keys,
+                                                           const std::string& marker,
+                                                           size_t threads_amount)
+    {
+        SSL_HELPERS_ASSERT(instant_keys.size() == 1 || instant_keys.size() == sessions.size(), "Key for every session required");
+
+        std::vector<flip_batch_result_type> results(sessions.size());
+        if (sessions.empty())
+            return results;
+
+        threads_amount = get_threads_amount(threads_amount, sessions.size());
+
+        // Worker takes the next session when it is done with previous one
+        // (key derivation time is not the same for cached keys)
+        std::atomic<size_t> next_session { 0 };
+
+        parallel_run(threads_amount, threads_amount, [&](size_t) {
+            auto stream = std::make_unique<__aes_flip_decryption_stream>(ctx, marker, 1);
+
+            for (size_t ci = next_session++; ci < sessions.size(); ci = next_session++)
+            {
+                const auto& cipher_data = sessions[ci].first;
+                const auto& session_data = sessions[ci].second;
+                const auto& instant_key = instant_keys.size() == 1 ? instant_keys.front() : instant_keys[ci];
+
+                auto& result = results[ci];
+                try
+                {
+                    result.plain_data.resize(flip_format::plain_size(cipher_data.size(), marker.size()));
+
+                    stream->start(session_data.data(), session_data.size(), instant_key);
+                    stream->decrypt(cipher_data.data(), cipher_data.size(), &result.plain_data[0]);
+                    stream->finalize();
+
+                    result.ok = true;
+                }
+                catch (std::exception& e)
+                {
+                    OPENSSL_cleanse(&result.plain_data[0], result.plain_data.size());
+                    result.plain_data.clear();
+                    result.error = e.what();
+
+                    // Session can be broken in the middle
+                    stream = std::make_unique<__aes_flip_decryption_stream>(ctx, marker, 1);
+                }
+            }
+        });
+
+        return results;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
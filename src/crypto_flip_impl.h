@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <ssl_helpers/context.h>
+#include <ssl_helpers/crypto_types.h>
+
+#include "ssl_helpers_defines.h"
+#include "crypto_stream_impl.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // Flip chunks:
+    //
+    //     cipher data:  |marker|encrypted data|
+    //     session data: |marker|salt (16)|tag (16)|garbage (0 or 1..16)|
+    //
+    // Cipher data is AES256-GCM stream with marker as AAD and key
+    // is PBKDF2 of instant key with salt.
+    struct flip_format
+    {
+        static constexpr size_t SALT_SIZE = 16;
+        static constexpr size_t TAG_SIZE = 16;
+        static constexpr size_t MAX_GARBAGE_SIZE = 16;
+
+        static size_t cipher_size(size_t plain_len, size_t marker_len)
+        {
+            return marker_len + plain_len;
+        }
+
+        static size_t plain_size(size_t cipher_len, size_t marker_len)
+        {
+            SSL_HELPERS_ASSERT(cipher_len >= marker_len, "Insufficient data");
+            return cipher_len - marker_len;
+        }
+
+        static size_t session_max_size(size_t marker_len)
+        {
+            return marker_len + SALT_SIZE + TAG_SIZE + MAX_GARBAGE_SIZE;
+        }
+    };
+
+    // Flip encryption by chunks. Cipher data is marker (start)
+    // and encrypted chunks. Session data is created at the end (finalize).
+    class __aes_flip_encryption_stream
+    {
+    public:
+        __aes_flip_encryption_stream(const context& ctx,
+                                     const std::string& marker,
+                                     bool add_garbage);
+
+        // Start with new salt. Return head of cipher data (marker)
+        const std::string& start(const std::string& instant_key);
+
+        size_t encrypt(const char* plain_chunk, size_t len, char* cipher_chunk);
+
+        // Session buffer should have at least flip_format::session_max_size bytes.
+        // Return size of session data
+        size_t finalize(char* session_data);
+
+        const std::string& marker() const
+        {
+            return _marker;
+        }
+
+    private:
+        const context& _ctx;
+        const std::string _marker;
+        const bool _add_garbage;
+        aes_salt_type _salt;
+        aes_stream_sm<aes_stream_encryptor> _sm;
+    };
+
+    // Flap decryption by chunks. Marker at the head of cipher data
+    // is checked and skipped. Plain data are returned before tag check
+    // (finalize).
+    class __aes_flip_decryption_stream
+    {
+    public:
+        // Salted key is created by 'kdf_threads_amount' threads
+        // (see create_salted_key)
+        __aes_flip_decryption_stream(const context& ctx,
+                                     const std::string& marker,
+                                     size_t kdf_threads_amount = 0);
+
+        void start(const char* session_data, size_t session_len,
+                   const std::string& instant_key);
+
+        // Return size of plain data (less than 'len' while marker is read)
+        size_t decrypt(const char* cipher_chunk, size_t len, char* plain_chunk);
+
+        void finalize();
+
+    private:
+        const context& _ctx;
+        const std::string _marker;
+        const size_t _kdf_threads_amount;
+        size_t _marker_read = 0;
+        gcm_tag_type _tag;
+        aes_stream_sm<aes_stream_decryptor> _sm;
+    };
+
+    // Encrypt to caller buffers (flip_format sizes).
+    // Return size of session data
+    size_t flip_encrypt(const context& ctx,
+                        const char* plain_data, size_t len,
+                        const std::string& instant_key,
+                        const std::string& marker,
+                        bool add_garbage,
+                        char* cipher_data, char* session_data);
+
+    // Decrypt to caller buffer (flip_format::plain_size bytes).
+    // Plain buffer is cleansed if data are not authentic.
+    // Return size of plain data
+    size_t flip_decrypt(const context& ctx,
+                        const char* cipher_data, size_t cipher_len,
+                        const char* session_data, size_t session_len,
+                        const std::string& instant_key,
+                        const std::string& marker,
+                        char* plain_data);
+
+    // Decrypt sessions by 'threads_amount' workers.
+    // Every worker keeps own cipher context for all its sessions
+    // and creates salted keys by own thread only
+    std::vector<flip_batch_result_type> flip_decrypt_batch(const context& ctx,
+                                                           const std::vector<flip_session_type>& sessions,
+                                                           const std::vector<std::string>& instant_keys,
+                                                           const std::string& marker,
+                                                           size_t threads_amount);
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,151 @@
+#include <ssl_helpers/crypto_record.h>
+
+#include "crypto_record_impl.h"
+
+
+namespace ssl_helpers {
+
+size_t aes_record_frame_size(size_t len)
+{
+    return len + impl::record_frame::OVERHEAD;
+}
+
+aes_record_sealer::aes_record_sealer(const context& ctx, const std::string& shadowed_key)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_record_sealer>(ctx, shadowed_key);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_record_sealer::~aes_record_sealer()
+{
+}
+
+std::string aes_record_sealer::seal(const std::string& plain_data)
+{
+    try
+    {
+        std::string result(aes_record_frame_size(plain_data.size()), '\0');
+        _impl->seal(plain_data.data(), plain_data.size(), &result[0], result.size());
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_record_sealer::seal(const char* plain_data, size_t len, char* frame, size_t frame_capacity)
+{
+    try
+    {
+        return _impl->seal(plain_data, len, frame, frame_capacity);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+uint64_t aes_record_sealer::sequence() const
+{
+    return _impl->sequence();
+}
+
+aes_salt_type aes_record_sealer::salt() const
+{
+    return _impl->salt();
+}
+
+aes_record_opener::aes_record_opener(const context& ctx, const std::string& shadowed_key, const aes_salt_type& salt)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_record_opener>(ctx, shadowed_key, salt);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_record_opener::~aes_record_opener()
+{
+}
+
+std::string aes_record_opener::open(const std::string& frame)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(frame.size() >= impl::record_frame::OVERHEAD, "Invalid record");
+
+        std::string result(frame.size() - impl::record_frame::OVERHEAD, '\0');
+        _impl->open(frame.data(), frame.size(), &result[0]);
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_record_opener::open(const char* frame, size_t len, char* plain_data)
+{
+    try
+    {
+        return _impl->open(frame, len, plain_data);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_record_opener::open_in_place(char* buffer, size_t len, const aes_record_handler_type& handler)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(len == 0 || buffer, "Buffer required");
+        SSL_HELPERS_ASSERT(handler, "Handler required");
+
+        size_t offset = 0;
+        while (offset < len)
+        {
+            size_t frame_size = impl::__aes_record_opener::frame_size(buffer + offset, len - offset);
+            if (!frame_size || frame_size > len - offset)
+                break;
+
+            char* plain_data = buffer + offset + impl::record_frame::HEADER_SIZE;
+            size_t plain_size = _impl->open(buffer + offset, frame_size, plain_data);
+            offset += frame_size;
+
+            handler(plain_data, plain_size);
+        }
+        return offset;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+uint64_t aes_record_opener::sequence() const
+{
+    return _impl->sequence();
+}
+
+} // namespace ssl_helpers
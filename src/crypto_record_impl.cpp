@@ -0,0 +1,164 @@
+#include <cstring>
+
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "crypto_record_impl.h"
+#include "crypto_stream_impl.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    void record_frame::write_header(size_t len, char* header)
+    {
+        for (size_t ci = 0; ci < HEADER_SIZE; ++ci)
+            header[ci] = static_cast<char>(len >> (8 * (HEADER_SIZE - 1 - ci)));
+    }
+
+    size_t record_frame::read_header(const char* header)
+    {
+        size_t result = 0;
+        for (size_t ci = 0; ci < HEADER_SIZE; ++ci)
+            result = (result << 8) | static_cast<unsigned char>(header[ci]);
+        return result;
+    }
+
+    namespace {
+        aes_salt_type create_record_salt()
+        {
+            aes_salt_type salt;
+            SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)salt.data(), salt.size()), "Can't get random data for salt");
+            return salt;
+        }
+    } // namespace
+
+    record_nonce::record_nonce(const context&, const std::string& shadowed_key, const aes_salt_type& salt)
+        : _salt(salt)
+    {
+        static const std::string label { "AES256-GCM records" };
+
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+
+        std::string kdf_data;
+        kdf_data.reserve(label.size() + key_material.iv.size() + _salt.size());
+        kdf_data.append(label);
+        kdf_data.append(key_material.iv.data(), key_material.iv.size());
+        kdf_data.append(_salt.data(), _salt.size());
+
+        unsigned char traffic_key[EVP_MAX_MD_SIZE];
+        unsigned int traffic_key_len = 0;
+        SSL_HELPERS_ASSERT(HMAC(EVP_sha512(), key_material.key.data(), static_cast<int>(key_material.key.size()),
+                                (const unsigned char*)kdf_data.data(), kdf_data.size(),
+                                traffic_key, &traffic_key_len),
+                           "Can't derive record key");
+
+        static_assert(sizeof(_key) + sizeof(_iv) <= 512 / 8, "Insufficient key material");
+
+        std::memcpy(_key.data(), traffic_key, _key.size());
+        std::memcpy(_iv.data(), traffic_key + _key.size(), _iv.size());
+        OPENSSL_cleanse(traffic_key, sizeof(traffic_key));
+    }
+
+    record_nonce::~record_nonce()
+    {
+        OPENSSL_cleanse(_key.data(), _key.size());
+        OPENSSL_cleanse(_iv.data(), _iv.size());
+    }
+
+    aes_nonce_type record_nonce::current() const
+    {
+        aes_nonce_type result = _iv;
+        for (size_t ci = 0; ci < sizeof(_sequence); ++ci)
+            result[result.size() - 1 - ci] ^= static_cast<char>(_sequence >> (8 * ci));
+        return result;
+    }
+
+    void record_nonce::next()
+    {
+        // Nonce must not be repeated for the key
+        SSL_HELPERS_ASSERT(_sequence < UINT64_MAX, "Sequence is exhausted");
+        ++_sequence;
+    }
+
+    __aes_record_sealer::__aes_record_sealer(const context& ctx, const std::string& shadowed_key)
+        : _nonce(ctx, shadowed_key, create_record_salt())
+    {
+    }
+
+    size_t __aes_record_sealer::seal(const char* plain_data, size_t len, char* frame, size_t frame_capacity)
+    {
+        SSL_HELPERS_ASSERT(len <= record_frame::MAX_DATA_SIZE, "Record is too large");
+        SSL_HELPERS_ASSERT(frame && frame_capacity >= len + record_frame::OVERHEAD, "Frame buffer is too small");
+        SSL_HELPERS_ASSERT(len == 0 || plain_data, "Buffer required");
+
+        record_frame::write_header(len, frame);
+
+        auto nonce = _nonce.current();
+        _cipher.init(_nonce.key(), nonce.data(), nonce.size());
+        _cipher.set_aad(frame, record_frame::HEADER_SIZE);
+
+        char* pcipher = frame + record_frame::HEADER_SIZE;
+        if (len > 0)
+            _cipher.process(plain_data, len, pcipher);
+
+        gcm_tag_type tag;
+        _cipher.finalize(tag);
+        std::memcpy(pcipher + len, tag.data(), tag.size());
+
+        _nonce.next();
+
+        return len + record_frame::OVERHEAD;
+    }
+
+    __aes_record_opener::__aes_record_opener(const context& ctx, const std::string& shadowed_key, const aes_salt_type& salt)
+        : _nonce(ctx, shadowed_key, salt)
+    {
+    }
+
+    size_t __aes_record_opener::frame_size(const char* data, size_t len)
+    {
+        if (len < record_frame::HEADER_SIZE)
+            return 0;
+
+        size_t data_len = record_frame::read_header(data);
+        SSL_HELPERS_ASSERT(data_len <= record_frame::MAX_DATA_SIZE, "Invalid record");
+
+        return data_len + record_frame::OVERHEAD;
+    }
+
+    size_t __aes_record_opener::open(const char* frame, size_t len, char* plain_data)
+    {
+        SSL_HELPERS_ASSERT(frame && len >= record_frame::OVERHEAD, "Invalid record");
+
+        size_t data_len = record_frame::read_header(frame);
+        SSL_HELPERS_ASSERT(data_len + record_frame::OVERHEAD == len, "Invalid record");
+        SSL_HELPERS_ASSERT(data_len == 0 || plain_data, "Buffer required");
+
+        auto nonce = _nonce.current();
+        _cipher.init(_nonce.key(), nonce.data(), nonce.size());
+        _cipher.set_aad(frame, record_frame::HEADER_SIZE);
+
+        const char* pcipher = frame + record_frame::HEADER_SIZE;
+        try
+        {
+            if (data_len > 0)
+                _cipher.process(pcipher, data_len, plain_data);
+
+            _cipher.finalize_checked(create_from_string<gcm_tag_type>(pcipher + data_len, record_frame::TAG_SIZE));
+        }
+        catch (std::exception&)
+        {
+            if (data_len > 0)
+                OPENSSL_cleanse(plain_data, data_len);
+            throw;
+        }
+
+        _nonce.next();
+
+        return data_len;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+
+#include <ssl_helpers/context.h>
+#include <ssl_helpers/crypto_types.h>
+
+#include "ssl_helpers_defines.h"
+#include "aes256.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // AES256-GCM records. Frame:
+    //
+    //     |length of cipher data (4, big-endian)|cipher data|tag (16)|
+    //
+    // Key and 96-bit init value are derived from key material and random
+    // salt of sealer (own traffic key like TLS 1.3 has for every direction
+    // and connection). Nonce of record is init value XOR 64-bit record
+    // sequence number, so sequence is authenticated implicitly.
+    // Length field is AAD of record.
+    struct record_frame
+    {
+        static constexpr size_t HEADER_SIZE = 4;
+        static constexpr size_t TAG_SIZE = 16;
+        static constexpr size_t OVERHEAD = HEADER_SIZE + TAG_SIZE;
+        static constexpr size_t MAX_DATA_SIZE = 0x7fffffff - OVERHEAD;
+
+        static void write_header(size_t len, char* header);
+        static size_t read_header(const char* header);
+    };
+
+    // Sequence number nonces with key for salt
+    class record_nonce
+    {
+    public:
+        record_nonce(const context& ctx, const std::string& shadowed_key, const aes_salt_type& salt);
+        record_nonce(const record_nonce&) = delete;
+        ~record_nonce();
+
+        const gcm_key_type& key() const
+        {
+            return _key;
+        }
+
+        uint64_t sequence() const
+        {
+            return _sequence;
+        }
+
+        const aes_salt_type& salt() const
+        {
+            return _salt;
+        }
+
+        aes_nonce_type current() const;
+
+        void next();
+
+    private:
+        const aes_salt_type _salt;
+        gcm_key_type _key;
+        aes_nonce_type _iv;
+        uint64_t _sequence = 0;
+    };
+
+    class __aes_record_sealer
+    {
+    public:
+        __aes_record_sealer(const context& ctx, const std::string& shadowed_key);
+
+        size_t seal(const char* plain_data, size_t len, char* frame, size_t frame_capacity);
+
+        uint64_t sequence() const
+        {
+            return _nonce.sequence();
+        }
+
+        const aes_salt_type& salt() const
+        {
+            return _nonce.salt();
+        }
+
+    private:
+        record_nonce _nonce;
+        aes_stream_encryptor _cipher;
+    };
+
+    class __aes_record_opener
+    {
+    public:
+        __aes_record_opener(const context& ctx, const std::string& shadowed_key, const aes_salt_type& salt);
+
+        // Return size of full frame at the beginning of data or 0 if
+        // data are not enough to read header
+        static size_t frame_size(const char* data, size_t len);
+
+        // Decrypt frame (it can be decrypted in place). Return plain data size
+        size_t open(const char* frame, size_t len, char* plain_data);
+
+        uint64_t sequence() const
+        {
+            return _nonce.sequence();
+        }
+
+    private:
+        record_nonce _nonce;
+        aes_stream_decryptor _cipher;
+    };
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,193 @@
+#include <openssl/rand.h>
+
+#include <ssl_helpers/crypto_session_pool.h>
+
+#include "crypto_session_pool_impl.h"
+
+
+namespace ssl_helpers {
+
+aes_session_pool::aes_session_pool(const context& ctx,
+                                   const std::string& shadowed_key,
+                                   size_t contexts_amount)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_session_pool>(ctx, shadowed_key, contexts_amount);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_session_pool::~aes_session_pool()
+{
+}
+
+aes_session_handle aes_session_pool::open_encryption(const std::string& aad)
+{
+    try
+    {
+        aes_nonce_type nonce;
+        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)nonce.data(), nonce.size()), "Can't get random data for nonce");
+
+        return _impl->open(true, nonce, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+aes_session_handle aes_session_pool::open_encryption(const aes_nonce_type& nonce, const std::string& aad)
+{
+    try
+    {
+        return _impl->open(true, nonce, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+aes_session_handle aes_session_pool::open_decryption(const aes_nonce_type& nonce, const std::string& aad)
+{
+    try
+    {
+        return _impl->open(false, nonce, aad);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+aes_nonce_type aes_session_pool::nonce(const aes_session_handle& session) const
+{
+    try
+    {
+        return _impl->nonce(session);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+std::string aes_session_pool::encrypt(const aes_session_handle& session, const std::string& plain_chunk)
+{
+    try
+    {
+        std::string result(plain_chunk.size(), '\0');
+        _impl->encrypt(session, plain_chunk.data(), plain_chunk.size(), &result[0]);
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_session_pool::encrypt(const aes_session_handle& session, const char* plain_chunk, size_t len, char* cipher_chunk)
+{
+    try
+    {
+        return _impl->encrypt(session, plain_chunk, len, cipher_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+std::string aes_session_pool::decrypt(const aes_session_handle& session, const std::string& cipher_chunk)
+{
+    try
+    {
+        std::string result(cipher_chunk.size(), '\0');
+        _impl->decrypt(session, cipher_chunk.data(), cipher_chunk.size(), &result[0]);
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+size_t aes_session_pool::decrypt(const aes_session_handle& session, const char* cipher_chunk, size_t len, char* plain_chunk)
+{
+    try
+    {
+        return _impl->decrypt(session, cipher_chunk, len, plain_chunk);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+aes_tag_type aes_session_pool::finalize_encryption(const aes_session_handle& session)
+{
+    try
+    {
+        return _impl->finalize_encryption(session);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+void aes_session_pool::finalize_decryption(const aes_session_handle& session, const aes_tag_type& tag)
+{
+    try
+    {
+        _impl->finalize_decryption(session, tag);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_session_pool::close(const aes_session_handle& session)
+{
+    try
+    {
+        _impl->close(session);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+size_t aes_session_pool::sessions_amount() const
+{
+    return _impl->sessions_amount();
+}
+
+size_t aes_session_pool::memory_usage() const
+{
+    return _impl->memory_usage();
+}
+
+size_t aes_session_pool::session_size()
+{
+    return impl::__aes_session_pool::session_size();
+}
+
+} // namespace ssl_helpers
@@ -0,0 +1,311 @@
+#include <algorithm>
+
+#include "crypto_session_pool_impl.h"
+#include "crypto_stream_impl.h"
+#include "parallel_helper.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+
+        // Chunk is passed to OpenSSL by pieces (it takes int length)
+        constexpr size_t PIECE_SIZE = 1024 * 1024;
+
+    } // namespace
+
+    // Keyed AES256-GCM context. Only init value (and direction)
+    // is reset for the next session.
+    class __aes_session_pool::cipher_engine
+    {
+    public:
+        cipher_engine(const gcm_key_type& key)
+        {
+            _ctx = EVP_CIPHER_CTX_new();
+            SSL_HELPERS_ASSERT(_ctx != nullptr, ERR_error_string(ERR_get_error(), nullptr));
+
+            if (1 != EVP_CipherInit_ex(_ctx, EVP_aes_256_gcm(), NULL, (const unsigned char*)key.data(), NULL, 1))
+            {
+                EVP_CIPHER_CTX_free(_ctx);
+                SSL_HELPERS_ERROR(ERR_error_string(ERR_get_error(), nullptr));
+            }
+        }
+        cipher_engine(const cipher_engine&) = delete;
+        ~cipher_engine()
+        {
+            EVP_CIPHER_CTX_free(_ctx);
+        }
+
+        // 96-bit nonce is default init value size of GCM
+        void start(bool encryption, const aes_nonce_type& nonce)
+        {
+            auto cypher_init_result = (1 == EVP_CipherInit_ex(_ctx, NULL, NULL, NULL, (const unsigned char*)nonce.data(), encryption ? 1 : 0));
+            SSL_HELPERS_ASSERT(cypher_init_result, ERR_error_string(ERR_get_error(), nullptr));
+        }
+
+        void set_aad(const char* aad, size_t len)
+        {
+            for (size_t offset = 0; offset < len; offset += PIECE_SIZE)
+            {
+                int piece = static_cast<int>(std::min(PIECE_SIZE, len - offset));
+                int len_ = 0;
+                auto cypher_update_result = (1 == EVP_CipherUpdate(_ctx, NULL, &len_, (const unsigned char*)aad + offset, piece));
+                SSL_HELPERS_ASSERT(cypher_update_result, ERR_error_string(ERR_get_error(), nullptr));
+            }
+        }
+
+        void process(const char* input, size_t len, char* output)
+        {
+            for (size_t offset = 0; offset < len; offset += PIECE_SIZE)
+            {
+                int piece = static_cast<int>(std::min(PIECE_SIZE, len - offset));
+                int len_ = 0;
+                auto cypher_update_result = (1 == EVP_CipherUpdate(_ctx, (unsigned char*)output + offset, &len_, (const unsigned char*)input + offset, piece));
+                SSL_HELPERS_ASSERT(cypher_update_result && len_ == piece, ERR_error_string(ERR_get_error(), nullptr));
+            }
+        }
+
+        gcm_tag_type finalize_encryption()
+        {
+            int len_ = 0;
+            auto cypher_fin_result_1 = (1 == EVP_CipherFinal_ex(_ctx, NULL, &len_));
+            SSL_HELPERS_ASSERT(cypher_fin_result_1, ERR_error_string(ERR_get_error(), nullptr));
+
+            gcm_tag_type tag;
+            auto cypher_fin_result_2 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_GET_TAG, aes_size<gcm_tag_type>(), tag.data()));
+            SSL_HELPERS_ASSERT(cypher_fin_result_2, ERR_error_string(ERR_get_error(), nullptr));
+            return tag;
+        }
+
+        void finalize_decryption(const gcm_tag_type& tag)
+        {
+            gcm_tag_type tag_ = tag;
+            auto cypher_fin_result_1 = (1 == EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_SET_TAG, aes_size<gcm_tag_type>(), tag_.data()));
+            SSL_HELPERS_ASSERT(cypher_fin_result_1, ERR_error_string(ERR_get_error(), nullptr));
+
+            int len_ = 0;
+            auto cypher_fin_result_2 = (1 == EVP_CipherFinal_ex(_ctx, NULL, &len_));
+            SSL_HELPERS_ASSERT(cypher_fin_result_2, "Invalid tag");
+        }
+
+    private:
+        EVP_CIPHER_CTX* _ctx = NULL;
+    };
+
+    __aes_session_pool::__aes_session_pool(const context&, const std::string& shadowed_key, size_t contexts_amount)
+        : _contexts_amount(get_threads_amount(contexts_amount, 0))
+    {
+        gcm_key_material key_material;
+        derive_gcm_key_from_shadow(shadowed_key, key_material);
+        _key = key_material.key;
+    }
+
+    __aes_session_pool::~__aes_session_pool()
+    {
+        OPENSSL_cleanse(_key.data(), _key.size());
+    }
+
+    aes_session_handle __aes_session_pool::open(bool encryption, const aes_nonce_type& nonce, const std::string& aad)
+    {
+        aes_session_handle handle;
+        session_state* psession = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+
+            if (_free_sessions.empty())
+            {
+                SSL_HELPERS_ASSERT(_sessions.size() < UINT32_MAX, "Too many sessions");
+
+                _sessions.emplace_back();
+                _sessions.back().generation = 1;
+                _free_sessions.push_back(static_cast<uint32_t>(_sessions.size() - 1));
+            }
+
+            handle.index = _free_sessions.back();
+            _free_sessions.pop_back();
+
+            psession = &_sessions[handle.index];
+            psession->status = encryption ? state::encryption : state::decryption;
+            handle.generation = psession->generation;
+        }
+
+        auto& session = *psession;
+
+        try
+        {
+            session.nonce = nonce;
+            session.engine = take_engine();
+            session.engine->start(encryption, nonce);
+            if (!aad.empty())
+                session.engine->set_aad(aad.data(), aad.size());
+        }
+        catch (std::exception&)
+        {
+            release_session(session, handle.index);
+            throw;
+        }
+
+        return handle;
+    }
+
+    void __aes_session_pool::close(const aes_session_handle& handle)
+    {
+        session_state* psession = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+
+            SSL_HELPERS_ASSERT(handle.index < _sessions.size(), "Invalid session");
+
+            psession = &_sessions[handle.index];
+            SSL_HELPERS_ASSERT(psession->generation == handle.generation && psession->status != state::closed, "Invalid session");
+        }
+        release_session(*psession, handle.index);
+    }
+
+    aes_nonce_type __aes_session_pool::nonce(const aes_session_handle& handle)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        SSL_HELPERS_ASSERT(handle.index < _sessions.size(), "Invalid session");
+
+        auto& session = _sessions[handle.index];
+        SSL_HELPERS_ASSERT(session.generation == handle.generation && session.status != state::closed, "Invalid session");
+
+        return session.nonce;
+    }
+
+    size_t __aes_session_pool::encrypt(const aes_session_handle& handle, const char* plain_chunk, size_t len, char* cipher_chunk)
+    {
+        process(handle, true, plain_chunk, len, cipher_chunk);
+        return len;
+    }
+
+    size_t __aes_session_pool::decrypt(const aes_session_handle& handle, const char* cipher_chunk, size_t len, char* plain_chunk)
+    {
+        process(handle, false, cipher_chunk, len, plain_chunk);
+        return len;
+    }
+
+    gcm_tag_type __aes_session_pool::finalize_encryption(const aes_session_handle& handle)
+    {
+        auto& session = get_session(handle, state::encryption);
+
+        gcm_tag_type tag;
+        try
+        {
+            tag = session.engine->finalize_encryption();
+        }
+        catch (std::exception&)
+        {
+            release_session(session, handle.index);
+            throw;
+        }
+        release_session(session, handle.index);
+
+        return tag;
+    }
+
+    void __aes_session_pool::finalize_decryption(const aes_session_handle& handle, const gcm_tag_type& tag)
+    {
+        auto& session = get_session(handle, state::decryption);
+
+        try
+        {
+            session.engine->finalize_decryption(tag);
+        }
+        catch (std::exception&)
+        {
+            release_session(session, handle.index);
+            throw;
+        }
+        release_session(session, handle.index);
+    }
+
+    size_t __aes_session_pool::sessions_amount() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        return _sessions.size() - _free_sessions.size();
+    }
+
+    size_t __aes_session_pool::memory_usage() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        return _sessions.size() * sizeof(session_state) + _free_sessions.capacity() * sizeof(uint32_t);
+    }
+
+    size_t __aes_session_pool::session_size()
+    {
+        return sizeof(session_state);
+    }
+
+    __aes_session_pool::session_state& __aes_session_pool::get_session(const aes_session_handle& handle, state expected)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        SSL_HELPERS_ASSERT(handle.index < _sessions.size(), "Invalid session");
+
+        // Deque keeps element address when new sessions are added
+        auto& session = _sessions[handle.index];
+        SSL_HELPERS_ASSERT(session.generation == handle.generation && session.status == expected, "Invalid session");
+        return session;
+    }
+
+    std::unique_ptr<__aes_session_pool::cipher_engine> __aes_session_pool::take_engine()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+
+            if (!_free_engines.empty())
+            {
+                auto result = std::move(_free_engines.back());
+                _free_engines.pop_back();
+                return result;
+            }
+        }
+        return std::make_unique<cipher_engine>(_key);
+    }
+
+    void __aes_session_pool::release_engine(std::unique_ptr<cipher_engine> engine)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        // Extra contexts (for peak of concurrent calls) are freed
+        if (_free_engines.size() < _contexts_amount)
+            _free_engines.push_back(std::move(engine));
+    }
+
+    void __aes_session_pool::process(const aes_session_handle& handle, bool encryption, const char* input, size_t len, char* output)
+    {
+        auto& session = get_session(handle, encryption ? state::encryption : state::decryption);
+
+        SSL_HELPERS_ASSERT(len == 0 || (input && output), "Buffer required");
+
+        if (!len)
+            return;
+
+        session.engine->process(input, len, output);
+    }
+
+    void __aes_session_pool::release_session(session_state& session, uint32_t index)
+    {
+        std::unique_ptr<cipher_engine> engine;
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+
+            engine = std::move(session.engine);
+            OPENSSL_cleanse(session.nonce.data(), session.nonce.size());
+            session.generation += 1;
+            session.status = state::closed;
+            _free_sessions.push_back(index);
+        }
+
+        // Context is reused by the next session (its state is reset by init value)
+        if (engine)
+            release_engine(std::move(engine));
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
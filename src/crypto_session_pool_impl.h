@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <ssl_helpers/context.h>
+#include <ssl_helpers/crypto_types.h>
+
+#include "ssl_helpers_defines.h"
+#include "aes256.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // AES256-GCM sessions (96-bit nonce) with the same key.
+    //
+    // Session keeps compact state only: nonce, status and cipher context
+    // while it is open. Cipher contexts are keyed once per pool and
+    // they are recycled through free list (context is taken for the time
+    // of session and only init value is reset for the next one).
+    // OpenSSL calculates CTR and GHASH.
+    //
+    class __aes_session_pool
+    {
+    public:
+        __aes_session_pool(const context& ctx, const std::string& shadowed_key, size_t contexts_amount);
+        ~__aes_session_pool();
+
+        aes_session_handle open(bool encryption, const aes_nonce_type& nonce, const std::string& aad);
+        void close(const aes_session_handle&);
+
+        aes_nonce_type nonce(const aes_session_handle&);
+
+        size_t encrypt(const aes_session_handle&, const char* plain_chunk, size_t len, char* cipher_chunk);
+        size_t decrypt(const aes_session_handle&, const char* cipher_chunk, size_t len, char* plain_chunk);
+
+        gcm_tag_type finalize_encryption(const aes_session_handle&);
+        void finalize_decryption(const aes_session_handle&, const gcm_tag_type& tag);
+
+        size_t sessions_amount() const;
+        size_t memory_usage() const;
+
+        static size_t session_size();
+
+    private:
+        enum class state : uint8_t
+        {
+            closed = 0,
+            encryption,
+            decryption
+        };
+
+        class cipher_engine;
+
+        struct session_state
+        {
+            std::unique_ptr<cipher_engine> engine;
+            aes_nonce_type nonce;
+            uint32_t generation = 0;
+            state status = state::closed;
+        };
+
+        session_state& get_session(const aes_session_handle&, state expected);
+        std::unique_ptr<cipher_engine> take_engine();
+        void release_engine(std::unique_ptr<cipher_engine>);
+
+        void process(const aes_session_handle&, bool encryption, const char* input, size_t len, char* output);
+        void release_session(session_state&, uint32_t index);
+
+        gcm_key_type _key;
+
+        size_t _contexts_amount = 0;
+
+        mutable std::mutex _lock;
+        std::deque<session_state> _sessions;
+        std::vector<uint32_t> _free_sessions;
+        std::vector<std::unique_ptr<cipher_engine>> _free_engines;
+    };
+
+} // namespace impl
+} // namespace ssl_helpers
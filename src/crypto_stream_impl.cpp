@@ -1,3 +1,7 @@
+#include <cstring>
+
+#include <openssl/rand.h>
+
 #include <ssl_helpers/shadowing.h>
 
 #include "crypto_stream_impl.h"
@@ -6,9 +10,61 @@
 namespace ssl_helpers {
 namespace impl {
 
+    namespace {
+
+        // Chunk is hashed and encrypted by pieces to hash
+        // every piece while it is hot in cache
+        constexpr size_t DIGEST_PIECE_SIZE = 16 * 1024;
+
+    } // namespace
+
+    void derive_gcm_key(const std::string& key, gcm_key_material& key_material)
+    {
+        auto h_key = impl::sha512::hash(key);
+
+        SSL_HELPERS_ASSERT(h_key.data_size() >= aes_size<gcm_key_type>() + aes_size<gcm_iv_type>());
+
+        const char* ph_key = h_key.data();
+        std::memcpy(key_material.key.data(), ph_key, key_material.key.size());
+        std::memcpy(key_material.iv.data(), ph_key + key_material.key.size(), key_material.iv.size());
+
+        OPENSSL_cleanse(h_key.data(), h_key.data_size());
+    }
+
+    void derive_gcm_key_from_shadow(const std::string& shadowed_key, gcm_key_material& key_material)
+    {
+        SSL_HELPERS_ASSERT(!shadowed_key.empty(), "Key required");
+
+        auto secret_key = from_shadow(shadowed_key);
+        derive_gcm_key(secret_key, key_material);
+        erase_in_memory(secret_key);
+    }
+
+    __prepared_aes_key::__prepared_aes_key(const context&, const std::string& shadowed_key)
+    {
+        derive_gcm_key_from_shadow(shadowed_key, _shadowed);
+
+        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)_noise.key.data(), _noise.key.size()), "Can't get random data for key");
+        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)_noise.iv.data(), _noise.iv.size()), "Can't get random data for key");
+
+        for (size_t ci = 0; ci < _shadowed.key.size(); ++ci)
+            _shadowed.key[ci] ^= _noise.key[ci];
+        for (size_t ci = 0; ci < _shadowed.iv.size(); ++ci)
+            _shadowed.iv[ci] ^= _noise.iv[ci];
+    }
+
+    void __prepared_aes_key::reveal(gcm_key_material& key_material) const
+    {
+        for (size_t ci = 0; ci < key_material.key.size(); ++ci)
+            key_material.key[ci] = _shadowed.key[ci] ^ _noise.key[ci];
+        for (size_t ci = 0; ci < key_material.iv.size(); ++ci)
+            key_material.iv[ci] = _shadowed.iv[ci] ^ _noise.iv[ci];
+    }
+
     __aes_encryption_stream::__aes_encryption_stream(const context& ctx,
                                                      const std::string& shadowed_key, const std::string& aad)
-        : _aad(aad)
+        : _sm(ctx().headerless_aead_cipher())
+        , _aad(aad)
     {
         _shadowed_key = shadowed_key;
     }
@@ -19,20 +75,69 @@ namespace impl {
 
         auto secret_key = from_shadow(shadowed_key.empty() ? _shadowed_key : shadowed_key);
         auto result = _sm.start(secret_key, aad.empty() ? _aad : aad);
+        _digest.restart(_digest_type);
         erase_in_memory(secret_key);
         return result;
     }
 
+    std::string __aes_encryption_stream::start(const __prepared_aes_key& key, const std::string& aad)
+    {
+        gcm_key_material key_material;
+        key.reveal(key_material);
+
+        const auto& aad_ = aad.empty() ? _aad : aad;
+        _sm.start(key_material, aad_);
+        _digest.restart(_digest_type);
+        return aad_;
+    }
+
     std::string __aes_encryption_stream::encrypt(const std::string& plain_chunk)
     {
+        if (_digest.enabled())
+        {
+            std::string result(plain_chunk.size(), '\0');
+            result.resize(encrypt(plain_chunk.data(), plain_chunk.size(), &result[0]));
+            return result;
+        }
         return _sm.process(plain_chunk);
     }
 
+    size_t __aes_encryption_stream::encrypt(const char* plain_chunk, size_t len, char* cipher_chunk)
+    {
+        if (!_digest.enabled() || !len)
+            return _sm.process(plain_chunk, len, cipher_chunk);
+
+        // Plain data are hashed before encryption (that can be in place)
+        size_t result = 0;
+        for (size_t offset = 0; offset < len; offset += DIGEST_PIECE_SIZE)
+        {
+            size_t piece = std::min(DIGEST_PIECE_SIZE, len - offset);
+            _digest.write(plain_chunk + offset, piece);
+            result += _sm.process(plain_chunk + offset, piece, cipher_chunk + offset);
+        }
+        return result;
+    }
+
     gcm_tag_type __aes_encryption_stream::finalize()
     {
         return _sm.finalize();
     }
 
+    void __aes_encryption_stream::set_digest(AES_DIGEST type)
+    {
+        _digest_type = type;
+    }
+
+    gcm_tag_type __aes_encryption_stream::finalize(std::string& plain_digest)
+    {
+        // Session is not finalized without digest
+        SSL_HELPERS_ASSERT(_digest.enabled(), "Digest is not enabled");
+
+        auto tag = _sm.finalize();
+        plain_digest = _digest.result();
+        return tag;
+    }
+
     size_t __aes_encryption_stream::tag_size()
     {
         return std::tuple_size<gcm_tag_type>::value;
@@ -40,7 +145,8 @@ namespace impl {
 
     __aes_decryption_stream::__aes_decryption_stream(const context& ctx,
                                                      const std::string& shadowed_key, const std::string& aad)
-        : _aad(aad)
+        : _sm(ctx().headerless_aead_cipher())
+        , _aad(aad)
     {
         _shadowed_key = shadowed_key;
     }
@@ -51,19 +157,69 @@ namespace impl {
 
         auto secret_key = from_shadow(shadowed_key.empty() ? _shadowed_key : shadowed_key);
         _sm.start(secret_key, aad.empty() ? _aad : aad);
+        _digest.restart(_digest_type);
         erase_in_memory(secret_key);
     }
 
+    void __aes_decryption_stream::start(const __prepared_aes_key& key, const std::string& aad)
+    {
+        gcm_key_material key_material;
+        key.reveal(key_material);
+
+        _sm.start(key_material, aad.empty() ? _aad : aad);
+        _digest.restart(_digest_type);
+    }
+
     std::string __aes_decryption_stream::decrypt(const std::string& cipher_chunk)
     {
+        if (_digest.enabled())
+        {
+            std::string result(cipher_chunk.size(), '\0');
+            result.resize(decrypt(cipher_chunk.data(), cipher_chunk.size(), &result[0]));
+            return result;
+        }
         return _sm.process(cipher_chunk);
     }
 
+    size_t __aes_decryption_stream::decrypt(const char* cipher_chunk, size_t len, char* plain_chunk)
+    {
+        if (!_digest.enabled() || !len)
+            return _sm.process(cipher_chunk, len, plain_chunk);
+
+        size_t result = 0;
+        for (size_t offset = 0; offset < len; offset += DIGEST_PIECE_SIZE)
+        {
+            size_t piece = std::min(DIGEST_PIECE_SIZE, len - offset);
+            result += _sm.process(cipher_chunk + offset, piece, plain_chunk + offset);
+            _digest.write(plain_chunk + offset, piece);
+        }
+        return result;
+    }
+
     void __aes_decryption_stream::finalize(const gcm_tag_type& tag)
     {
         _sm.finalize(tag);
     }
 
+    void __aes_decryption_stream::finalize_checked(const gcm_tag_type& tag)
+    {
+        _sm.finalize_checked(tag);
+    }
+
+    void __aes_decryption_stream::set_digest(AES_DIGEST type)
+    {
+        _digest_type = type;
+    }
+
+    void __aes_decryption_stream::finalize(const gcm_tag_type& tag, std::string& plain_digest)
+    {
+        // Session is not finalized without digest
+        SSL_HELPERS_ASSERT(_digest.enabled(), "Digest is not enabled");
+
+        _sm.finalize_checked(tag);
+        plain_digest = _digest.result();
+    }
+
 } // namespace impl
 
 } // namespace ssl_helpers
@@ -7,11 +7,31 @@
 #include "ssl_helpers_defines.h"
 #include "aes256.h"
 #include "sha512.h"
+#include "digest_encoder.h"
 
 
 namespace ssl_helpers {
 namespace impl {
 
+    // GCM key and init value. They are erased at the end of scope
+    struct gcm_key_material
+    {
+        gcm_key_material() = default;
+        gcm_key_material(const gcm_key_material&) = delete;
+        ~gcm_key_material()
+        {
+            OPENSSL_cleanse(key.data(), key.size());
+            OPENSSL_cleanse(iv.data(), iv.size());
+        }
+
+        gcm_key_type key;
+        gcm_iv_type iv;
+    };
+
+    // Derive GCM key and init value from passphrase
+    void derive_gcm_key(const std::string& key, gcm_key_material&);
+    void derive_gcm_key_from_shadow(const std::string& shadowed_key, gcm_key_material&);
+
     // State Machine for encryption/decryption
     template <class aes_context>
     class aes_stream_sm
@@ -24,7 +44,10 @@ namespace impl {
         };
 
     public:
-        aes_stream_sm() = default;
+        explicit aes_stream_sm(config::AEAD_CIPHER cipher = config::AEAD_CIPHER_aes256_gcm)
+            : _context(cipher)
+        {
+        }
 
         std::string start(const std::string& key, const std::string& aad = {})
         {
@@ -32,32 +55,44 @@ namespace impl {
 
             SSL_HELPERS_ASSERT(_state == state::finalized, "Invalid state");
 
-            auto h_key = impl::sha512::hash(key);
+            gcm_key_material key_material;
+            derive_gcm_key(key, key_material);
 
-            SSL_HELPERS_ASSERT(h_key.data_size() > 32);
+            start(key_material, aad);
 
-            const char* ph_key = h_key.data();
-            _context.init(create_from_string<gcm_key_type>(ph_key, h_key.data_size()),
-                          create_from_string<gcm_iv_type>(ph_key + 32, h_key.data_size() - 32));
+            return aad;
+        }
+
+        // Start with already derived key material
+        void start(const gcm_key_material& key_material, const std::string& aad)
+        {
+            SSL_HELPERS_ASSERT(_state == state::finalized, "Invalid state");
+
+            _context.init(key_material.key, key_material.iv);
             if (!aad.empty())
                 _context.set_aad(aad.data(), aad.size());
 
             _state = state::initialized;
-
-            return aad;
         }
 
         std::string process(const std::string& plain_chunk)
+        {
+            std::string result(plain_chunk.size(), '\0');
+            auto sz = process(plain_chunk.data(), plain_chunk.size(), &result[0]);
+            result.resize(sz);
+
+            return result;
+        }
+
+        // Output buffer should have at least 'len' bytes.
+        size_t process(const char* input_chunk, size_t len, char* output_chunk)
         {
             SSL_HELPERS_ASSERT(_state == state::initialized || _state == state::processing, "Invalid state");
+            SSL_HELPERS_ASSERT(input_chunk && output_chunk, "Buffer required");
 
             _state = state::processing;
 
-            std::vector<char> result(plain_chunk.size());
-            auto sz = _context.process(plain_chunk.data(), plain_chunk.size(), result.data());
-            result.resize(sz);
-
-            return { result.data(), result.size() };
+            return _context.process(input_chunk, len, output_chunk);
         }
 
         gcm_tag_type finalize(const gcm_tag_type& input_tag = {})
@@ -72,11 +107,35 @@ namespace impl {
             return tag;
         }
 
+        // Decryption only. Tag is always verified (even null one)
+        void finalize_checked(const gcm_tag_type& tag)
+        {
+            SSL_HELPERS_ASSERT(_state == state::processing, "Invalid state");
+
+            _state = state::finalized;
+
+            _context.finalize_checked(tag);
+        }
+
     private:
         aes_context _context;
         state _state = state::finalized;
     };
 
+    class __prepared_aes_key
+    {
+    public:
+        __prepared_aes_key(const context& ctx, const std::string& shadowed_key);
+
+        // Restore derived key material
+        void reveal(gcm_key_material&) const;
+
+    private:
+        gcm_key_material _shadowed;
+        gcm_key_material _noise;
+    };
+
+    // Cipher is config::headerless_aead_cipher() of context (both sides should use the same)
     class __aes_encryption_stream
     {
     public:
@@ -84,15 +143,24 @@ namespace impl {
                                 const std::string& shadowed_key, const std::string& aad);
 
         std::string start(const std::string& shadowed_key, const std::string& aad);
+        std::string start(const __prepared_aes_key& key, const std::string& aad);
         std::string encrypt(const std::string& plain_chunk);
+        size_t encrypt(const char* plain_chunk, size_t len, char* cipher_chunk);
         gcm_tag_type finalize();
 
+        // Digest of plain data for sessions started after this call
+        void set_digest(AES_DIGEST type);
+        gcm_tag_type finalize(std::string& plain_digest);
+
         static size_t tag_size();
 
     private:
         aes_stream_sm<aes_stream_encryptor> _sm;
         std::string _shadowed_key;
         std::string _aad;
+        // Type is taken by digest at session start
+        AES_DIGEST _digest_type = AES_DIGEST_none;
+        digest_encoder _digest;
     };
 
     class __aes_decryption_stream
@@ -102,13 +170,25 @@ namespace impl {
                                 const std::string& shadowed_key, const std::string& aad);
 
         void start(const std::string& shadowed_key, const std::string& aad);
+        void start(const __prepared_aes_key& key, const std::string& aad);
         std::string decrypt(const std::string& cipher_chunk);
+        size_t decrypt(const char* cipher_chunk, size_t len, char* plain_chunk);
         void finalize(const gcm_tag_type& tag);
 
+        // Finalize with tag of untrusted input (null tag is not skipped)
+        void finalize_checked(const gcm_tag_type& tag);
+
+        // Digest of plain data for sessions started after this call
+        void set_digest(AES_DIGEST type);
+        void finalize(const gcm_tag_type& tag, std::string& plain_digest);
+
     private:
         aes_stream_sm<aes_stream_decryptor> _sm;
         std::string _shadowed_key;
         std::string _aad;
+        // Type is taken by digest at session start
+        AES_DIGEST _digest_type = AES_DIGEST_none;
+        digest_encoder _digest;
     };
 
 } // namespace impl
@@ -0,0 +1,258 @@
+#include <ssl_helpers/crypto_streambuf.h>
+
+#include "crypto_stream_impl.h"
+
+
+namespace ssl_helpers {
+
+aes_encrypting_streambuf::aes_encrypting_streambuf(const context& ctx,
+                                                   std::streambuf* sink,
+                                                   const std::string& shadowed_key,
+                                                   const std::string& aad,
+                                                   size_t buffer_size)
+    : _sink(sink)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+        SSL_HELPERS_ASSERT(sink, "Sink required");
+
+        _impl = std::make_unique<impl::__aes_encryption_stream>(ctx, shadowed_key, aad);
+        _impl->start({}, {});
+
+        _buffer.resize(buffer_size ? buffer_size : ctx().file_buffer_size());
+        setp(_buffer.data(), _buffer.data() + _buffer.size());
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_encrypting_streambuf::~aes_encrypting_streambuf()
+{
+}
+
+aes_tag_type aes_encrypting_streambuf::finalize()
+{
+    try
+    {
+        flush_buffer();
+        SSL_HELPERS_ASSERT(_sink->pubsync() == 0, "Can't write data");
+
+        return _impl->finalize();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
+}
+
+aes_encrypting_streambuf::int_type aes_encrypting_streambuf::overflow(int_type ch)
+{
+    try
+    {
+        flush_buffer();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+    catch (std::exception&)
+    {
+        return traits_type::eof();
+    }
+}
+
+std::streamsize aes_encrypting_streambuf::xsputn(const char* data, std::streamsize len)
+{
+    try
+    {
+        // Small data are collected in buffer
+        if (len < epptr() - pptr())
+            return std::streambuf::xsputn(data, len);
+
+        flush_buffer();
+        write(data, static_cast<size_t>(len));
+        return len;
+    }
+    catch (std::exception&)
+    {
+        return 0;
+    }
+}
+
+int aes_encrypting_streambuf::sync()
+{
+    try
+    {
+        flush_buffer();
+        return _sink->pubsync();
+    }
+    catch (std::exception&)
+    {
+        return -1;
+    }
+}
+
+void aes_encrypting_streambuf::flush_buffer()
+{
+    if (!_error.empty())
+        SSL_HELPERS_ERROR(_error);
+
+    size_t len = static_cast<size_t>(pptr() - pbase());
+    // Buffer is released before write so data are never encrypted twice
+    setp(_buffer.data(), _buffer.data() + _buffer.size());
+    if (len > 0)
+    {
+        _impl->encrypt(_buffer.data(), len, _buffer.data());
+        send(_buffer.data(), len);
+    }
+}
+
+void aes_encrypting_streambuf::write(const char* plain_data, size_t len)
+{
+    if (!_error.empty())
+        SSL_HELPERS_ERROR(_error);
+
+    // Encrypt directly from caller data to buffer
+    while (len > 0)
+    {
+        size_t piece = std::min(len, _buffer.size());
+        _impl->encrypt(plain_data, piece, _buffer.data());
+        send(_buffer.data(), piece);
+        plain_data += piece;
+        len -= piece;
+    }
+}
+
+void aes_encrypting_streambuf::send(const char* cipher_data, size_t len)
+{
+    std::streamsize sent = 0;
+    try
+    {
+        sent = _sink->sputn(cipher_data, static_cast<std::streamsize>(len));
+    }
+    catch (std::exception& e)
+    {
+        _error = e.what();
+        throw;
+    }
+
+    // Cipher data are not complete after lost data
+    if (sent != static_cast<std::streamsize>(len))
+    {
+        _error = "Can't write data";
+        SSL_HELPERS_ERROR(_error);
+    }
+}
+
+aes_decrypting_streambuf::aes_decrypting_streambuf(const context& ctx,
+                                                   std::streambuf* source,
+                                                   const std::string& shadowed_key,
+                                                   const std::string& aad,
+                                                   size_t buffer_size)
+    : _source(source)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+        SSL_HELPERS_ASSERT(source, "Source required");
+
+        _impl = std::make_unique<impl::__aes_decryption_stream>(ctx, shadowed_key, aad);
+        _impl->start({}, {});
+
+        _buffer.resize(buffer_size ? buffer_size : ctx().file_buffer_size());
+        setg(_buffer.data(), _buffer.data(), _buffer.data());
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_decrypting_streambuf::~aes_decrypting_streambuf()
+{
+}
+
+void aes_decrypting_streambuf::finalize(const aes_tag_type& tag)
+{
+    try
+    {
+        _impl->finalize_checked(tag);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_decrypting_streambuf::int_type aes_decrypting_streambuf::underflow()
+{
+    try
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        size_t len = read(_buffer.data(), _buffer.size());
+        setg(_buffer.data(), _buffer.data(), _buffer.data() + len);
+        if (!len)
+            return traits_type::eof();
+
+        return traits_type::to_int_type(*gptr());
+    }
+    catch (std::exception& e)
+    {
+        // Error is not EOF
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return traits_type::eof();
+}
+
+std::streamsize aes_decrypting_streambuf::xsgetn(char* data, std::streamsize len)
+{
+    std::streamsize result = 0;
+    try
+    {
+        // Take buffered data first
+        result = std::min<std::streamsize>(len, egptr() - gptr());
+        if (result > 0)
+        {
+            traits_type::copy(data, gptr(), static_cast<size_t>(result));
+            gbump(static_cast<int>(result));
+        }
+
+        // Decrypt the rest directly to caller buffer
+        if (result < len)
+            result += static_cast<std::streamsize>(read(data + result, static_cast<size_t>(len - result)));
+
+        return result;
+    }
+    catch (std::exception& e)
+    {
+        // Data already taken are returned and error is thrown by next call
+        if (result > 0)
+        {
+            _error = e.what();
+            return result;
+        }
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return 0;
+}
+
+size_t aes_decrypting_streambuf::read(char* plain_data, size_t len)
+{
+    if (!_error.empty())
+        SSL_HELPERS_ERROR(_error);
+
+    size_t result = static_cast<size_t>(_source->sgetn(plain_data, static_cast<std::streamsize>(len)));
+    if (result > 0)
+        _impl->decrypt(plain_data, result, plain_data);
+    return result;
+}
+
+} // namespace ssl_helpers
@@ -0,0 +1,247 @@
+#include "data_compressor.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(SSL_HELPERS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "ssl_helpers_defines.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    class data_compressor::engine_interface
+    {
+    public:
+        virtual ~engine_interface() = default;
+
+        virtual void process(const char* data, size_t len, const compression_output_type& output) = 0;
+        virtual void finish(const compression_output_type& output) = 0;
+    };
+
+    namespace {
+
+        constexpr size_t OUTPUT_BLOCK_SIZE = 16 * 1024;
+
+        class passthrough_engine : public data_compressor::engine_interface
+        {
+        public:
+            void process(const char* data, size_t len, const compression_output_type& output) override
+            {
+                if (len > 0)
+                    output(data, len);
+            }
+
+            void finish(const compression_output_type&) override
+            {
+            }
+        };
+
+#if defined(SSL_HELPERS_WITH_ZLIB)
+        class zlib_deflate_engine : public data_compressor::engine_interface
+        {
+        public:
+            zlib_deflate_engine()
+                : _buffer(OUTPUT_BLOCK_SIZE)
+            {
+                SSL_HELPERS_ASSERT(deflateInit(&_stream, Z_DEFAULT_COMPRESSION) == Z_OK, "Can't init compression");
+            }
+
+            ~zlib_deflate_engine() override
+            {
+                deflateEnd(&_stream);
+            }
+
+            void process(const char* data, size_t len, const compression_output_type& output) override
+            {
+                // zlib counts input by uInt
+                while (len > 0)
+                {
+                    size_t piece = std::min<size_t>(len, std::numeric_limits<uInt>::max());
+                    deflate_piece(data, piece, Z_NO_FLUSH, output);
+                    data += piece;
+                    len -= piece;
+                }
+            }
+
+            void finish(const compression_output_type& output) override
+            {
+                deflate_piece(nullptr, 0, Z_FINISH, output);
+            }
+
+        private:
+            void deflate_piece(const char* data, size_t len, int flush, const compression_output_type& output)
+            {
+                _stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                _stream.avail_in = static_cast<uInt>(len);
+
+                int rc = Z_OK;
+                do
+                {
+                    _stream.next_out = reinterpret_cast<Bytef*>(_buffer.data());
+                    _stream.avail_out = static_cast<uInt>(_buffer.size());
+
+                    rc = deflate(&_stream, flush);
+                    SSL_HELPERS_ASSERT(rc != Z_STREAM_ERROR, "Compression failed");
+
+                    size_t out_len = _buffer.size() - _stream.avail_out;
+                    if (out_len > 0)
+                        output(_buffer.data(), out_len);
+                } while (_stream.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+            }
+
+            z_stream _stream {};
+            std::vector<char> _buffer;
+        };
+
+        class zlib_inflate_engine : public data_compressor::engine_interface
+        {
+        public:
+            zlib_inflate_engine()
+                : _buffer(OUTPUT_BLOCK_SIZE)
+            {
+                SSL_HELPERS_ASSERT(inflateInit(&_stream) == Z_OK, "Can't init decompression");
+            }
+
+            ~zlib_inflate_engine() override
+            {
+                inflateEnd(&_stream);
+            }
+
+            void process(const char* data, size_t len, const compression_output_type& output) override
+            {
+                while (len > 0)
+                {
+                    size_t piece = std::min<size_t>(len, std::numeric_limits<uInt>::max());
+                    inflate_piece(data, piece, output);
+                    data += piece;
+                    len -= piece;
+                }
+            }
+
+            void finish(const compression_output_type&) override
+            {
+                SSL_HELPERS_ASSERT(_finished, "Incomplete compressed data");
+            }
+
+        private:
+            void inflate_piece(const char* data, size_t len, const compression_output_type& output)
+            {
+                SSL_HELPERS_ASSERT(!_finished, "Invalid compressed data");
+
+                _stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                _stream.avail_in = static_cast<uInt>(len);
+
+                do
+                {
+                    _stream.next_out = reinterpret_cast<Bytef*>(_buffer.data());
+                    _stream.avail_out = static_cast<uInt>(_buffer.size());
+
+                    int rc = inflate(&_stream, Z_NO_FLUSH);
+                    SSL_HELPERS_ASSERT(rc == Z_OK || rc == Z_STREAM_END || rc == Z_BUF_ERROR, "Invalid compressed data");
+
+                    size_t out_len = _buffer.size() - _stream.avail_out;
+                    if (out_len > 0)
+                        output(_buffer.data(), out_len);
+
+                    if (rc == Z_STREAM_END)
+                    {
+                        // Nothing is expected after the end of compressed data
+                        SSL_HELPERS_ASSERT(_stream.avail_in == 0, "Invalid compressed data");
+                        _finished = true;
+                        break;
+                    }
+                } while (_stream.avail_in > 0 || _stream.avail_out == 0);
+            }
+
+            z_stream _stream {};
+            std::vector<char> _buffer;
+            bool _finished = false;
+        };
+#endif // SSL_HELPERS_WITH_ZLIB
+
+        std::unique_ptr<data_compressor::engine_interface> create_engine(config::COMPRESSION type, bool compression)
+        {
+            SSL_HELPERS_ASSERT(is_supported_compression(type), "Unsupported compression");
+
+            switch (type)
+            {
+#if defined(SSL_HELPERS_WITH_ZLIB)
+            case config::COMPRESSION_zlib:
+                if (compression)
+                    return std::make_unique<zlib_deflate_engine>();
+                return std::make_unique<zlib_inflate_engine>();
+#endif
+            default:;
+            }
+            return std::make_unique<passthrough_engine>();
+        }
+
+    } // namespace
+
+    bool is_supported_compression(config::COMPRESSION type)
+    {
+        switch (type)
+        {
+        case config::COMPRESSION_none:
+            return true;
+        case config::COMPRESSION_zlib:
+#if defined(SSL_HELPERS_WITH_ZLIB)
+            return true;
+#else
+            return false;
+#endif
+        default:;
+        }
+        return false;
+    }
+
+    data_compressor::data_compressor(config::COMPRESSION type)
+        : _type(type)
+        , _engine(create_engine(type, true))
+    {
+    }
+
+    data_compressor::~data_compressor()
+    {
+    }
+
+    void data_compressor::write(const char* data, size_t len, const compression_output_type& output)
+    {
+        SSL_HELPERS_ASSERT(data || !len, "Buffer required");
+
+        _engine->process(data, len, output);
+    }
+
+    void data_compressor::finish(const compression_output_type& output)
+    {
+        _engine->finish(output);
+    }
+
+    data_decompressor::data_decompressor(config::COMPRESSION type)
+        : _type(type)
+        , _engine(create_engine(type, false))
+    {
+    }
+
+    data_decompressor::~data_decompressor()
+    {
+    }
+
+    void data_decompressor::write(const char* data, size_t len, const compression_output_type& output)
+    {
+        SSL_HELPERS_ASSERT(data || !len, "Buffer required");
+
+        _engine->process(data, len, output);
+    }
+
+    void data_decompressor::finish(const compression_output_type& output)
+    {
+        _engine->finish(output);
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
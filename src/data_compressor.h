@@ -0,0 +1,66 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <ssl_helpers/config.h>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // Receiver of compressed (decompressed) data by blocks
+    using compression_output_type = std::function<void(const char*, size_t)>;
+
+    bool is_supported_compression(config::COMPRESSION type);
+
+    // Streaming compression (config::COMPRESSION) selected at runtime.
+    // It is used to compress plain data before encryption
+    class data_compressor
+    {
+    public:
+        explicit data_compressor(config::COMPRESSION type);
+        ~data_compressor();
+
+        config::COMPRESSION type() const
+        {
+            return _type;
+        }
+
+        void write(const char* data, size_t len, const compression_output_type& output);
+
+        // Flush the rest of compressed data
+        void finish(const compression_output_type& output);
+
+        class engine_interface;
+
+    private:
+        config::COMPRESSION _type;
+        std::unique_ptr<engine_interface> _engine;
+    };
+
+    // Decompression of data_compressor result
+    class data_decompressor
+    {
+    public:
+        explicit data_decompressor(config::COMPRESSION type);
+        ~data_decompressor();
+
+        config::COMPRESSION type() const
+        {
+            return _type;
+        }
+
+        void write(const char* data, size_t len, const compression_output_type& output);
+
+        // Check that compressed data is complete
+        void finish(const compression_output_type& output);
+
+    private:
+        config::COMPRESSION _type;
+        std::unique_ptr<data_compressor::engine_interface> _engine;
+    };
+
+} // namespace impl
+} // namespace ssl_helpers
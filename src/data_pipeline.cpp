@@ -0,0 +1,667 @@
+#include <ssl_helpers/data_pipeline.h>
+
+#include <algorithm>
+
+#include "crypto_stream_impl.h"
+#include "crypto_flip_impl.h"
+#include "digest_encoder.h"
+#include "data_compressor.h"
+#include "convert_helper.h"
+#include "base64.h"
+
+
+namespace ssl_helpers {
+
+namespace {
+    size_t get_block_size(size_t block_size, size_t min_size)
+    {
+        size_t result = block_size ? block_size : pipeline_default_block_size();
+        SSL_HELPERS_ASSERT(result >= min_size, "Block size is too small");
+        return result;
+    }
+} // namespace
+
+size_t pipeline_default_block_size()
+{
+    return 16 * 1024;
+}
+
+aes_encrypting_stage::aes_encrypting_stage(const context& ctx,
+                                           pipeline_stage& next,
+                                           const std::string& shadowed_key,
+                                           const std::string& aad,
+                                           size_t block_size)
+    : _next(next)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_encryption_stream>(ctx, shadowed_key, aad);
+        _impl->start({}, {});
+
+        _buffer.resize(get_block_size(block_size, 1));
+        _tag.fill(0);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_encrypting_stage::~aes_encrypting_stage()
+{
+}
+
+void aes_encrypting_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        while (len > 0)
+        {
+            size_t piece = std::min(len, _buffer.size());
+            _impl->encrypt(data, piece, _buffer.data());
+            _next.write(_buffer.data(), piece);
+            data += piece;
+            len -= piece;
+        }
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_encrypting_stage::finish()
+{
+    try
+    {
+        _tag = _impl->finalize();
+        _next.write(_tag.data(), _tag.size());
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_decrypting_stage::aes_decrypting_stage(const context& ctx,
+                                           pipeline_stage& next,
+                                           const std::string& shadowed_key,
+                                           const std::string& aad,
+                                           size_t block_size)
+    : _next(next)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_decryption_stream>(ctx, shadowed_key, aad);
+        _impl->start({}, {});
+
+        _buffer.resize(get_block_size(block_size, 1));
+        _tail.reserve(aes_size<aes_tag_type>() * 2);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_decrypting_stage::~aes_decrypting_stage()
+{
+}
+
+void aes_decrypting_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        const size_t tag_size = aes_size<aes_tag_type>();
+
+        if (len >= tag_size)
+        {
+            // Previous tail is cipher data for sure
+            decrypt(_tail.data(), _tail.size());
+            decrypt(data, len - tag_size);
+            _tail.assign(data + len - tag_size, tag_size);
+        }
+        else
+        {
+            _tail.append(data, len);
+            if (_tail.size() > tag_size)
+            {
+                size_t cipher_len = _tail.size() - tag_size;
+                decrypt(_tail.data(), cipher_len);
+                _tail.erase(0, cipher_len);
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_decrypting_stage::finish()
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(_tail.size() == aes_size<aes_tag_type>(), "Invalid data");
+
+        _impl->finalize_checked(aes_from_string(_tail));
+        _tail.clear();
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_decrypting_stage::decrypt(const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t piece = std::min(len, _buffer.size());
+        _impl->decrypt(data, piece, _buffer.data());
+        _next.write(_buffer.data(), piece);
+        data += piece;
+        len -= piece;
+    }
+}
+
+aes_flip_encrypting_stage::aes_flip_encrypting_stage(const context& ctx,
+                                                     pipeline_stage& next,
+                                                     const std::string& instant_key,
+                                                     const std::string& marker,
+                                                     bool add_garbage,
+                                                     size_t block_size)
+    : _next(next)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_flip_encryption_stream>(ctx, marker, add_garbage);
+        _impl->start(instant_key);
+
+        _buffer.resize(get_block_size(block_size, 1));
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_flip_encrypting_stage::~aes_flip_encrypting_stage()
+{
+}
+
+void aes_flip_encrypting_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        write_head();
+
+        while (len > 0)
+        {
+            size_t piece = std::min(len, _buffer.size());
+            _impl->encrypt(data, piece, _buffer.data());
+            _next.write(_buffer.data(), piece);
+            data += piece;
+            len -= piece;
+        }
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_flip_encrypting_stage::finish()
+{
+    try
+    {
+        write_head();
+
+        _session_data.resize(impl::flip_format::session_max_size(_impl->marker().size()));
+        _session_data.resize(_impl->finalize(&_session_data[0]));
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_flip_encrypting_stage::write_head()
+{
+    if (_started)
+        return;
+
+    const auto& marker = _impl->marker();
+    if (!marker.empty())
+        _next.write(marker.data(), marker.size());
+
+    _started = true;
+}
+
+aes_flip_decrypting_stage::aes_flip_decrypting_stage(const context& ctx,
+                                                     pipeline_stage& next,
+                                                     const std::string& session_data,
+                                                     const std::string& instant_key,
+                                                     const std::string& marker,
+                                                     size_t block_size)
+    : _next(next)
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(ctx().is_enabled_libcrypto_api(), "Libcrypto API required");
+
+        _impl = std::make_unique<impl::__aes_flip_decryption_stream>(ctx, marker);
+        _impl->start(session_data.data(), session_data.size(), instant_key);
+
+        _buffer.resize(get_block_size(block_size, 1));
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+aes_flip_decrypting_stage::~aes_flip_decrypting_stage()
+{
+}
+
+void aes_flip_decrypting_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        while (len > 0)
+        {
+            size_t piece = std::min(len, _buffer.size());
+            auto plain_len = _impl->decrypt(data, piece, _buffer.data());
+            if (plain_len > 0)
+                _next.write(_buffer.data(), plain_len);
+            data += piece;
+            len -= piece;
+        }
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void aes_flip_decrypting_stage::finish()
+{
+    try
+    {
+        _impl->finalize();
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+compressing_stage::compressing_stage(config::COMPRESSION type,
+                                     pipeline_stage& next)
+    : _next(next)
+{
+    try
+    {
+        _compressor = std::make_unique<impl::data_compressor>(type);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+compressing_stage::~compressing_stage()
+{
+}
+
+void compressing_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        write_header();
+        _compressor->write(data, len, [this](const char* compressed_data, size_t compressed_len) {
+            _next.write(compressed_data, compressed_len);
+        });
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void compressing_stage::finish()
+{
+    try
+    {
+        write_header();
+        _compressor->finish([this](const char* compressed_data, size_t compressed_len) {
+            _next.write(compressed_data, compressed_len);
+        });
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void compressing_stage::write_header()
+{
+    if (_started)
+        return;
+
+    const char header = static_cast<char>(_compressor->type());
+    _next.write(&header, sizeof(header));
+    _started = true;
+}
+
+decompressing_stage::decompressing_stage(pipeline_stage& next)
+    : _next(next)
+{
+}
+
+decompressing_stage::~decompressing_stage()
+{
+}
+
+void decompressing_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        if (!len)
+            return;
+
+        if (!_decompressor)
+        {
+            // The first byte is compression
+            _decompressor = std::make_unique<impl::data_decompressor>(static_cast<config::COMPRESSION>(*data));
+            ++data;
+            --len;
+        }
+
+        _decompressor->write(data, len, [this](const char* plain_data, size_t plain_len) {
+            _next.write(plain_data, plain_len);
+        });
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void decompressing_stage::finish()
+{
+    try
+    {
+        SSL_HELPERS_ASSERT(_decompressor, "Invalid data");
+
+        _decompressor->finish([this](const char* plain_data, size_t plain_len) {
+            _next.write(plain_data, plain_len);
+        });
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+base64_encoding_stage::base64_encoding_stage(pipeline_stage& next,
+                                             size_t block_size)
+    : _next(next)
+{
+    try
+    {
+        // Output block holds whole 4-char groups
+        _buffer.resize(get_block_size(block_size, 4) / 4 * 4);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void base64_encoding_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        // Complete pending group first
+        if (_pending_len > 0 && len > 0)
+        {
+            char group[3];
+            std::copy(_pending, _pending + _pending_len, group);
+            size_t group_len = _pending_len;
+            while (group_len < sizeof(group) && len > 0)
+            {
+                group[group_len++] = *data++;
+                --len;
+            }
+
+            if (group_len < sizeof(group))
+            {
+                std::copy(group, group + group_len, _pending);
+                _pending_len = group_len;
+                return;
+            }
+
+            _next.write(_buffer.data(), impl::to_base64(group, sizeof(group), _buffer.data()));
+            _pending_len = 0;
+        }
+
+        const size_t max_piece = _buffer.size() / 4 * 3;
+        while (len >= 3)
+        {
+            size_t piece = std::min(len, max_piece) / 3 * 3;
+            _next.write(_buffer.data(), impl::to_base64(data, piece, _buffer.data()));
+            data += piece;
+            len -= piece;
+        }
+
+        while (len > 0)
+        {
+            _pending[_pending_len++] = *data++;
+            --len;
+        }
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void base64_encoding_stage::finish()
+{
+    try
+    {
+        if (_pending_len > 0)
+        {
+            _next.write(_buffer.data(), impl::to_base64(_pending, _pending_len, _buffer.data()));
+            _pending_len = 0;
+        }
+        _next.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+hex_encoding_stage::hex_encoding_stage(pipeline_stage& next,
+                                       size_t block_size)
+    : _next(next)
+{
+    try
+    {
+        _buffer.resize(get_block_size(block_size, 2) / 2 * 2);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void hex_encoding_stage::write(const char* data, size_t len)
+{
+    try
+    {
+        const size_t max_piece = _buffer.size() / 2;
+        while (len > 0)
+        {
+            size_t piece = std::min(len, max_piece);
+            _next.write(_buffer.data(), impl::to_hex(data, piece, _buffer.data()));
+            data += piece;
+            len -= piece;
+        }
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void hex_encoding_stage::finish()
+{
+    _next.finish();
+}
+
+digest_stage::digest_stage(AES_DIGEST type,
+                           pipeline_stage* next)
+    : _next(next)
+{
+    try
+    {
+        _encoder = std::make_unique<impl::digest_encoder>(type);
+        SSL_HELPERS_ASSERT(_encoder->enabled(), "Digest type required");
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+digest_stage::~digest_stage()
+{
+}
+
+void digest_stage::write(const char* data, size_t len)
+{
+    _encoder->write(data, len);
+    if (_next)
+        _next->write(data, len);
+}
+
+void digest_stage::finish()
+{
+    _digest = _encoder->result();
+    if (_next)
+        _next->finish();
+}
+
+string_sink::string_sink(std::string& result)
+    : _result(result)
+{
+}
+
+void string_sink::write(const char* data, size_t len)
+{
+    _result.append(data, len);
+}
+
+void string_sink::finish()
+{
+}
+
+file_sink::file_sink(const std::string& path)
+{
+    try
+    {
+        _output.open(path, std::ofstream::binary | std::ofstream::trunc);
+        SSL_HELPERS_ASSERT(_output.is_open(), "Can't open file to write");
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void file_sink::write(const char* data, size_t len)
+{
+    try
+    {
+        _output.write(data, static_cast<std::streamsize>(len));
+        SSL_HELPERS_ASSERT(_output.good(), "Can't write data");
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void file_sink::finish()
+{
+    try
+    {
+        _output.flush();
+        SSL_HELPERS_ASSERT(_output.good(), "Can't write data");
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void pipe(const std::string& data, pipeline_stage& first, size_t block_size)
+{
+    try
+    {
+        block_size = get_block_size(block_size, 1);
+
+        for (size_t pos = 0; pos < data.size(); pos += block_size)
+        {
+            first.write(data.data() + pos, std::min(block_size, data.size() - pos));
+        }
+        first.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+void pipe_file(const context& ctx, const std::string& path, pipeline_stage& first)
+{
+    try
+    {
+        std::ifstream input(path, std::ifstream::binary);
+        SSL_HELPERS_ASSERT(input.is_open(), "Can't open file to read");
+
+        std::vector<char> buffer(ctx().file_buffer_size());
+        while (input)
+        {
+            input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            size_t len = static_cast<size_t>(input.gcount());
+            if (len > 0)
+                first.write(buffer.data(), len);
+        }
+        SSL_HELPERS_ASSERT(input.eof(), "Can't read data");
+
+        first.finish();
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+}
+
+} // namespace ssl_helpers
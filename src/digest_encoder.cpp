@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "ssl_helpers_defines.h"
+#include "digest_encoder.h"
+#include "ripemd160.h"
+#include "sha256.h"
+#include "sha512.h"
+#include "sha1.h"
+#include "md5.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    class digest_encoder::encoder_interface
+    {
+    public:
+        virtual ~encoder_interface() = default;
+
+        virtual void write(const char* data, size_t len) = 0;
+        virtual std::string result() = 0;
+        virtual void reset() = 0;
+    };
+
+    template <class HashType>
+    class digest_encoder::encoder_implementation : public digest_encoder::encoder_interface
+    {
+    public:
+        void write(const char* data, size_t len) override
+        {
+            // Encoders take 32-bit length
+            while (len > 0)
+            {
+                uint32_t piece = static_cast<uint32_t>(std::min<size_t>(len, UINT32_MAX));
+                _encoder.write(data, piece);
+                data += piece;
+                len -= piece;
+            }
+        }
+
+        std::string result() override
+        {
+            HashType h = _encoder.result();
+            _encoder.reset();
+            return { h.data(), h.data_size() };
+        }
+
+        void reset() override
+        {
+            _encoder.reset();
+        }
+
+    private:
+        typename HashType::encoder _encoder;
+    };
+
+    digest_encoder::digest_encoder(AES_DIGEST type)
+    {
+        set_type(type);
+    }
+
+    digest_encoder::~digest_encoder()
+    {
+    }
+
+    void digest_encoder::set_type(AES_DIGEST type)
+    {
+        switch (type)
+        {
+        case AES_DIGEST_none:
+            _encoder.reset();
+            break;
+        case AES_DIGEST_sha256:
+            _encoder = std::make_unique<encoder_implementation<sha256>>();
+            break;
+        case AES_DIGEST_sha512:
+            _encoder = std::make_unique<encoder_implementation<sha512>>();
+            break;
+        case AES_DIGEST_sha1:
+            _encoder = std::make_unique<encoder_implementation<sha1>>();
+            break;
+        case AES_DIGEST_md5:
+            _encoder = std::make_unique<encoder_implementation<md5>>();
+            break;
+        case AES_DIGEST_ripemd160:
+            _encoder = std::make_unique<encoder_implementation<ripemd160>>();
+            break;
+        default:
+            SSL_HELPERS_ERROR("Invalid digest type");
+        }
+        _type = type;
+    }
+
+    void digest_encoder::write(const char* data, size_t len)
+    {
+        if (_encoder)
+            _encoder->write(data, len);
+    }
+
+    std::string digest_encoder::result()
+    {
+        SSL_HELPERS_ASSERT(_encoder, "Digest is not enabled");
+
+        return _encoder->result();
+    }
+
+    void digest_encoder::reset()
+    {
+        if (_encoder)
+            _encoder->reset();
+    }
+
+    void digest_encoder::restart(AES_DIGEST type)
+    {
+        if (type != _type)
+            set_type(type);
+        else
+            reset();
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
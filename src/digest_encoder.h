@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <ssl_helpers/crypto_types.h>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // Hash encoder (sha256::encoder, sha512::encoder, etc.) selected at runtime.
+    // It is used to hash plain data by the same pass as encryption
+    class digest_encoder
+    {
+    public:
+        explicit digest_encoder(AES_DIGEST type = AES_DIGEST_none);
+        ~digest_encoder();
+
+        // Change type (current data are dropped)
+        void set_type(AES_DIGEST type);
+
+        AES_DIGEST type() const
+        {
+            return _type;
+        }
+
+        bool enabled() const
+        {
+            return static_cast<bool>(_encoder);
+        }
+
+        void write(const char* data, size_t len);
+
+        // Return digest and start new one
+        std::string result();
+
+        void reset();
+
+        // Start new digest of 'type' (encoder is kept for the same type)
+        void restart(AES_DIGEST type);
+
+    private:
+        class encoder_interface;
+        template <class HashType>
+        class encoder_implementation;
+
+        std::unique_ptr<encoder_interface> _encoder;
+        AES_DIGEST _type = AES_DIGEST_none;
+    };
+
+} // namespace impl
+} // namespace ssl_helpers
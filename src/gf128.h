@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // Element of GF(2^128) in GCM bit order (NIST SP 800-38D).
+    // It is used to combine GHASH values calculated separately
+    // so the bitwise (slow) multiplication is enough here.
+    struct gf128
+    {
+        uint64_t hi = 0;
+        uint64_t lo = 0;
+
+        static gf128 load(const unsigned char* block)
+        {
+            gf128 result;
+            for (size_t ci = 0; ci < 8; ++ci)
+            {
+                result.hi = (result.hi << 8) | block[ci];
+                result.lo = (result.lo << 8) | block[ci + 8];
+            }
+            return result;
+        }
+
+        void store(unsigned char* block) const
+        {
+            for (size_t ci = 0; ci < 8; ++ci)
+            {
+                block[7 - ci] = static_cast<unsigned char>(hi >> (8 * ci));
+                block[15 - ci] = static_cast<unsigned char>(lo >> (8 * ci));
+            }
+        }
+
+        gf128& operator^=(const gf128& other)
+        {
+            hi ^= other.hi;
+            lo ^= other.lo;
+            return *this;
+        }
+    };
+
+    inline gf128 operator^(gf128 x, const gf128& y)
+    {
+        return x ^= y;
+    }
+
+    // Operands depend on secret hash key H, so multiplication is constant
+    // time: bits select terms by masks (no branches or table lookups).
+    inline gf128 operator*(const gf128& x, const gf128& y)
+    {
+        gf128 z;
+        gf128 v = y;
+        for (size_t ci = 0; ci < 128; ++ci)
+        {
+            uint64_t bit = (ci < 64) ? (x.hi >> (63 - ci)) : (x.lo >> (127 - ci));
+            uint64_t mask = 0 - (bit & 1);
+            z.hi ^= v.hi & mask;
+            z.lo ^= v.lo & mask;
+
+            uint64_t carry = 0 - (v.lo & 1);
+            v.lo = (v.lo >> 1) | (v.hi << 63);
+            v.hi >>= 1;
+            v.hi ^= 0xe100000000000000ULL & carry;
+        }
+        return z;
+    }
+
+    // Exponent (blocks amount) is not secret
+    inline gf128 gf128_pow(gf128 h, uint64_t n)
+    {
+        gf128 result;
+        result.hi = 0x8000000000000000ULL; // multiplicative identity
+
+        while (n)
+        {
+            if (n & 1)
+                result = result * h;
+            h = h * h;
+            n >>= 1;
+        }
+        return result;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
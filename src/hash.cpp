@@ -1,8 +1,8 @@
+#include <algorithm>
 #include <fstream>
+#include <limits>
 #include <vector>
 
-#include <openssl/evp.h> // PKCS5_PBKDF2_HMAC_SHA1
-
 #include <ssl_helpers/hash.h>
 
 #include "ssl_helpers_defines.h"
@@ -11,6 +11,7 @@
 #include "sha512.h"
 #include "sha1.h"
 #include "md5.h"
+#include "pbkdf2.h"
 
 
 namespace ssl_helpers {
@@ -84,6 +85,32 @@ std::string create_hash(const std::string& data, const size_t limit)
     return trim_hash(h, limit);
 }
 
+template <typename HashType>
+std::string create_hash(const buffer_view* buffers, size_t count, const size_t limit)
+{
+    SSL_HELPERS_ASSERT(buffers || !count, "Buffers required");
+
+    typename HashType::encoder encoder;
+    for (size_t ci = 0; ci < count; ++ci)
+    {
+        const char* data = buffers[ci].data;
+        size_t size = buffers[ci].size;
+        SSL_HELPERS_ASSERT(data || !size, "Buffer required");
+
+        // Encoder counts data by uint32_t
+        while (size > 0)
+        {
+            uint32_t piece = static_cast<uint32_t>(std::min<size_t>(size, std::numeric_limits<uint32_t>::max()));
+            encoder.write(data, piece);
+            data += piece;
+            size -= piece;
+        }
+    }
+    HashType h = encoder.result();
+
+    return trim_hash(h, limit);
+}
+
 template <typename HashType>
 std::string create_hash_from_file(const context& ctx, const std::string& path, const size_t limit)
 {
@@ -131,6 +158,31 @@ std::string create_md5(const std::string& data, const size_t limit)
     return create_hash<impl::md5>(data, limit);
 }
 
+std::string create_ripemd160_from_buffers(const buffer_view* buffers, size_t count, const size_t limit)
+{
+    return create_hash<impl::ripemd160>(buffers, count, limit);
+}
+
+std::string create_sha256_from_buffers(const buffer_view* buffers, size_t count, const size_t limit)
+{
+    return create_hash<impl::sha256>(buffers, count, limit);
+}
+
+std::string create_sha512_from_buffers(const buffer_view* buffers, size_t count, const size_t limit)
+{
+    return create_hash<impl::sha512>(buffers, count, limit);
+}
+
+std::string create_sha1_from_buffers(const buffer_view* buffers, size_t count, const size_t limit)
+{
+    return create_hash<impl::sha1>(buffers, count, limit);
+}
+
+std::string create_md5_from_buffers(const buffer_view* buffers, size_t count, const size_t limit)
+{
+    return create_hash<impl::md5>(buffers, count, limit);
+}
+
 std::string create_ripemd160_from_file(const context& ctx, const std::string& path, const size_t limit)
 {
     return create_hash_from_file<impl::ripemd160>(ctx, path, limit);
@@ -158,17 +210,26 @@ std::string create_md5_from_file(const context& ctx, const std::string& path, co
 
 std::string create_pbkdf2(const std::string& password, const std::string& salt, int iterations, int key_size)
 {
-    std::string key;
-    key.resize(static_cast<std::size_t>(key_size));
-    PKCS5_PBKDF2_HMAC_SHA1(password.c_str(), static_cast<int>(password.size()),
-                           reinterpret_cast<const unsigned char*>(salt.c_str()), static_cast<int>(salt.size()),
-                           iterations, key_size, reinterpret_cast<unsigned char*>(&key[0]));
-    return key;
+    return create_pbkdf2(password, salt, iterations, key_size, config::PBKDF2_PRF_sha1, 1);
+}
+
+std::string create_pbkdf2(const std::string& password, const std::string& salt, int iterations, int key_size,
+                          config::PBKDF2_PRF prf, size_t threads_amount)
+{
+    try
+    {
+        return impl::pbkdf2(prf, password, salt, iterations, key_size, threads_amount);
+    }
+    catch (std::exception& e)
+    {
+        SSL_HELPERS_ERROR(e.what());
+    }
+    return {};
 }
 
 std::string create_pbkdf2_512(const std::string& password, const std::string& salt, const size_t limit)
 {
-    auto h = create_pbkdf2(password, salt, 8192, 512 / 8);
+    auto h = create_pbkdf2(password, salt, 8192, 512 / 8, config::PBKDF2_PRF_sha1, 1);
 
     SSL_HELPERS_ASSERT(limit <= h.size());
 
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include <openssl/crypto.h>
+
+#include "sha1.h"
+#include "sha256.h"
+#include "sha512.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // HMAC (RFC 2104) by chunks. Hash states of keyed pads are kept
+    // so copy of keyed object costs nothing to calculate many
+    // MACs with the same key (PBKDF2 iterations). Keyed states are
+    // as good as the key, so they are erased at destruction.
+    template <class hash_type, size_t block_size>
+    class hmac
+    {
+    public:
+        using result_type = hash_type;
+
+        hmac(const char* key, size_t len)
+        {
+            char key_block[block_size] = { 0 };
+            if (len > block_size)
+            {
+                typename hash_type::encoder key_encoder;
+                key_encoder.write(key, static_cast<uint32_t>(len));
+                auto key_hash = key_encoder.result();
+                std::memcpy(key_block, key_hash.data(), key_hash.data_size());
+                OPENSSL_cleanse(key_hash.data(), key_hash.data_size());
+                OPENSSL_cleanse(&key_encoder, sizeof(key_encoder));
+            }
+            else if (len > 0)
+            {
+                std::memcpy(key_block, key, len);
+            }
+
+            char pad[block_size];
+            for (size_t ci = 0; ci < block_size; ++ci)
+                pad[ci] = key_block[ci] ^ 0x36;
+            _inner.write(pad, block_size);
+
+            for (size_t ci = 0; ci < block_size; ++ci)
+                pad[ci] = key_block[ci] ^ 0x5c;
+            _outer.write(pad, block_size);
+
+            OPENSSL_cleanse(key_block, sizeof(key_block));
+            OPENSSL_cleanse(pad, sizeof(pad));
+        }
+
+        hmac(const hmac&) = default;
+        hmac& operator=(const hmac&) = default;
+
+        ~hmac()
+        {
+            OPENSSL_cleanse(&_inner, sizeof(_inner));
+            OPENSSL_cleanse(&_outer, sizeof(_outer));
+        }
+
+        void write(const char* data, size_t len)
+        {
+            while (len > 0)
+            {
+                auto piece = static_cast<uint32_t>(std::min<size_t>(len, std::numeric_limits<uint32_t>::max()));
+                _inner.write(data, piece);
+                data += piece;
+                len -= piece;
+            }
+        }
+
+        hash_type result()
+        {
+            auto inner_hash = _inner.result();
+
+            _outer.write(inner_hash.data(), static_cast<uint32_t>(inner_hash.data_size()));
+            OPENSSL_cleanse(inner_hash.data(), inner_hash.data_size());
+            return _outer.result();
+        }
+
+    private:
+        typename hash_type::encoder _inner;
+        typename hash_type::encoder _outer;
+    };
+
+    using hmac_sha1 = hmac<sha1, 64>;
+    using hmac_sha256 = hmac<sha256, 64>;
+    using hmac_sha512 = hmac<sha512, 128>;
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,69 @@
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel_helper.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    size_t get_threads_amount(size_t requested, size_t jobs)
+    {
+        size_t result = requested;
+        if (!result)
+            result = std::thread::hardware_concurrency();
+        if (!result)
+            result = 1;
+        if (jobs && result > jobs)
+            result = jobs;
+        return result;
+    }
+
+    void parallel_run(size_t jobs, size_t threads_amount, const std::function<void(size_t)>& job)
+    {
+        std::atomic<size_t> next_job { 0 };
+        std::exception_ptr error;
+        std::mutex error_lock;
+
+        auto worker = [&]() {
+            for (size_t job_index = next_job++; job_index < jobs; job_index = next_job++)
+            {
+                try
+                {
+                    job(job_index);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_lock);
+                    if (!error)
+                        error = std::current_exception();
+                    next_job = jobs;
+                }
+            }
+        };
+
+        threads_amount = get_threads_amount(threads_amount, jobs);
+
+        std::vector<std::thread> threads;
+        threads.reserve(threads_amount - 1);
+        for (size_t ci = 1; ci < threads_amount; ++ci)
+        {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // Threads amount for 'jobs' (0 - all hardware threads)
+    size_t get_threads_amount(size_t requested, size_t jobs);
+
+    // Run job(job_index) for job_index in [0, jobs) by 'threads_amount'
+    // threads including caller one. First exception from workers
+    // is rethrown to caller after all threads are joined.
+    void parallel_run(size_t jobs, size_t threads_amount, const std::function<void(size_t)>& job);
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,106 @@
+#include "pbkdf2.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "ssl_helpers_defines.h"
+#include "parallel_helper.h"
+#include "hmac.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+
+        // T(block) = U(1) ^ U(2) ^ ... ^ U(iterations), where
+        //     U(1) = PRF(password, salt || INT_32_BE(block + 1))
+        //     U(n) = PRF(password, U(n - 1))
+        // Copies of keyed MAC are erased by hmac destructor
+        template <class hmac_type>
+        void pbkdf2_block(const hmac_type& keyed_mac,
+                          const std::string& salt, int iterations,
+                          uint32_t block, char* output, size_t output_len)
+        {
+            const char block_index[] = {
+                static_cast<char>((block + 1) >> 24),
+                static_cast<char>((block + 1) >> 16),
+                static_cast<char>((block + 1) >> 8),
+                static_cast<char>(block + 1)
+            };
+
+            auto mac = keyed_mac;
+            mac.write(salt.data(), salt.size());
+            mac.write(block_index, sizeof(block_index));
+            auto u = mac.result();
+            auto t = u;
+
+            const size_t hash_size = u.data_size();
+            for (int ci = 1; ci < iterations; ++ci)
+            {
+                mac = keyed_mac;
+                mac.write(u.data(), hash_size);
+                u = mac.result();
+
+                char* pt = t.data();
+                const char* pu = u.data();
+                for (size_t cj = 0; cj < hash_size; ++cj)
+                    pt[cj] ^= pu[cj];
+            }
+
+            std::memcpy(output, t.data(), output_len);
+
+            OPENSSL_cleanse(u.data(), hash_size);
+            OPENSSL_cleanse(t.data(), hash_size);
+        }
+
+        template <class hmac_type>
+        std::string pbkdf2(const std::string& password, const std::string& salt,
+                           int iterations, int key_size,
+                           size_t threads_amount)
+        {
+            const hmac_type keyed_mac(password.data(), password.size());
+
+            const size_t hash_size = typename hmac_type::result_type().data_size();
+
+            std::string result(static_cast<size_t>(key_size), '\0');
+
+            const size_t blocks = (result.size() + hash_size - 1) / hash_size;
+
+            parallel_run(blocks, get_threads_amount(threads_amount, blocks), [&](size_t block) {
+                size_t offset = block * hash_size;
+                pbkdf2_block(keyed_mac, salt, iterations, static_cast<uint32_t>(block),
+                             &result[offset], std::min(hash_size, result.size() - offset));
+            });
+
+            return result;
+        }
+
+    } // namespace
+
+    std::string pbkdf2(config::PBKDF2_PRF prf,
+                       const std::string& password, const std::string& salt,
+                       int iterations, int key_size,
+                       size_t threads_amount)
+    {
+        SSL_HELPERS_ASSERT(iterations > 0, "Invalid iterations");
+        SSL_HELPERS_ASSERT(key_size > 0, "Invalid key size");
+
+        switch (prf)
+        {
+        case config::PBKDF2_PRF_sha1:
+            return pbkdf2<hmac_sha1>(password, salt, iterations, key_size, threads_amount);
+        case config::PBKDF2_PRF_sha256:
+            return pbkdf2<hmac_sha256>(password, salt, iterations, key_size, threads_amount);
+        case config::PBKDF2_PRF_sha512:
+            return pbkdf2<hmac_sha512>(password, salt, iterations, key_size, threads_amount);
+        default:;
+        }
+
+        SSL_HELPERS_ERROR("Invalid PRF");
+        return {};
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+#include <ssl_helpers/config.h>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // PBKDF2 (RFC 8018) with HMAC PRF. Output blocks are independent
+    // so they are calculated by 'threads_amount' threads
+    // (0 - all hardware threads but not more than blocks).
+    std::string pbkdf2(config::PBKDF2_PRF prf,
+                       const std::string& password, const std::string& salt,
+                       int iterations, int key_size,
+                       size_t threads_amount);
+
+} // namespace impl
+} // namespace ssl_helpers
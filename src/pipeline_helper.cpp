@@ -0,0 +1,163 @@
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "pipeline_helper.h"
+#include "ssl_helpers_defines.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+
+        enum slot_state
+        {
+            SLOT_FREE = 0,
+            SLOT_READ,
+            SLOT_PROCESSED
+        };
+
+        class pipeline
+        {
+        public:
+            pipeline(size_t slots_amount, size_t input_size, size_t output_size)
+                : _slots(slots_amount)
+                , _states(slots_amount, SLOT_FREE)
+            {
+                for (auto&& slot : _slots)
+                {
+                    slot.input.resize(input_size);
+                    slot.output.resize(output_size);
+                }
+            }
+
+            // Wait for slot 'index' in 'state' and return it or nullptr if pipeline is stopped
+            pipeline_slot* wait(uint64_t index, slot_state state)
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                size_t pos = static_cast<size_t>(index % _slots.size());
+                _cond.wait(lock, [&]() { return _stopped || _states[pos] == state; });
+                if (_stopped)
+                    return nullptr;
+                return &_slots[pos];
+            }
+
+            void set(uint64_t index, slot_state state)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_lock);
+                    _states[static_cast<size_t>(index % _slots.size())] = state;
+                }
+                _cond.notify_all();
+            }
+
+            void stop(std::exception_ptr error = nullptr)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_lock);
+                    if (error && !_error)
+                        _error = error;
+                    _stopped = true;
+                }
+                _cond.notify_all();
+            }
+
+            std::exception_ptr error() const
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                return _error;
+            }
+
+        private:
+            std::vector<pipeline_slot> _slots;
+            std::vector<slot_state> _states;
+            mutable std::mutex _lock;
+            std::condition_variable _cond;
+            bool _stopped = false;
+            std::exception_ptr _error;
+        };
+
+        template <typename Stage>
+        void run_stage(pipeline& pipe, slot_state from, slot_state to, Stage&& stage)
+        {
+            try
+            {
+                for (uint64_t index = 0;; ++index)
+                {
+                    pipeline_slot* slot = pipe.wait(index, from);
+                    if (!slot)
+                        return;
+
+                    slot->index = index;
+                    if (!stage(*slot))
+                    {
+                        pipe.stop();
+                        return;
+                    }
+
+                    bool last = slot->last;
+                    pipe.set(index, to);
+                    if (last)
+                        return;
+                }
+            }
+            catch (...)
+            {
+                pipe.stop(std::current_exception());
+            }
+        }
+
+    } // namespace
+
+    bool pipeline_run(size_t slots_amount, size_t input_size, size_t output_size,
+                      const std::function<void(pipeline_slot&)>& read,
+                      const std::function<void(pipeline_slot&)>& process,
+                      const std::function<bool(const pipeline_slot&)>& write)
+    {
+        SSL_HELPERS_ASSERT(slots_amount > 0, "Slots required");
+
+        pipeline pipe(slots_amount, input_size, output_size);
+
+        bool completed = false;
+
+        std::thread reader([&]() {
+            run_stage(pipe, SLOT_FREE, SLOT_READ, [&](pipeline_slot& slot) {
+                slot.last = false;
+                slot.input_len = 0;
+                read(slot);
+                return true;
+            });
+        });
+        std::thread processor([&]() {
+            run_stage(pipe, SLOT_READ, SLOT_PROCESSED, [&](pipeline_slot& slot) {
+                slot.output_len = 0;
+                process(slot);
+                return true;
+            });
+        });
+
+        run_stage(pipe, SLOT_PROCESSED, SLOT_FREE, [&](pipeline_slot& slot) {
+            if (!write(slot))
+                return false;
+            completed = slot.last;
+            return true;
+        });
+
+        // Wake up stages if writer has stopped earlier
+        if (!completed)
+            pipe.stop();
+
+        reader.join();
+        processor.join();
+
+        auto error = pipe.error();
+        if (error)
+            std::rethrow_exception(error);
+
+        return completed;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    struct pipeline_slot
+    {
+        std::vector<char> input;
+        std::vector<char> output;
+        size_t input_len = 0;
+        size_t output_len = 0;
+        uint64_t index = 0;
+        bool last = false;
+    };
+
+    // Run three stages over bounded ring of 'slots_amount' slots:
+    //
+    //     read (own thread) -> process (own thread) -> write (caller thread)
+    //
+    // so reading, processing and writing of neighbour slots overlap.
+    // Read stage should fill slot input and mark the last slot.
+    // Write stage returns false to cancel. Return false if cancelled.
+    // First exception from stages is rethrown to caller after
+    // all threads are joined.
+    bool pipeline_run(size_t slots_amount, size_t input_size, size_t output_size,
+                      const std::function<void(pipeline_slot&)>& read,
+                      const std::function<void(pipeline_slot&)>& process,
+                      const std::function<bool(const pipeline_slot&)>& write);
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -0,0 +1,176 @@
+#include "salted_key_cache.h"
+
+#include <cstdint>
+#include <algorithm>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include <ssl_helpers/hash.h>
+#include <ssl_helpers/shadowing.h>
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    namespace {
+        constexpr size_t MAX_SHARDS_AMOUNT = 16;
+        constexpr size_t SECRET_SIZE = 32;
+    } // namespace
+
+    __salted_key_cache::__salted_key_cache(size_t max_size)
+        : _secret(SECRET_SIZE, '\0')
+    {
+        SSL_HELPERS_ASSERT(max_size > 0, "Cache size required");
+
+        // Total size doesn't exceed max_size
+        _shards_amount = std::min(max_size, MAX_SHARDS_AMOUNT);
+        _shard_max_size = max_size / _shards_amount;
+        _shards.reset(new shard[_shards_amount]);
+
+        SSL_HELPERS_ASSERT(1 == RAND_bytes((unsigned char*)&_secret[0], static_cast<int>(_secret.size())), "Can't get random data for cache");
+    }
+
+    __salted_key_cache::~__salted_key_cache()
+    {
+        clear();
+        OPENSSL_cleanse(&_secret[0], _secret.size());
+    }
+
+    bool __salted_key_cache::find(const std::string& key, const std::string& salt, std::string& salted_key)
+    {
+        auto h = hash(key, salt);
+        auto& s = get_shard(h);
+
+        std::string shadowed;
+        {
+            std::lock_guard<std::mutex> lock(s.lock);
+
+            auto it = s.index.find(h);
+            if (it == s.index.end())
+            {
+                ++_misses;
+                return false;
+            }
+
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            shadowed = it->second->second;
+        }
+
+        ++_hits;
+        salted_key = from_shadow(shadowed);
+        return true;
+    }
+
+    void __salted_key_cache::insert(const context& ctx, const std::string& key, const std::string& salt, const std::string& salted_key)
+    {
+        auto h = hash(key, salt);
+        auto shadowed = nxor_encode_sec(ctx, salted_key);
+        auto& s = get_shard(h);
+
+        std::lock_guard<std::mutex> lock(s.lock);
+
+        auto it = s.index.find(h);
+        if (it != s.index.end())
+        {
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            return;
+        }
+
+        if (s.lru.size() >= _shard_max_size)
+        {
+            s.index.erase(s.lru.back().first);
+            s.lru.pop_back();
+        }
+
+        s.lru.emplace_front(h, std::move(shadowed));
+        s.index.emplace(std::move(h), s.lru.begin());
+    }
+
+    void __salted_key_cache::clear()
+    {
+        for (size_t ci = 0; ci < _shards_amount; ++ci)
+        {
+            auto& s = _shards[ci];
+
+            std::lock_guard<std::mutex> lock(s.lock);
+
+            for (auto& entry : s.lru)
+                OPENSSL_cleanse(&entry.second[0], entry.second.size());
+            s.index.clear();
+            s.lru.clear();
+        }
+    }
+
+    size_t __salted_key_cache::size() const
+    {
+        size_t result = 0;
+        for (size_t ci = 0; ci < _shards_amount; ++ci)
+        {
+            auto& s = _shards[ci];
+
+            std::lock_guard<std::mutex> lock(s.lock);
+
+            result += s.lru.size();
+        }
+        return result;
+    }
+
+    std::string __salted_key_cache::hash(const std::string& key, const std::string& salt) const
+    {
+        // Key size is hashed to separate key and salt
+        uint64_t key_size = key.size();
+
+        std::string data;
+        data.reserve(sizeof(key_size) + key.size() + salt.size());
+        data.append((const char*)&key_size, sizeof(key_size));
+        data.append(key);
+        data.append(salt);
+
+        std::string result(EVP_MAX_MD_SIZE, '\0');
+        unsigned int result_len = 0;
+
+        auto hmac_result = HMAC(EVP_sha256(), _secret.data(), static_cast<int>(_secret.size()),
+                                (const unsigned char*)data.data(), data.size(),
+                                (unsigned char*)&result[0], &result_len);
+        OPENSSL_cleanse(&data[0], data.size());
+
+        SSL_HELPERS_ASSERT(hmac_result, "Can't create cache hash");
+
+        result.resize(result_len);
+        return result;
+    }
+
+    __salted_key_cache::shard& __salted_key_cache::get_shard(const std::string& hash)
+    {
+        return _shards[static_cast<unsigned char>(hash[0]) % _shards_amount];
+    }
+
+    std::string create_salted_key(const context& ctx, const std::string& key, const std::string& salt,
+                                  size_t threads_amount)
+    {
+        return create_pbkdf2(key, salt, ctx().pbkdf2_iterations(), 512 / 8, ctx().pbkdf2_prf(), threads_amount);
+    }
+
+    std::string get_salted_key(const context& ctx, const std::string& key, const std::string& salt,
+                               size_t threads_amount)
+    {
+        SSL_HELPERS_ASSERT(!key.empty(), "Key required");
+        SSL_HELPERS_ASSERT(!salt.empty(), "Salt required");
+
+        auto cache = ctx.salted_key_cache();
+        if (!cache)
+            return create_salted_key(ctx, key, salt, threads_amount);
+
+        std::string salted_key;
+        if (!cache->find(key, salt, salted_key))
+        {
+            salted_key = create_salted_key(ctx, key, salt, threads_amount);
+            cache->insert(ctx, key, salt, salted_key);
+        }
+        return salted_key;
+    }
+
+} // namespace impl
+} // namespace ssl_helpers
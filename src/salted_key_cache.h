@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <ssl_helpers/context.h>
+
+#include "ssl_helpers_defines.h"
+
+
+namespace ssl_helpers {
+namespace impl {
+
+    // Bounded cache of PBKDF2 salted keys (aes_get_salted_key) that is owned
+    // by context. Entries are found by keyed hash (HMAC-SHA256 with random
+    // per cache secret) of key and salt, so neither key nor salt is stored.
+    // Salted keys are stored shadowed (nxor_encode_sec).
+    // Cache is split to shards with own lock and LRU list to reduce
+    // contention of threads.
+    class __salted_key_cache
+    {
+    public:
+        __salted_key_cache(size_t max_size);
+        ~__salted_key_cache();
+
+        bool find(const std::string& key, const std::string& salt, std::string& salted_key);
+        void insert(const context& ctx, const std::string& key, const std::string& salt, const std::string& salted_key);
+
+        void clear();
+
+        size_t hits() const
+        {
+            return _hits;
+        }
+
+        size_t misses() const
+        {
+            return _misses;
+        }
+
+        size_t size() const;
+
+    private:
+        using lru_list_type = std::list<std::pair<std::string, std::string>>;
+
+        struct shard
+        {
+            mutable std::mutex lock;
+            lru_list_type lru;
+            std::unordered_map<std::string, lru_list_type::iterator> index;
+        };
+
+        std::string hash(const std::string& key, const std::string& salt) const;
+        shard& get_shard(const std::string& hash);
+
+        std::string _secret;
+        size_t _shards_amount = 0;
+        size_t _shard_max_size = 0;
+        std::unique_ptr<shard[]> _shards;
+        std::atomic<size_t> _hits { 0 };
+        std::atomic<size_t> _misses { 0 };
+    };
+
+    // PBKDF2 salted key (512 bit) by settings of context (config::pbkdf2_prf,
+    // config::pbkdf2_iterations). Key blocks are created by 'threads_amount'
+    // threads (0 to use all hardware threads, 1 in workers that are
+    // already parallel)
+    std::string create_salted_key(const context& ctx, const std::string& key, const std::string& salt,
+                                  size_t threads_amount);
+
+    // The same but salted key is taken from context cache if it is enabled
+    std::string get_salted_key(const context& ctx, const std::string& key, const std::string& salt,
+                               size_t threads_amount);
+
+} // namespace impl
+} // namespace ssl_helpers
@@ -43,6 +43,52 @@ namespace tests {
         }
     }
 
+    BOOST_AUTO_TEST_CASE(aead_cipher_config_check)
+    {
+        print_current_test_name();
+
+        {
+            auto& ctx = context::init(context::configurate().enable_libcrypto_api());
+
+            BOOST_REQUIRE_EQUAL(ctx().aead_cipher(), config::AEAD_CIPHER_aes256_gcm);
+        }
+
+        {
+            auto& ctx = context::init(context::configurate().enable_libcrypto_api().set_aead_cipher(config::AEAD_CIPHER_chacha20_poly1305));
+
+            BOOST_REQUIRE_EQUAL(ctx().aead_cipher(), config::AEAD_CIPHER_chacha20_poly1305);
+        }
+
+        {
+            // Auto mode is resolved at initialization
+            auto& ctx = context::init(context::configurate().enable_libcrypto_api().set_aead_cipher(config::AEAD_CIPHER_auto));
+
+            BOOST_REQUIRE(ctx().aead_cipher() == config::AEAD_CIPHER_aes256_gcm || ctx().aead_cipher() == config::AEAD_CIPHER_chacha20_poly1305);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(compression_config_check)
+    {
+        print_current_test_name();
+
+        {
+            auto& ctx = context::init(context::configurate().enable_libcrypto_api());
+
+            BOOST_REQUIRE_EQUAL(ctx().compression(), config::COMPRESSION_none);
+        }
+
+        if (config::is_supported_compression(config::COMPRESSION_zlib))
+        {
+            auto& ctx = context::init(context::configurate().enable_libcrypto_api().set_compression(config::COMPRESSION_zlib));
+
+            BOOST_REQUIRE_EQUAL(ctx().compression(), config::COMPRESSION_zlib);
+        }
+        else
+        {
+            BOOST_REQUIRE_THROW(context::configurate().set_compression(config::COMPRESSION_zlib), std::logic_error);
+        }
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 } // namespace tests
 } // namespace ssl_helpers
@@ -0,0 +1,436 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+
+#include <ssl_helpers/crypto_container.h>
+#include <ssl_helpers/hash.h>
+#include <ssl_helpers/shadowing.h>
+
+#include "tests_common.h"
+
+
+namespace ssl_helpers {
+namespace tests {
+
+    namespace {
+
+        std::string read_file(const boost::filesystem::path& path)
+        {
+            std::ifstream input { path.generic_string(), std::ifstream::binary };
+            return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+        }
+
+    } // namespace
+
+    BOOST_AUTO_TEST_SUITE(container_tests)
+
+    BOOST_AUTO_TEST_CASE(container_stream_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+        const size_t segment_size = 1024;
+
+        for (size_t data_size : { 0, 1, 1024, 1025, 1024 * 10 + 17 })
+        {
+            const std::string data = create_test_data(data_size);
+
+            aes_container_encryptor encryptor(ssl_ctx, shadowed_key, segment_size);
+
+            std::string container = encryptor.start();
+            BOOST_REQUIRE_EQUAL(container.size(), aes_container_header_size());
+
+            // Odd chunks to cross segment boundaries
+
+            for (size_t pos = 0; pos < data.size(); pos += 333)
+                container.append(encryptor.encrypt(data.substr(pos, 333)));
+            container.append(encryptor.finalize());
+
+            aes_container_decryptor decryptor(ssl_ctx, shadowed_key);
+
+            decryptor.start(container.substr(0, aes_container_header_size()));
+            BOOST_REQUIRE_EQUAL(decryptor.segment_size(), segment_size);
+            BOOST_REQUIRE_EQUAL(decryptor.plain_size(container.size()), data.size());
+
+            std::string decrypted_data;
+            for (size_t pos = aes_container_header_size(); pos < container.size(); pos += 777)
+                decrypted_data.append(decryptor.decrypt(container.substr(pos, 777)));
+            decrypted_data.append(decryptor.finalize());
+
+            BOOST_REQUIRE(decrypted_data == data);
+
+            BOOST_REQUIRE(aes_container_decrypt(ssl_ctx, container, shadowed_key) == data);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(container_parallel_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+
+        const std::string data = create_test_data(aes_container_default_segment_size() * 7 + 123);
+
+        const size_t threads_amount = 4;
+
+        std::string container = aes_container_encrypt(ssl_ctx, data, shadowed_key, 0, threads_amount);
+
+        BOOST_REQUIRE(aes_container_decrypt(ssl_ctx, container, shadowed_key, threads_amount) == data);
+        BOOST_REQUIRE(aes_container_decrypt(ssl_ctx, container, shadowed_key, 1) == data);
+
+        aes_container_decryptor decryptor(ssl_ctx, shadowed_key);
+
+        decryptor.start(container.substr(0, aes_container_header_size()));
+        std::string decrypted_data = decryptor.decrypt(container.substr(aes_container_header_size()));
+        decrypted_data.append(decryptor.finalize());
+
+        BOOST_REQUIRE(decrypted_data == data);
+    }
+
+    BOOST_AUTO_TEST_CASE(container_range_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+        const size_t segment_size = 1000;
+
+        const std::string data = create_test_data(segment_size * 5 + 10);
+
+        std::string container = aes_container_encrypt(ssl_ctx, data, shadowed_key, segment_size);
+
+        BOOST_REQUIRE(aes_container_decrypt_range(ssl_ctx, container, shadowed_key, 0, data.size()) == data);
+        BOOST_REQUIRE(aes_container_decrypt_range(ssl_ctx, container, shadowed_key, 999, 2) == data.substr(999, 2));
+        BOOST_REQUIRE(aes_container_decrypt_range(ssl_ctx, container, shadowed_key, 1500, 3000) == data.substr(1500, 3000));
+        BOOST_REQUIRE(aes_container_decrypt_range(ssl_ctx, container, shadowed_key, data.size() - 5, 5) == data.substr(data.size() - 5));
+        BOOST_REQUIRE(aes_container_decrypt_range(ssl_ctx, container, shadowed_key, data.size(), 0).empty());
+
+        BOOST_REQUIRE_THROW(aes_container_decrypt_range(ssl_ctx, container, shadowed_key, data.size() - 5, 6), std::logic_error);
+
+        // Only segments that cover range should be read
+
+        aes_container_decryptor decryptor(ssl_ctx, shadowed_key);
+        decryptor.start(container.substr(0, aes_container_header_size()));
+
+        size_t read_bytes = 0;
+        auto read = [&](uint64_t offset, char* buffer, size_t len) -> size_t {
+            std::memcpy(buffer, container.data() + offset, len);
+            read_bytes += len;
+            return len;
+        };
+
+        BOOST_REQUIRE(decryptor.decrypt_range(read, container.size(), 2100, 100) == data.substr(2100, 100));
+        BOOST_REQUIRE_EQUAL(read_bytes, segment_size + aes_size<aes_tag_type>());
+    }
+
+    BOOST_AUTO_TEST_CASE(container_corrupted_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+        const size_t segment_size = 1000;
+
+        const std::string data = create_test_data(segment_size * 3 + 10);
+
+        const size_t cipher_segment_size = segment_size + aes_size<aes_tag_type>();
+
+        const std::string container = aes_container_encrypt(ssl_ctx, data, shadowed_key, segment_size);
+
+        BOOST_REQUIRE_THROW(aes_container_decrypt(ssl_ctx, container, nxor_encode("Wrong Key")), std::logic_error);
+
+        // Corrupted header (segment size is authenticated)
+
+        std::string corrupted = container;
+        corrupted[10] ^= 1;
+        BOOST_REQUIRE_THROW(aes_container_decrypt(ssl_ctx, corrupted, shadowed_key), std::logic_error);
+
+        // Other container with the same key has own salt (segments key)
+
+        const std::string other_container = aes_container_encrypt(ssl_ctx, data, shadowed_key, segment_size);
+        BOOST_REQUIRE_NE(other_container.substr(0, aes_container_header_size()), container.substr(0, aes_container_header_size()));
+        BOOST_REQUIRE_NE(other_container.substr(aes_container_header_size(), segment_size),
+                         container.substr(aes_container_header_size(), segment_size));
+
+        corrupted = container;
+        std::memcpy(&corrupted[12], other_container.data() + 12, 16);
+        BOOST_REQUIRE_THROW(aes_container_decrypt(ssl_ctx, corrupted, shadowed_key), std::logic_error);
+
+        // Corrupted segment
+
+        corrupted = container;
+        corrupted[aes_container_header_size() + cipher_segment_size + 5] ^= 1;
+        BOOST_REQUIRE_THROW(aes_container_decrypt(ssl_ctx, corrupted, shadowed_key), std::logic_error);
+        BOOST_REQUIRE_THROW(aes_container_decrypt_range(ssl_ctx, corrupted, shadowed_key, segment_size, 1), std::logic_error);
+        BOOST_REQUIRE(aes_container_decrypt_range(ssl_ctx, corrupted, shadowed_key, 0, segment_size) == data.substr(0, segment_size));
+
+        // Truncated on segment boundary (the last segment flag is absent)
+
+        corrupted = container.substr(0, aes_container_header_size() + cipher_segment_size * 2);
+        BOOST_REQUIRE_THROW(aes_container_decrypt(ssl_ctx, corrupted, shadowed_key), std::logic_error);
+
+        // Reordered segments
+
+        corrupted = container;
+        std::memcpy(&corrupted[aes_container_header_size()],
+                    container.data() + aes_container_header_size() + cipher_segment_size, cipher_segment_size);
+        std::memcpy(&corrupted[aes_container_header_size() + cipher_segment_size],
+                    container.data() + aes_container_header_size(), cipher_segment_size);
+        BOOST_REQUIRE_THROW(aes_container_decrypt(ssl_ctx, corrupted, shadowed_key), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(container_cipher_check)
+    {
+        print_current_test_name();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+        const size_t segment_size = 1000;
+
+        const std::string data = create_test_data(segment_size * 3 + 10);
+
+        for (auto cipher : { config::AEAD_CIPHER_aes256_gcm,
+                             config::AEAD_CIPHER_aes128_gcm,
+                             config::AEAD_CIPHER_chacha20_poly1305,
+                             config::AEAD_CIPHER_auto })
+        {
+            auto& ssl_ctx = context::init(context::configurate().enable_libcrypto_api().set_aead_cipher(cipher));
+
+            aes_container_encryptor encryptor(ssl_ctx, shadowed_key, segment_size);
+            std::string container = encryptor.start();
+            container.append(encryptor.encrypt(data));
+            container.append(encryptor.finalize());
+
+            BOOST_REQUIRE(aes_container_encrypt(ssl_ctx, data, shadowed_key, segment_size).substr(5, 1) == container.substr(5, 1));
+
+            const auto selected_cipher = ssl_ctx().aead_cipher();
+            BOOST_REQUIRE(cipher == config::AEAD_CIPHER_auto || selected_cipher == cipher);
+            BOOST_REQUIRE_EQUAL(static_cast<int>(container[5]), static_cast<int>(selected_cipher));
+
+            // Decryption follows the header (context is switched to default)
+
+            auto& default_ctx = default_context_with_crypto_api();
+
+            BOOST_REQUIRE(aes_container_decrypt(default_ctx, container, shadowed_key) == data);
+            BOOST_REQUIRE(aes_container_decrypt_range(default_ctx, container, shadowed_key, 900, 200) == data.substr(900, 200));
+
+            // Cipher is authenticated
+
+            std::string corrupted = container;
+            corrupted[5] = corrupted[5] ? 0 : 2;
+            BOOST_REQUIRE_THROW(aes_container_decrypt(default_ctx, corrupted, shadowed_key), std::logic_error);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(container_compression_check)
+    {
+        print_current_test_name();
+
+        if (!config::is_supported_compression(config::COMPRESSION_zlib))
+        {
+            BOOST_TEST_MESSAGE("zlib is not supported");
+            return;
+        }
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+        const size_t segment_size = 1000;
+
+        const std::string data = create_test_data(100 * 1024 + 7);
+
+        auto& ssl_ctx = context::init(context::configurate().enable_libcrypto_api().set_compression(config::COMPRESSION_zlib));
+
+        aes_container_encryptor encryptor(ssl_ctx, shadowed_key, segment_size);
+        std::string container = encryptor.start();
+        for (size_t pos = 0; pos < data.size(); pos += 333)
+            container.append(encryptor.encrypt(data.substr(pos, 333)));
+        container.append(encryptor.finalize());
+
+        BOOST_REQUIRE_LT(container.size(), data.size() / 10);
+        BOOST_REQUIRE_EQUAL(static_cast<int>(container[7]), static_cast<int>(config::COMPRESSION_zlib));
+
+        // Decompression follows the header (context is switched to default)
+
+        auto& default_ctx = default_context_with_crypto_api();
+
+        BOOST_REQUIRE(aes_container_decrypt(default_ctx, container, shadowed_key) == data);
+
+        aes_container_decryptor decryptor(default_ctx, shadowed_key);
+        decryptor.start(container.substr(0, aes_container_header_size()));
+        std::string decrypted_data;
+        for (size_t pos = aes_container_header_size(); pos < container.size(); pos += 77)
+            decrypted_data.append(decryptor.decrypt(container.substr(pos, 77)));
+        decrypted_data.append(decryptor.finalize());
+
+        BOOST_REQUIRE(decrypted_data == data);
+
+        // No random access
+        BOOST_REQUIRE_THROW(aes_container_decrypt_range(default_ctx, container, shadowed_key, 0, 10), std::logic_error);
+
+        auto& zlib_ctx = context::init(context::configurate().enable_libcrypto_api().set_compression(config::COMPRESSION_zlib));
+
+        container = aes_container_encrypt(zlib_ctx, data, shadowed_key, segment_size);
+        BOOST_REQUIRE_LT(container.size(), data.size() / 10);
+        BOOST_REQUIRE(aes_container_decrypt(zlib_ctx, container, shadowed_key) == data);
+
+        // File to file
+
+        boost::filesystem::path plain_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::path encrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::path decrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+        const std::string file_data = create_test_data(zlib_ctx().file_buffer_size() * 100 + 7);
+        {
+            std::ofstream output { plain_path.generic_string(), std::ofstream::binary };
+            output.write(file_data.data(), file_data.size());
+        }
+
+        uint64_t progress_last = 0;
+        auto progress = [&](uint64_t processed, uint64_t total) {
+            BOOST_REQUIRE_EQUAL(total, file_data.size());
+            BOOST_REQUIRE_GE(processed, progress_last);
+            progress_last = processed;
+            return true;
+        };
+
+        std::string digest;
+        BOOST_REQUIRE(aes_encrypt_file(zlib_ctx, plain_path.generic_string(), encrypted_path.generic_string(), shadowed_key,
+                                       AES_DIGEST_sha256, digest, progress));
+        BOOST_REQUIRE_EQUAL(progress_last, file_data.size());
+        BOOST_REQUIRE_EQUAL(digest, create_sha256(file_data));
+        BOOST_REQUIRE_LT(boost::filesystem::file_size(encrypted_path), file_data.size() / 10);
+
+        BOOST_REQUIRE(aes_container_decrypt(zlib_ctx, read_file(encrypted_path), shadowed_key) == file_data);
+
+        std::string digest_;
+        BOOST_REQUIRE(aes_decrypt_file(zlib_ctx, encrypted_path.generic_string(), decrypted_path.generic_string(), shadowed_key,
+                                       AES_DIGEST_sha256, digest_));
+        BOOST_REQUIRE_EQUAL(digest_, digest);
+        BOOST_REQUIRE(read_file(decrypted_path) == file_data);
+
+        boost::filesystem::remove(plain_path);
+        boost::filesystem::remove(encrypted_path);
+        boost::filesystem::remove(decrypted_path);
+
+        default_context_with_crypto_api();
+    }
+
+    BOOST_AUTO_TEST_CASE(container_file_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+
+        for (size_t file_size : { size_t { 1 }, ssl_ctx().file_buffer_size(), ssl_ctx().file_buffer_size() * 10 + 7, ssl_ctx().file_buffer_size() * 25, ssl_ctx().file_buffer_size() * 100 + 7 })
+        {
+            boost::filesystem::path plain_path = create_binary_data_file(file_size);
+            boost::filesystem::path encrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+            boost::filesystem::path decrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+            uint64_t progress_calls = 0;
+            uint64_t progress_last = 0;
+            auto progress = [&](uint64_t processed, uint64_t total) {
+                BOOST_REQUIRE_EQUAL(total, file_size);
+                BOOST_REQUIRE_GT(processed, progress_last);
+                progress_last = processed;
+                ++progress_calls;
+                return true;
+            };
+
+            BOOST_REQUIRE(aes_encrypt_file(ssl_ctx, plain_path.generic_string(), encrypted_path.generic_string(), shadowed_key, progress));
+            BOOST_REQUIRE_EQUAL(progress_last, file_size);
+            BOOST_REQUIRE_GT(progress_calls, 0u);
+
+            const std::string plain_data = read_file(plain_path);
+            const std::string container = read_file(encrypted_path);
+
+            BOOST_REQUIRE(aes_container_decrypt(ssl_ctx, container, shadowed_key) == plain_data);
+
+            BOOST_REQUIRE(aes_decrypt_file(ssl_ctx, encrypted_path.generic_string(), decrypted_path.generic_string(), shadowed_key));
+            BOOST_REQUIRE(read_file(decrypted_path) == plain_data);
+
+            boost::filesystem::remove(plain_path);
+            boost::filesystem::remove(encrypted_path);
+            boost::filesystem::remove(decrypted_path);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(container_file_digest_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+
+        boost::filesystem::path plain_path = create_binary_data_file(ssl_ctx().file_buffer_size() * 10 + 7);
+        boost::filesystem::path encrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::path decrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+        const std::string plain_data = read_file(plain_path);
+
+        std::string digest;
+        BOOST_REQUIRE(aes_encrypt_file(ssl_ctx, plain_path.generic_string(), encrypted_path.generic_string(), shadowed_key,
+                                       AES_DIGEST_sha256, digest));
+        BOOST_REQUIRE_EQUAL(digest, create_sha256(plain_data));
+
+        std::string digest_;
+        BOOST_REQUIRE(aes_decrypt_file(ssl_ctx, encrypted_path.generic_string(), decrypted_path.generic_string(), shadowed_key,
+                                       AES_DIGEST_sha512, digest_));
+        BOOST_REQUIRE_EQUAL(digest_, create_sha512(plain_data));
+
+        BOOST_REQUIRE_THROW(aes_encrypt_file(ssl_ctx, plain_path.generic_string(), encrypted_path.generic_string(), shadowed_key,
+                                             AES_DIGEST_none, digest),
+                            std::logic_error);
+
+        boost::filesystem::remove(plain_path);
+        boost::filesystem::remove(encrypted_path);
+        boost::filesystem::remove(decrypted_path);
+    }
+
+    BOOST_AUTO_TEST_CASE(container_file_cancel_check)
+    {
+        print_current_test_name();
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        const std::string shadowed_key = nxor_encode("Secret Key");
+
+        boost::filesystem::path plain_path = create_binary_data_file(ssl_ctx().file_buffer_size() * 200);
+        boost::filesystem::path encrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::path decrypted_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+        BOOST_REQUIRE(!aes_encrypt_file(ssl_ctx, plain_path.generic_string(), encrypted_path.generic_string(), shadowed_key,
+                                        [](uint64_t processed, uint64_t total) { return processed < total / 2; }));
+        BOOST_REQUIRE(!boost::filesystem::exists(encrypted_path));
+
+        BOOST_REQUIRE(aes_encrypt_file(ssl_ctx, plain_path.generic_string(), encrypted_path.generic_string(), shadowed_key));
+
+        // Corrupted container
+
+        std::string container = read_file(encrypted_path);
+        container[container.size() / 2] ^= 1;
+        {
+            std::ofstream output { encrypted_path.generic_string(), std::ofstream::binary };
+            output.write(container.data(), container.size());
+        }
+
+        BOOST_REQUIRE_THROW(aes_decrypt_file(ssl_ctx, encrypted_path.generic_string(), decrypted_path.generic_string(), shadowed_key), std::logic_error);
+        BOOST_REQUIRE(!boost::filesystem::exists(decrypted_path));
+
+        boost::filesystem::remove(plain_path);
+        boost::filesystem::remove(encrypted_path);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ssl_helpers
@@ -1,4 +1,11 @@
+#include <cstring>
+#include <iterator>
+
 #include <ssl_helpers/crypto.h>
+#include <ssl_helpers/crypto_streambuf.h>
+#include <ssl_helpers/crypto_session_pool.h>
+#include <ssl_helpers/crypto_record.h>
+#include <ssl_helpers/data_pipeline.h>
 #include <ssl_helpers/hash.h>
 #include <ssl_helpers/encoding.h>
 #include <ssl_helpers/shadowing.h>
@@ -109,6 +116,404 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(data, data_);
     }
 
+    BOOST_AUTO_TEST_CASE(basic_encryption_with_hmac_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Test Key" };
+
+        for (size_t data_sz : { 0, 1, 1024, 50 * 1024 + 7 })
+        {
+            std::string data = create_test_data(data_sz);
+
+            aes_hmac_tag_type tag;
+            auto cipher_data = aes_encrypt(default_context_with_crypto_api(), data, key, tag);
+
+            // Cipher data are the same as without tag
+            BOOST_REQUIRE_EQUAL(to_printable(cipher_data), to_printable(aes_encrypt(default_context_with_crypto_api(), data, key)));
+
+            BOOST_REQUIRE_EQUAL(aes_decrypt(default_context_with_crypto_api(), cipher_data, key, tag), data);
+
+            auto tampered = cipher_data;
+            tampered[tampered.size() / 2] ^= 0x01;
+            BOOST_REQUIRE(aes_decrypt(default_context_with_crypto_api(), tampered, key, tag).empty());
+
+            auto wrong_tag = tag;
+            wrong_tag[0] ^= 0x01;
+            BOOST_REQUIRE(aes_decrypt(default_context_with_crypto_api(), cipher_data, key, wrong_tag).empty());
+
+            BOOST_REQUIRE(aes_decrypt(default_context_with_crypto_api(), cipher_data, "Other Key", tag).empty());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(parallel_cbc_decryption_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Test Key" };
+
+        // Less than one segment, several segments and odd tail
+        for (size_t data_sz : { 1, 15, 16, 1000, 256 * 1024, 1024 * 1024 + 5 })
+        {
+            std::string data = create_test_data(data_sz);
+
+            auto cipher_data = aes_encrypt(default_context_with_crypto_api(), data, key);
+
+            for (size_t threads_amount : { 1, 2, 3, 0 })
+            {
+                BOOST_REQUIRE_EQUAL(aes_decrypt(default_context_with_crypto_api(), cipher_data, key, threads_amount), data);
+            }
+        }
+
+        BOOST_REQUIRE_THROW(aes_decrypt(default_context_with_crypto_api(), std::string(100, 'x'), key, 2), std::logic_error);
+        BOOST_REQUIRE_THROW(aes_decrypt(default_context_with_crypto_api(), std::string {}, key, 2), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(cbc_cipher_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Test Key" };
+
+        aes_cbc_cipher cipher(default_context_with_crypto_api(), key);
+
+        // Init value is reset for every message
+        for (size_t data_sz : { 0, 15, 16, 1000, 1000, 64 * 1024 + 3 })
+        {
+            std::string data = create_test_data(data_sz);
+
+            auto cipher_data = cipher.encrypt(data);
+
+            BOOST_REQUIRE_EQUAL(to_printable(cipher_data), to_printable(aes_encrypt(default_context_with_crypto_api(), data, key)));
+            BOOST_REQUIRE_EQUAL(cipher.decrypt(cipher_data), data);
+
+            std::vector<char> cipher_buff(data.size() + aes_size<aes_128bit_type>());
+            auto cipher_len = cipher.encrypt(data.data(), data.size(), cipher_buff.data());
+            BOOST_REQUIRE_EQUAL(std::string(cipher_buff.data(), cipher_len), cipher_data);
+
+            std::vector<char> plain_buff(cipher_len);
+            auto plain_len = cipher.decrypt(cipher_buff.data(), cipher_len, plain_buff.data());
+            BOOST_REQUIRE_EQUAL(std::string(plain_buff.data(), plain_len), data);
+        }
+
+        BOOST_REQUIRE_THROW(cipher.decrypt(std::string(20, 'x')), std::logic_error);
+
+        // Cipher is valid after error
+        BOOST_REQUIRE_EQUAL(cipher.decrypt(cipher.encrypt("test")), "test");
+    }
+
+    BOOST_AUTO_TEST_CASE(cbc_stream_encryption_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Test Key" };
+
+        aes_cbc_encryption_stream enc_stream(default_context_with_crypto_api());
+        aes_cbc_decryption_stream dec_stream(default_context_with_crypto_api());
+
+        for (size_t data_sz : { 0, 15, 16, 1000, 64 * 1024 + 3 })
+        {
+            std::string data = create_test_data(data_sz);
+
+            auto expected_cipher_data = aes_encrypt(default_context_with_crypto_api(), data, key);
+
+            for (size_t chunk_sz : { 1, 16, 17, 4096 })
+            {
+                std::string cipher_data;
+                enc_stream.start(key);
+                for (size_t pos = 0; pos < data.size(); pos += chunk_sz)
+                {
+                    cipher_data += enc_stream.encrypt(data.substr(pos, chunk_sz));
+                }
+                cipher_data += enc_stream.finalize();
+
+                BOOST_REQUIRE_EQUAL(to_printable(cipher_data), to_printable(expected_cipher_data));
+
+                std::string plain_data;
+                std::vector<char> buff(chunk_sz + aes_size<aes_128bit_type>());
+                dec_stream.start(key);
+                for (size_t pos = 0; pos < cipher_data.size(); pos += chunk_sz)
+                {
+                    size_t len = std::min(chunk_sz, cipher_data.size() - pos);
+                    plain_data.append(buff.data(), dec_stream.decrypt(cipher_data.data() + pos, len, buff.data()));
+                }
+                plain_data += dec_stream.finalize();
+
+                BOOST_REQUIRE_EQUAL(plain_data, data);
+            }
+        }
+
+        // Incomplete block
+        dec_stream.start(key);
+        dec_stream.decrypt(std::string(20, 'x'));
+        BOOST_REQUIRE_THROW(dec_stream.finalize(), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(batch_encryption_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Secret Key" };
+
+        aes_batch_type batch;
+        for (size_t data_sz : { 100, 0, 16, 1, 123, 1024 })
+            batch.add(create_test_data(data_sz));
+
+        auto cipher_batch = aes_encrypt_batch(default_context_with_crypto_api(), batch, key);
+
+        BOOST_REQUIRE_EQUAL(cipher_batch.size(), batch.size());
+
+        for (size_t ci = 0; ci < batch.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(cipher_batch.item(ci), aes_encrypt(default_context_with_crypto_api(), batch.item(ci), key));
+        }
+
+        auto batch_ = aes_decrypt_batch(default_context_with_crypto_api(), cipher_batch, key);
+
+        BOOST_REQUIRE(batch_.offsets == batch.offsets);
+        BOOST_REQUIRE_EQUAL(batch_.data, batch.data);
+
+        BOOST_REQUIRE(aes_encrypt_batch(default_context_with_crypto_api(), aes_batch_type {}, key).data.empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(gcm_batch_encryption_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Secret Key" };
+        std::string shadowed_key = nxor_encode(key);
+        const std::string aad { "AAD" };
+
+        aes_batch_type batch;
+        for (size_t data_sz : { 100, 0, 16, 1, 123, 1024 })
+            batch.add(create_test_data(data_sz));
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        auto cipher_batch = aes_encrypt_gcm_batch(ssl_ctx, batch, shadowed_key, aad);
+
+        BOOST_REQUIRE_EQUAL(cipher_batch.size(), batch.size());
+
+        // Every message has unique nonce
+
+        for (size_t ci = 1; ci < cipher_batch.size(); ++ci)
+        {
+            BOOST_REQUIRE_NE(cipher_batch.item(ci).substr(0, 12), cipher_batch.item(ci - 1).substr(0, 12));
+        }
+
+        auto batch_ = aes_decrypt_gcm_batch(ssl_ctx, cipher_batch, shadowed_key, aad);
+
+        BOOST_REQUIRE(batch_.offsets == batch.offsets);
+        BOOST_REQUIRE_EQUAL(batch_.data, batch.data);
+
+        // Messages can be decrypted separately
+
+        aes_batch_type single;
+        single.add(cipher_batch.item(4));
+        BOOST_REQUIRE_EQUAL(aes_decrypt_gcm_batch(ssl_ctx, single, shadowed_key, aad).item(0), batch.item(4));
+
+        BOOST_REQUIRE_THROW(aes_decrypt_gcm_batch(ssl_ctx, cipher_batch, shadowed_key), std::logic_error);
+
+        cipher_batch.data[cipher_batch.offsets[3] + 13] ^= 1;
+        BOOST_REQUIRE_THROW(aes_decrypt_gcm_batch(ssl_ctx, cipher_batch, shadowed_key, aad), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(session_pool_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Secret Key" };
+        std::string shadowed_key = nxor_encode(key);
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        aes_session_pool pool(ssl_ctx, shadowed_key);
+
+        for (const std::string aad : { "", "AAD", "Long AAD (more than one block)" })
+        {
+            for (size_t data_sz : { 1, 15, 16, 17, 100, 1024, 40000 })
+            {
+                std::string data = create_test_data(data_sz);
+
+                // Data are encrypted by uneven chunks
+                auto session = pool.open_encryption(aad);
+                std::string cipher_data;
+                for (size_t offset = 0, chunk = 1; offset < data.size(); offset += chunk, chunk = chunk * 3 + 1)
+                {
+                    cipher_data += pool.encrypt(session, data.substr(offset, chunk));
+                }
+                auto nonce = pool.nonce(session);
+                auto tag = pool.finalize_encryption(session);
+
+                BOOST_REQUIRE_EQUAL(cipher_data.size(), data.size());
+
+                // Result is standard AES256-GCM (batch message is |nonce|cipher data|tag|)
+                aes_batch_type cipher_batch;
+                cipher_batch.add(std::string(nonce.data(), nonce.size()) + cipher_data + std::string(tag.data(), tag.size()));
+                BOOST_REQUIRE_EQUAL(aes_decrypt_gcm_batch(ssl_ctx, cipher_batch, shadowed_key, aad).item(0), data);
+
+                // Decryption in place by other chunks
+                session = pool.open_decryption(nonce, aad);
+                std::string data_ = cipher_data;
+                for (size_t offset = 0; offset < data_.size(); offset += 7)
+                {
+                    pool.decrypt(session, &data_[offset], std::min<size_t>(7, data_.size() - offset), &data_[offset]);
+                }
+                pool.finalize_decryption(session, tag);
+
+                BOOST_REQUIRE_EQUAL(data_, data);
+
+                session = pool.open_decryption(nonce, aad + "!");
+                pool.decrypt(session, cipher_data);
+                BOOST_REQUIRE_THROW(pool.finalize_decryption(session, tag), std::logic_error);
+            }
+        }
+
+        // Session with caller nonce
+        aes_nonce_type nonce;
+        nonce.fill('N');
+        auto session = pool.open_encryption(nonce);
+        BOOST_REQUIRE(pool.nonce(session) == nonce);
+        auto cipher_data = pool.encrypt(session, "Data");
+        auto tag = pool.finalize_encryption(session);
+
+        session = pool.open_decryption(nonce);
+        BOOST_REQUIRE_EQUAL(pool.decrypt(session, cipher_data), "Data");
+        tag[0] ^= 1;
+        BOOST_REQUIRE_THROW(pool.finalize_decryption(session, tag), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(session_pool_handles_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Secret Key" };
+        std::string shadowed_key = nxor_encode(key);
+
+        aes_session_pool pool(default_context_with_crypto_api(), shadowed_key, 2);
+
+        const size_t sessions = 1000;
+
+        std::vector<aes_session_handle> handles;
+        for (size_t ci = 0; ci < sessions; ++ci)
+        {
+            handles.emplace_back(pool.open_encryption());
+        }
+        BOOST_REQUIRE_EQUAL(pool.sessions_amount(), sessions);
+        BOOST_REQUIRE_GE(pool.memory_usage(), sessions * aes_session_pool::session_size());
+        BOOST_REQUIRE_LE(aes_session_pool::session_size(), 128u);
+
+        // Interleaved sessions
+        std::string data = create_test_data(100);
+        std::vector<std::string> cipher_data(sessions);
+        for (size_t offset = 0; offset < data.size(); offset += 10)
+        {
+            for (size_t ci = 0; ci < sessions; ++ci)
+            {
+                cipher_data[ci] += pool.encrypt(handles[ci], data.substr(offset, 10));
+            }
+        }
+
+        auto nonce = pool.nonce(handles[5]);
+        auto tag = pool.finalize_encryption(handles[5]);
+        for (size_t ci = 0; ci < sessions; ++ci)
+        {
+            if (ci != 5)
+                pool.close(handles[ci]);
+        }
+        BOOST_REQUIRE_EQUAL(pool.sessions_amount(), 0u);
+
+        // Closed handle is invalid even if its slot is reused
+        auto memory_usage = pool.memory_usage();
+        auto session = pool.open_decryption(nonce);
+        BOOST_REQUIRE_EQUAL(pool.memory_usage(), memory_usage);
+        for (auto&& handle : handles)
+        {
+            BOOST_REQUIRE_THROW(pool.encrypt(handle, data), std::logic_error);
+        }
+        BOOST_REQUIRE_THROW(pool.encrypt(session, data), std::logic_error);
+        BOOST_REQUIRE_THROW(pool.close(aes_session_handle {}), std::logic_error);
+
+        BOOST_REQUIRE_EQUAL(pool.decrypt(session, cipher_data[5]), data);
+        pool.finalize_decryption(session, tag);
+    }
+
+    BOOST_AUTO_TEST_CASE(record_check)
+    {
+        print_current_test_name();
+
+        const std::string key { "Secret Key" };
+        std::string shadowed_key = nxor_encode(key);
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        aes_record_sealer sealer(ssl_ctx, shadowed_key);
+
+        std::vector<std::string> messages;
+        std::string frames;
+        for (size_t data_sz : { 100, 0, 16, 1, 123, 1024, 5 })
+        {
+            messages.emplace_back(create_test_data(data_sz));
+
+            auto frame = sealer.seal(messages.back());
+            BOOST_REQUIRE_EQUAL(frame.size(), aes_record_frame_size(data_sz));
+            frames += frame;
+        }
+        BOOST_REQUIRE_EQUAL(sealer.sequence(), messages.size());
+
+        // The same message gives other record for other sequence number
+        BOOST_REQUIRE_NE(sealer.seal(messages[0]), frames.substr(0, aes_record_frame_size(messages[0].size())));
+
+        // Receive buffer is filled by uneven pieces
+        aes_record_opener opener(ssl_ctx, shadowed_key, sealer.salt());
+
+        std::vector<std::string> messages_;
+        std::string buffer;
+        for (size_t offset = 0, piece = 1; offset < frames.size(); offset += piece, piece = piece * 2 + 3)
+        {
+            buffer += frames.substr(offset, piece);
+
+            auto consumed = opener.open_in_place(&buffer[0], buffer.size(), [&](const char* data, size_t len) {
+                messages_.emplace_back(data, len);
+            });
+            buffer.erase(0, consumed);
+        }
+        BOOST_REQUIRE(buffer.empty());
+        BOOST_REQUIRE(messages_ == messages);
+        BOOST_REQUIRE_EQUAL(opener.sequence(), messages.size());
+
+        // Records are authenticated with their sequence number
+        aes_record_opener other_opener(ssl_ctx, shadowed_key, sealer.salt());
+        auto second_frame = frames.substr(aes_record_frame_size(messages[0].size()), aes_record_frame_size(messages[1].size()));
+        BOOST_REQUIRE_THROW(other_opener.open(second_frame), std::logic_error);
+
+        auto first_frame = frames.substr(0, aes_record_frame_size(messages[0].size()));
+        first_frame[10] ^= 1;
+        BOOST_REQUIRE_THROW(other_opener.open(first_frame), std::logic_error);
+        first_frame[10] ^= 1;
+        first_frame[3] ^= 1;
+        BOOST_REQUIRE_THROW(other_opener.open(first_frame), std::logic_error);
+        first_frame[3] ^= 1;
+
+        BOOST_REQUIRE_EQUAL(other_opener.open(first_frame), messages[0]);
+        BOOST_REQUIRE_EQUAL(other_opener.open(second_frame), messages[1]);
+
+        std::vector<char> small_frame(aes_record_frame_size(messages[0].size()) - 1);
+        BOOST_REQUIRE_THROW(sealer.seal(messages[0].data(), messages[0].size(), small_frame.data(), small_frame.size()), std::logic_error);
+
+        // Other sealer with the same key (other direction or connection)
+        // doesn't repeat nonces
+        aes_record_sealer other_sealer(ssl_ctx, shadowed_key);
+        BOOST_REQUIRE(other_sealer.salt() != sealer.salt());
+
+        auto other_first_frame = other_sealer.seal(messages[0]);
+        BOOST_REQUIRE_NE(other_first_frame, first_frame);
+        BOOST_REQUIRE_NE(other_first_frame.substr(4, messages[0].size()), first_frame.substr(4, messages[0].size()));
+
+        BOOST_REQUIRE_THROW(aes_record_opener(ssl_ctx, shadowed_key, sealer.salt()).open(other_first_frame), std::logic_error);
+        BOOST_REQUIRE_EQUAL(aes_record_opener(ssl_ctx, shadowed_key, other_sealer.salt()).open(other_first_frame), messages[0]);
+    }
+
     BOOST_AUTO_TEST_CASE(stream_encryption_check)
     {
         print_current_test_name();
@@ -438,6 +843,483 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(data, data2);
     }
 
+    BOOST_AUTO_TEST_CASE(stream_caller_buffer_check)
+    {
+        print_current_test_name();
+
+        constexpr size_t chunk_size = 100;
+
+        std::string data = create_test_data(chunk_size * 3 + 7);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        aes_encryption_stream enc_stream(default_context_with_crypto_api());
+        enc_stream.start(shadowed_key);
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+
+        std::vector<char> cipher_data(data.size());
+
+        enc_stream.start(shadowed_key);
+        for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+        {
+            auto len = std::min(chunk_size, data.size() - offset);
+            BOOST_REQUIRE_EQUAL(enc_stream.encrypt(data.data() + offset, len, cipher_data.data() + offset), len);
+        }
+        auto tag = enc_stream.finalize();
+
+        BOOST_REQUIRE_EQUAL(std::string(cipher_data.data(), cipher_data.size()), expected_cipher_data);
+        BOOST_REQUIRE(tag == expected_tag);
+
+        std::vector<char> data_(data.size());
+
+        aes_decryption_stream dec_stream(default_context_with_crypto_api());
+        dec_stream.start(shadowed_key);
+        for (size_t offset = 0; offset < cipher_data.size(); offset += chunk_size)
+        {
+            auto len = std::min(chunk_size, cipher_data.size() - offset);
+            BOOST_REQUIRE_EQUAL(dec_stream.decrypt(cipher_data.data() + offset, len, data_.data() + offset), len);
+        }
+        BOOST_REQUIRE_NO_THROW(dec_stream.finalize(tag));
+
+        BOOST_REQUIRE_EQUAL(data, std::string(data_.data(), data_.size()));
+    }
+
+    BOOST_AUTO_TEST_CASE(stream_digest_check)
+    {
+        print_current_test_name();
+
+        // Larger than internal piece to hash and encrypt by several pieces
+        const std::string data = create_test_data(100 * 1024 + 7);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        aes_encryption_stream enc_stream(default_context_with_crypto_api());
+        enc_stream.start(shadowed_key);
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+
+        enc_stream.set_digest(AES_DIGEST_sha256);
+
+        std::string buffer = data;
+        std::string digest;
+        enc_stream.start(shadowed_key);
+        enc_stream.encrypt_in_place(&buffer[0], 1000);
+        enc_stream.encrypt_in_place(&buffer[1000], buffer.size() - 1000);
+        auto tag = enc_stream.finalize(digest);
+
+        BOOST_REQUIRE_EQUAL(buffer, expected_cipher_data);
+        BOOST_REQUIRE(tag == expected_tag);
+        BOOST_REQUIRE_EQUAL(digest, create_sha256(data));
+
+        // Digest is calculated for every session
+        enc_stream.start(shadowed_key);
+        enc_stream.encrypt(data.substr(0, 10));
+        enc_stream.finalize(digest);
+        BOOST_REQUIRE_EQUAL(digest, create_sha256(data.substr(0, 10)));
+
+        aes_decryption_stream dec_stream(default_context_with_crypto_api());
+        dec_stream.set_digest(AES_DIGEST_md5);
+        dec_stream.start(shadowed_key);
+        BOOST_REQUIRE_EQUAL(dec_stream.decrypt(buffer), data);
+        dec_stream.finalize(tag, digest);
+        BOOST_REQUIRE_EQUAL(digest, create_md5(data));
+
+        dec_stream.start(shadowed_key);
+        dec_stream.decrypt(buffer);
+        tag[0] ^= 1;
+        BOOST_REQUIRE_THROW(dec_stream.finalize(tag, digest), std::logic_error);
+
+        // Null tag is not a reason to skip check
+        std::string tampered = buffer;
+        tampered[0] ^= 1;
+        dec_stream.start(shadowed_key);
+        dec_stream.decrypt(tampered);
+        BOOST_REQUIRE_THROW(dec_stream.finalize(aes_tag_type {}, digest), std::logic_error);
+
+        enc_stream.set_digest(AES_DIGEST_none);
+        enc_stream.start(shadowed_key);
+        enc_stream.encrypt(data);
+        BOOST_REQUIRE_THROW(enc_stream.finalize(digest), std::logic_error);
+
+        // Session is kept if digest is not enabled
+        BOOST_REQUIRE(enc_stream.finalize() == expected_tag);
+
+        // Digest type is changed for the next session only
+        enc_stream.start(shadowed_key);
+        enc_stream.encrypt(data.substr(0, 10));
+        enc_stream.set_digest(AES_DIGEST_sha256);
+        enc_stream.encrypt(data.substr(10));
+        BOOST_REQUIRE_THROW(enc_stream.finalize(digest), std::logic_error);
+        BOOST_REQUIRE(enc_stream.finalize() == expected_tag);
+
+        enc_stream.start(shadowed_key);
+        enc_stream.encrypt(data.substr(0, 10));
+        enc_stream.set_digest(AES_DIGEST_none);
+        enc_stream.encrypt(data.substr(10));
+        BOOST_REQUIRE(enc_stream.finalize(digest) == expected_tag);
+        BOOST_REQUIRE_EQUAL(digest, create_sha256(data));
+    }
+
+    BOOST_AUTO_TEST_CASE(data_pipeline_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(50 * 1024 + 7);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        aes_encryption_stream enc_stream(default_context_with_crypto_api());
+        enc_stream.start(shadowed_key);
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+        expected_cipher_data += aes_to_string(expected_tag);
+
+        // Odd block sizes check pending bytes of encoders
+        for (size_t block_size : { 0, 1, 5, 1000 })
+        {
+            BOOST_TEST_MESSAGE("Block size: " << block_size);
+
+            std::string result;
+            string_sink sink(result);
+            base64_encoding_stage base64(sink, block_size < 4 ? 0 : block_size);
+            digest_stage digest(AES_DIGEST_sha256, &base64);
+            aes_encrypting_stage encryption(default_context_with_crypto_api(), digest, shadowed_key, {}, block_size);
+            pipe(data, encryption, block_size);
+
+            BOOST_REQUIRE(encryption.tag() == expected_tag);
+            BOOST_REQUIRE_EQUAL(digest.digest(), create_sha256(expected_cipher_data));
+            BOOST_REQUIRE_EQUAL(result, to_base64(expected_cipher_data));
+
+            std::string hex_result;
+            string_sink hex_sink(hex_result);
+            hex_encoding_stage hex(hex_sink, block_size < 2 ? 0 : block_size);
+            pipe(data, hex, block_size);
+
+            BOOST_REQUIRE_EQUAL(hex_result, to_hex(data));
+
+            std::string plain_data;
+            string_sink plain_sink(plain_data);
+            aes_decrypting_stage decryption(default_context_with_crypto_api(), plain_sink, shadowed_key, {}, block_size);
+            pipe(expected_cipher_data, decryption, block_size);
+
+            BOOST_REQUIRE_EQUAL(plain_data, data);
+        }
+
+        std::string cipher_data = expected_cipher_data;
+        cipher_data[10] ^= 1;
+
+        std::string plain_data;
+        string_sink plain_sink(plain_data);
+        aes_decrypting_stage decryption(default_context_with_crypto_api(), plain_sink, shadowed_key);
+        BOOST_REQUIRE_THROW(pipe(cipher_data, decryption), std::logic_error);
+
+        // Null tag is not a reason to skip check
+        std::fill(cipher_data.end() - aes_size<aes_tag_type>(), cipher_data.end(), '\0');
+
+        plain_data.clear();
+        aes_decrypting_stage null_tag_decryption(default_context_with_crypto_api(), plain_sink, shadowed_key);
+        BOOST_REQUIRE_THROW(pipe(cipher_data, null_tag_decryption), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(data_pipeline_compression_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(50 * 1024 + 7);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        for (auto compression : { config::COMPRESSION_none, config::COMPRESSION_zlib })
+        {
+            if (!config::is_supported_compression(compression))
+                continue;
+
+            std::string cipher_data;
+            string_sink cipher_sink(cipher_data);
+            aes_encrypting_stage encryption(default_context_with_crypto_api(), cipher_sink, shadowed_key);
+            compressing_stage compressing(compression, encryption);
+            pipe(data, compressing, 1000);
+
+            if (compression != config::COMPRESSION_none)
+                BOOST_REQUIRE_LT(cipher_data.size(), data.size() / 10);
+
+            std::string plain_data;
+            string_sink plain_sink(plain_data);
+            decompressing_stage decompressing(plain_sink);
+            aes_decrypting_stage decryption(default_context_with_crypto_api(), decompressing, shadowed_key);
+            pipe(cipher_data, decryption, 77);
+
+            BOOST_REQUIRE_EQUAL(plain_data, data);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(stream_scatter_gather_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(1000);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        aes_encryption_stream enc_stream(default_context_with_crypto_api());
+        enc_stream.start(shadowed_key);
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+
+        // Fragments are not aligned to cipher block
+        std::string header = data.substr(0, 7);
+        std::string body = data.substr(7, 980);
+        std::string trailer = data.substr(987);
+
+        const buffer_view plain_buffers[] = { header, {}, body, trailer };
+        std::string cipher_data(data.size(), '\0');
+
+        enc_stream.set_digest(AES_DIGEST_sha256);
+        enc_stream.start(shadowed_key);
+        BOOST_REQUIRE_EQUAL(enc_stream.encrypt(plain_buffers, 4, &cipher_data[0]), data.size());
+        std::string digest;
+        BOOST_REQUIRE(enc_stream.finalize(digest) == expected_tag);
+        BOOST_REQUIRE(cipher_data == expected_cipher_data);
+        BOOST_REQUIRE_EQUAL(digest, create_sha256(data));
+
+        const mutable_buffer_view buffers[] = { header, body, trailer };
+
+        enc_stream.set_digest(AES_DIGEST_none);
+        enc_stream.start(shadowed_key);
+        BOOST_REQUIRE_EQUAL(enc_stream.encrypt_in_place(buffers, 3), data.size());
+        BOOST_REQUIRE(enc_stream.finalize() == expected_tag);
+        BOOST_REQUIRE(header + body + trailer == expected_cipher_data);
+
+        aes_decryption_stream dec_stream(default_context_with_crypto_api());
+
+        const buffer_view cipher_buffers[] = { header, body, trailer };
+        std::string plain_data(data.size(), '\0');
+
+        dec_stream.start(shadowed_key);
+        BOOST_REQUIRE_EQUAL(dec_stream.decrypt(cipher_buffers, 3, &plain_data[0]), data.size());
+        dec_stream.finalize(expected_tag);
+        BOOST_REQUIRE(plain_data == data);
+
+        dec_stream.start(shadowed_key);
+        BOOST_REQUIRE_EQUAL(dec_stream.decrypt_in_place(buffers, 3), data.size());
+        dec_stream.finalize(expected_tag);
+        BOOST_REQUIRE(header + body + trailer == data);
+    }
+
+    BOOST_AUTO_TEST_CASE(stream_in_place_check)
+    {
+        print_current_test_name();
+
+        constexpr size_t chunk_size = 100;
+
+        const std::string data = create_test_data(chunk_size * 3 + 7);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        aes_encryption_stream enc_stream(default_context_with_crypto_api());
+        enc_stream.start(shadowed_key);
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+
+        std::string buffer = data;
+
+        enc_stream.start(shadowed_key);
+        for (size_t offset = 0; offset < buffer.size(); offset += chunk_size)
+        {
+            auto len = std::min(chunk_size, buffer.size() - offset);
+            BOOST_REQUIRE_EQUAL(enc_stream.encrypt_in_place(&buffer[offset], len), len);
+        }
+        auto tag = enc_stream.finalize();
+
+        BOOST_REQUIRE_EQUAL(buffer, expected_cipher_data);
+        BOOST_REQUIRE(tag == expected_tag);
+
+        aes_decryption_stream dec_stream(default_context_with_crypto_api());
+        dec_stream.start(shadowed_key);
+        for (size_t offset = 0; offset < buffer.size(); offset += chunk_size)
+        {
+            auto len = std::min(chunk_size, buffer.size() - offset);
+            BOOST_REQUIRE_EQUAL(dec_stream.decrypt_in_place(&buffer[offset], len), len);
+        }
+        BOOST_REQUIRE_NO_THROW(dec_stream.finalize(tag));
+
+        BOOST_REQUIRE_EQUAL(buffer, data);
+    }
+
+    BOOST_AUTO_TEST_CASE(streambuf_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(1024 * 10 + 7);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+        const std::string aad { "AAD" };
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        aes_encryption_stream enc_stream(ssl_ctx);
+        enc_stream.start(shadowed_key, aad);
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+
+        // Small buffer to mix buffered and direct writes
+
+        const size_t buffer_size = 100;
+
+        std::ostringstream sink;
+        aes_encrypting_streambuf enc_buf(ssl_ctx, sink.rdbuf(), shadowed_key, aad, buffer_size);
+        {
+            std::ostream out(&enc_buf);
+            out << data.substr(0, 10);
+            out.put(data[10]);
+            out.write(data.data() + 11, 1000);
+            out << data.substr(1011, 50) << std::flush;
+            out.write(data.data() + 1061, data.size() - 1061);
+            BOOST_REQUIRE(out.good());
+        }
+        auto tag = enc_buf.finalize();
+
+        BOOST_REQUIRE_EQUAL(sink.str(), expected_cipher_data);
+        BOOST_REQUIRE(tag == expected_tag);
+
+        std::istringstream source(sink.str());
+        aes_decrypting_streambuf dec_buf(ssl_ctx, source.rdbuf(), shadowed_key, aad, buffer_size);
+        std::string data_;
+        {
+            std::istream in(&dec_buf);
+            data_.resize(data.size());
+            in.get(data_[0]);
+            in.read(&data_[1], 30);
+            in.read(&data_[31], 2000);
+            data_.resize(2031);
+            data_.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        BOOST_REQUIRE_NO_THROW(dec_buf.finalize(tag));
+
+        BOOST_REQUIRE_EQUAL(data_, data);
+
+        std::istringstream corrupted_source(sink.str());
+        aes_decrypting_streambuf corrupted_buf(ssl_ctx, corrupted_source.rdbuf(), shadowed_key, aad, buffer_size);
+        {
+            std::istream in(&corrupted_buf);
+            std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        tag[0] ^= 1;
+        BOOST_REQUIRE_THROW(corrupted_buf.finalize(tag), std::logic_error);
+
+        // Null tag is not a reason to skip check
+        std::string tampered = sink.str();
+        tampered[0] ^= 1;
+        std::istringstream tampered_source(tampered);
+        aes_decrypting_streambuf null_tag_buf(ssl_ctx, tampered_source.rdbuf(), shadowed_key, aad, buffer_size);
+        {
+            std::istream in(&null_tag_buf);
+            std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        BOOST_REQUIRE_THROW(null_tag_buf.finalize(aes_tag_type {}), std::logic_error);
+
+        // Source that fails after 'limit' bytes
+        class failing_streambuf : public std::streambuf
+        {
+        public:
+            failing_streambuf(const std::string& data, size_t limit)
+                : _data(data.substr(0, limit))
+            {
+            }
+
+        protected:
+            std::streamsize xsgetn(char* s, std::streamsize n) override
+            {
+                if (_data.empty())
+                    throw std::runtime_error("Read error");
+
+                auto len = std::min<size_t>(static_cast<size_t>(n), _data.size());
+                std::memcpy(s, _data.data(), len);
+                _data.erase(0, len);
+                return static_cast<std::streamsize>(len);
+            }
+
+        private:
+            std::string _data;
+        };
+
+        // Error is not hidden as EOF
+        {
+            failing_streambuf failing_source(sink.str(), 0);
+            aes_decrypting_streambuf failing_buf(ssl_ctx, &failing_source, shadowed_key, aad, buffer_size);
+            std::istream in(&failing_buf);
+            char ch;
+            BOOST_REQUIRE(!in.get(ch));
+            BOOST_REQUIRE(in.bad());
+        }
+
+        // Data taken before error are returned
+        {
+            failing_streambuf failing_source(sink.str(), buffer_size);
+            aes_decrypting_streambuf failing_buf(ssl_ctx, &failing_source, shadowed_key, aad, buffer_size);
+            std::vector<char> plain_data(buffer_size * 2);
+            BOOST_REQUIRE_EQUAL(failing_buf.sbumpc(), static_cast<unsigned char>(data[0]));
+            BOOST_REQUIRE_EQUAL(failing_buf.sgetn(plain_data.data(), plain_data.size()), static_cast<std::streamsize>(buffer_size - 1));
+            BOOST_REQUIRE_EQUAL(std::string(plain_data.data(), buffer_size - 1), data.substr(1, buffer_size - 1));
+            BOOST_REQUIRE_THROW(failing_buf.sgetn(plain_data.data(), plain_data.size()), std::logic_error);
+
+            std::istream in(&failing_buf);
+            BOOST_REQUIRE(!in.read(plain_data.data(), 1));
+            BOOST_REQUIRE(in.bad());
+        }
+
+        // Sink that fails once after 'limit' bytes
+        class failing_sink : public std::streambuf
+        {
+        public:
+            failing_sink(size_t limit)
+                : _limit(limit)
+            {
+            }
+
+            std::string data;
+
+        protected:
+            std::streamsize xsputn(const char* s, std::streamsize n) override
+            {
+                auto len = static_cast<size_t>(n);
+                if (!_failed && data.size() + len > _limit)
+                {
+                    _failed = true;
+                    len = _limit - data.size();
+                }
+                data.append(s, len);
+                return static_cast<std::streamsize>(len);
+            }
+
+        private:
+            size_t _limit;
+            bool _failed = false;
+        };
+
+        // Data are not encrypted again after write error
+        {
+            failing_sink sink_(buffer_size / 4);
+            aes_encrypting_streambuf failing_buf(ssl_ctx, &sink_, shadowed_key, aad, buffer_size);
+            std::ostream out(&failing_buf);
+            out.write(data.data(), buffer_size / 2);
+            BOOST_REQUIRE(!out.flush());
+            BOOST_REQUIRE(out.bad());
+            BOOST_REQUIRE_EQUAL(sink_.data, expected_cipher_data.substr(0, buffer_size / 4));
+            BOOST_REQUIRE_EQUAL(failing_buf.pubsync(), -1);
+            BOOST_REQUIRE_THROW(failing_buf.finalize(), std::logic_error);
+            BOOST_REQUIRE_EQUAL(sink_.data, expected_cipher_data.substr(0, buffer_size / 4));
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(salted_key_check)
     {
         print_current_test_name();
@@ -468,7 +1350,7 @@ namespace tests {
 
             BOOST_REQUIRE(!cipher_data.empty());
 
-            auto data_ = aes_decrypt(default_context_with_crypto_api(), cipher_data, aes_get_salted_key(key, from_base64(salt)));
+            auto data_ = aes_decrypt(default_context_with_crypto_api(), cipher_data, aes_get_salted_key(default_context_with_crypto_api(), key, from_base64(salt)));
 
             BOOST_REQUIRE(!data_.empty());
 
@@ -576,6 +1458,81 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(payload, payload_);
     }
 
+    BOOST_AUTO_TEST_CASE(stream_reused_context_check)
+    {
+        print_current_test_name();
+
+        std::string data = create_test_data(333);
+
+        const std::vector<std::string> keys { "Key 1", "Key 1", "Key 2", "Key 1" };
+
+        aes_encryption_stream enc(default_context_with_crypto_api());
+        aes_decryption_stream dec(default_context_with_crypto_api());
+
+        for (auto&& key : keys)
+        {
+            auto shadowed_key = ssl_helpers::nxor_encode(key);
+
+            std::string expected_cipher_data;
+            aes_tag_type expected_tag;
+            {
+                aes_encryption_stream fresh_enc(default_context_with_crypto_api());
+                fresh_enc.start(shadowed_key, "aad");
+                expected_cipher_data = fresh_enc.encrypt(data);
+                expected_tag = fresh_enc.finalize();
+            }
+
+            enc.start(shadowed_key, "aad");
+            auto cipher_data = enc.encrypt(data);
+            auto tag = enc.finalize();
+
+            BOOST_REQUIRE_EQUAL(cipher_data, expected_cipher_data);
+            BOOST_REQUIRE(tag == expected_tag);
+
+            // Corrupted tag should not break next session
+            auto corrupted_tag = tag;
+            corrupted_tag[0] = ~corrupted_tag[0];
+
+            dec.start(shadowed_key, "aad");
+            dec.decrypt(cipher_data);
+            BOOST_REQUIRE_THROW(dec.finalize(corrupted_tag), std::logic_error);
+
+            dec.start(shadowed_key, "aad");
+            BOOST_REQUIRE_EQUAL(dec.decrypt(cipher_data), data);
+            BOOST_REQUIRE_NO_THROW(dec.finalize(tag));
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(stream_prepared_key_check)
+    {
+        print_current_test_name();
+
+        std::string data = create_test_data(1024 + 5);
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        prepared_aes_key prepared_key(default_context_with_crypto_api(), shadowed_key);
+
+        aes_encryption_stream enc_stream(default_context_with_crypto_api());
+        enc_stream.start(shadowed_key, "aad");
+        auto expected_cipher_data = enc_stream.encrypt(data);
+        auto expected_tag = enc_stream.finalize();
+
+        aes_decryption_stream dec_stream(default_context_with_crypto_api());
+
+        for (size_t ci = 0; ci < 3; ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(enc_stream.start(prepared_key, "aad"), "aad");
+            BOOST_REQUIRE_EQUAL(enc_stream.encrypt(data), expected_cipher_data);
+            BOOST_REQUIRE(enc_stream.finalize() == expected_tag);
+
+            dec_stream.start(prepared_key, "aad");
+            BOOST_REQUIRE_EQUAL(dec_stream.decrypt(expected_cipher_data), data);
+            BOOST_REQUIRE_NO_THROW(dec_stream.finalize(expected_tag));
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(flip_flap_with_marker_check)
     {
         print_current_test_name();
@@ -666,6 +1623,343 @@ namespace tests {
         }
     }
 
+    BOOST_AUTO_TEST_CASE(flip_flap_buffers_check)
+    {
+        print_current_test_name();
+
+        const size_t data_sz = 1024;
+
+        std::string data = create_test_data(data_sz);
+
+        const std::string key { "Temp Key4" };
+        const std::string marker { "$$$" };
+
+        std::string cipher_data(aes_flip_cipher_size(data.size(), marker), '\0');
+        std::string session_data(aes_flip_session_max_size(marker), '\0');
+
+        auto session_len = aes_encrypt_flip(default_context_with_crypto_api(), data.data(), data.size(), key,
+                                            &cipher_data[0], &session_data[0], marker); // flip
+        BOOST_REQUIRE_LE(session_len, session_data.size());
+        session_data.resize(session_len);
+
+        DUMP_STR(to_printable(session_data));
+
+        // Buffers are compatible with strings
+        BOOST_REQUIRE_EQUAL(aes_decrypt_flip(default_context_with_crypto_api(), cipher_data, session_data, key, marker), data);
+
+        std::string data_(aes_flip_plain_size(cipher_data.size(), marker), '\0');
+        BOOST_REQUIRE_EQUAL(aes_decrypt_flip(default_context_with_crypto_api(), cipher_data.data(), cipher_data.size(),
+                                             session_data.data(), session_data.size(), key, &data_[0], marker),
+                            data.size()); // flap
+        BOOST_REQUIRE_EQUAL(data, data_);
+
+        auto flip_data = aes_encrypt_flip(default_context_with_crypto_api(), data, key, marker, false);
+        BOOST_REQUIRE_EQUAL(flip_data.first.size(), cipher_data.size());
+        BOOST_REQUIRE_EQUAL(flip_data.second.size(), marker.size() + aes_salt_type {}.size() + aes_tag_type {}.size());
+
+        BOOST_REQUIRE_THROW(aes_decrypt_flip(default_context_with_crypto_api(), cipher_data, session_data, key, "###"), std::logic_error);
+
+        std::string tampered = cipher_data;
+        tampered[tampered.size() / 2] ^= 0x01;
+        BOOST_REQUIRE_THROW(aes_decrypt_flip(default_context_with_crypto_api(), tampered.data(), tampered.size(),
+                                             session_data.data(), session_data.size(), key, &data_[0], marker),
+                            std::logic_error);
+        BOOST_REQUIRE_EQUAL(data_, std::string(data_.size(), '\0'));
+    }
+
+    BOOST_AUTO_TEST_CASE(flip_flap_stream_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(50 * 1024 + 7);
+
+        const std::string key { "Temp Key5" };
+        const std::string marker { "$$$" };
+
+        const size_t chunk_size = 1000;
+
+        aes_flip_encryption_stream enc_stream(default_context_with_crypto_api(), marker);
+
+        std::string cipher_data = enc_stream.start(key);
+        for (size_t pos = 0; pos < data.size(); pos += chunk_size)
+        {
+            cipher_data += enc_stream.encrypt(data.substr(pos, chunk_size));
+        }
+        std::string session_data = enc_stream.finalize();
+
+        DUMP_STR(to_printable(session_data));
+
+        // Compatible with Flap at once
+        BOOST_REQUIRE_EQUAL(aes_decrypt_flip(default_context_with_crypto_api(), cipher_data, session_data, key, marker), data);
+
+        // Chunks of any size (marker is split)
+        for (size_t chunk_sz : { 1, 2, 777 })
+        {
+            aes_flip_decryption_stream dec_stream(default_context_with_crypto_api(), marker);
+
+            dec_stream.start(session_data, key);
+            std::string plain_data;
+            for (size_t pos = 0; pos < cipher_data.size(); pos += chunk_sz)
+            {
+                plain_data += dec_stream.decrypt(cipher_data.substr(pos, chunk_sz));
+            }
+            dec_stream.finalize();
+
+            BOOST_REQUIRE_EQUAL(plain_data, data);
+        }
+
+        for (size_t block_size : { 0, 1, 1000 })
+        {
+            BOOST_TEST_MESSAGE("Block size: " << block_size);
+
+            std::string pipe_cipher_data;
+            string_sink cipher_sink(pipe_cipher_data);
+            aes_flip_encrypting_stage encryption(default_context_with_crypto_api(), cipher_sink, key, marker, true, block_size);
+            pipe(data, encryption, block_size);
+
+            std::string plain_data;
+            string_sink plain_sink(plain_data);
+            aes_flip_decrypting_stage decryption(default_context_with_crypto_api(), plain_sink, encryption.session_data(), key, marker, block_size);
+            pipe(pipe_cipher_data, decryption, block_size);
+
+            BOOST_REQUIRE_EQUAL(plain_data, data);
+        }
+
+        std::string tampered = cipher_data;
+        tampered[tampered.size() / 2] ^= 0x01;
+
+        aes_flip_decryption_stream dec_stream(default_context_with_crypto_api(), marker);
+        dec_stream.start(session_data, key);
+        dec_stream.decrypt(tampered);
+        BOOST_REQUIRE_THROW(dec_stream.finalize(), std::logic_error);
+
+        dec_stream.start(session_data, key);
+        BOOST_REQUIRE_THROW(dec_stream.decrypt("###"), std::logic_error);
+
+        // Null tag in session data is not a reason to skip check
+        std::string null_tag_session_data = session_data;
+        std::fill_n(null_tag_session_data.begin() + marker.size() + 16, 16, '\0');
+
+        aes_flip_decryption_stream null_tag_stream(default_context_with_crypto_api(), marker);
+        null_tag_stream.start(null_tag_session_data, key);
+        null_tag_stream.decrypt(tampered);
+        BOOST_REQUIRE_THROW(null_tag_stream.finalize(), std::logic_error);
+
+        std::string null_tag_plain_data;
+        string_sink plain_sink(null_tag_plain_data);
+        aes_flip_decrypting_stage decryption(default_context_with_crypto_api(), plain_sink, null_tag_session_data, key, marker);
+        BOOST_REQUIRE_THROW(pipe(tampered, decryption), std::logic_error);
+
+        auto results = aes_decrypt_flip_batch(default_context_with_crypto_api(), { { tampered, null_tag_session_data } }, { key });
+        BOOST_REQUIRE_EQUAL(results.size(), 1u);
+        BOOST_REQUIRE(!results[0].ok);
+    }
+
+    BOOST_AUTO_TEST_CASE(flip_flap_batch_check)
+    {
+        print_current_test_name();
+
+        const std::string marker { "$$$" };
+
+        const size_t amount = 12;
+
+        std::vector<std::string> plain_data;
+        std::vector<std::string> keys;
+        std::vector<flip_session_type> sessions;
+        for (size_t ci = 0; ci < amount; ++ci)
+        {
+            plain_data.emplace_back(create_test_data(100 + ci * 10));
+            keys.emplace_back("Temp Key " + std::to_string(ci));
+            sessions.emplace_back(aes_encrypt_flip(default_context_with_crypto_api(), plain_data.back(), keys.back(), marker));
+        }
+
+        // Broken sessions
+        sessions[3].first[marker.size() + 1] ^= 0x01;
+        keys[7] = "Wrong Key";
+        sessions[9].second.resize(10);
+
+        for (size_t threads_amount : { 1, 4, 0 })
+        {
+            auto results = aes_decrypt_flip_batch(default_context_with_crypto_api(), sessions, keys, marker, threads_amount);
+
+            BOOST_REQUIRE_EQUAL(results.size(), amount);
+            for (size_t ci = 0; ci < amount; ++ci)
+            {
+                if (ci == 3 || ci == 7 || ci == 9)
+                {
+                    BOOST_REQUIRE(!results[ci].ok);
+                    BOOST_REQUIRE(results[ci].plain_data.empty());
+                    BOOST_REQUIRE(!results[ci].error.empty());
+                }
+                else
+                {
+                    BOOST_REQUIRE(results[ci].ok);
+                    BOOST_REQUIRE_EQUAL(results[ci].plain_data, plain_data[ci]);
+                }
+            }
+        }
+
+        // One key for all sessions
+        std::vector<flip_session_type> one_key_sessions;
+        for (size_t ci = 0; ci < 3; ++ci)
+            one_key_sessions.emplace_back(aes_encrypt_flip(default_context_with_crypto_api(), plain_data[ci], keys[0]));
+
+        auto results = aes_decrypt_flip_batch(default_context_with_crypto_api(), one_key_sessions, { keys[0] });
+        for (size_t ci = 0; ci < one_key_sessions.size(); ++ci)
+            BOOST_REQUIRE_EQUAL(results[ci].plain_data, plain_data[ci]);
+
+        BOOST_REQUIRE_THROW(aes_decrypt_flip_batch(default_context_with_crypto_api(), sessions, { keys[0], keys[1] }), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(salted_key_cache_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(1024);
+
+        const std::string key { "Temp Key6" };
+
+        auto flip_data = aes_encrypt_flip(default_context_with_crypto_api(), data, key);
+
+        auto& ssl_ctx = context::init(context::configurate().enable_libcrypto_api().set_salted_key_cache_size(4));
+
+        for (size_t ci = 0; ci < 3; ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(aes_decrypt_flip(ssl_ctx, flip_data, key), data);
+        }
+
+        auto stat = aes_get_salted_key_cache_stat(ssl_ctx);
+        BOOST_CHECK_EQUAL(stat.misses, 1u);
+        BOOST_CHECK_EQUAL(stat.hits, 2u);
+        BOOST_CHECK_EQUAL(stat.size, 1u);
+
+        // Cached key for other key or salt is not used
+        BOOST_REQUIRE_THROW(aes_decrypt_flip(ssl_ctx, flip_data, "Temp Key7"), std::logic_error);
+
+        for (size_t ci = 0; ci < 10; ++ci)
+        {
+            auto salted_key = aes_create_salted_key(ssl_ctx, key);
+            BOOST_REQUIRE_EQUAL(aes_get_salted_key(ssl_ctx, key, salted_key.second), salted_key.first);
+            BOOST_REQUIRE_EQUAL(aes_get_salted_key(ssl_ctx, key, salted_key.second), salted_key.first);
+        }
+
+        stat = aes_get_salted_key_cache_stat(ssl_ctx);
+        BOOST_CHECK_LE(stat.size, 4u);
+        BOOST_CHECK_EQUAL(stat.hits, 12u);
+
+        aes_clear_salted_key_cache(ssl_ctx);
+        BOOST_CHECK_EQUAL(aes_get_salted_key_cache_stat(ssl_ctx).size, 0u);
+
+        // Disabled by default
+        aes_decrypt_flip(default_context_with_crypto_api(), flip_data, key);
+        BOOST_CHECK_EQUAL(aes_get_salted_key_cache_stat(default_context_with_crypto_api()).misses, 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(salted_key_pbkdf2_config_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(1024);
+
+        const std::string key { "Temp Key8" };
+
+        auto& ssl_ctx = context::init(context::configurate()
+                                          .enable_libcrypto_api()
+                                          .set_pbkdf2_prf(config::PBKDF2_PRF_sha256)
+                                          .set_pbkdf2_iterations(1000));
+
+        auto salted_key = aes_create_salted_key(ssl_ctx, key);
+        std::string salt_str { salted_key.second.data(), salted_key.second.size() };
+
+        BOOST_REQUIRE_EQUAL(salted_key.first, create_pbkdf2(key, salt_str, 1000, 512 / 8, config::PBKDF2_PRF_sha256));
+        BOOST_REQUIRE_EQUAL(aes_get_salted_key(ssl_ctx, key, salted_key.second), salted_key.first);
+
+        auto flip_data = aes_encrypt_flip(ssl_ctx, data, key);
+
+        BOOST_REQUIRE_EQUAL(aes_decrypt_flip(ssl_ctx, flip_data, key), data);
+
+        // Both sides should use the same settings
+        BOOST_REQUIRE_THROW(aes_decrypt_flip(default_context_with_crypto_api(), flip_data, key), std::logic_error);
+        BOOST_REQUIRE_NE(aes_get_salted_key(default_context_with_crypto_api(), key, salted_key.second), salted_key.first);
+
+        // Default settings are compatible with previous versions
+        auto default_salted_key = aes_create_salted_key(default_context_with_crypto_api(), key);
+        std::string default_salt_str { default_salted_key.second.data(), default_salted_key.second.size() };
+        BOOST_REQUIRE_EQUAL(default_salted_key.first, create_pbkdf2_512(key, default_salt_str));
+        BOOST_REQUIRE_EQUAL(aes_get_salted_key(default_context_with_crypto_api(), key, default_salted_key.second), default_salted_key.first);
+
+        BOOST_REQUIRE_THROW(context::configurate().set_pbkdf2_iterations(0), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(stream_aead_cipher_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(300 * 1024 + 7);
+
+        const std::string key { "Secret Key" };
+        std::string shadowed_key = nxor_encode(key);
+        const std::string aad { "AAD" };
+
+        aes_tag_type default_tag;
+        auto default_cipher_data = aes_encrypt_parallel(default_context_with_crypto_api(), data, shadowed_key, default_tag, aad, 1);
+
+        aes_batch_type batch;
+        batch.add(data);
+
+        for (auto cipher : { config::AEAD_CIPHER_aes128_gcm,
+                             config::AEAD_CIPHER_chacha20_poly1305 })
+        {
+            BOOST_TEST_MESSAGE("Cipher: " << static_cast<int>(cipher));
+
+            auto& ssl_ctx = context::init(context::configurate().enable_libcrypto_api().set_aead_cipher(cipher));
+
+            aes_encryption_stream enc_stream(ssl_ctx, shadowed_key, aad);
+            enc_stream.start();
+            auto cipher_data = enc_stream.encrypt(data);
+            auto tag = enc_stream.finalize();
+
+            BOOST_REQUIRE_NE(cipher_data, default_cipher_data);
+
+            aes_decryption_stream dec_stream(ssl_ctx, shadowed_key, aad);
+            dec_stream.start();
+            BOOST_REQUIRE_EQUAL(dec_stream.decrypt(cipher_data), data);
+            BOOST_REQUIRE_NO_THROW(dec_stream.finalize(tag));
+
+            // Parallel data are the same as stream data for any cipher
+            aes_tag_type parallel_tag;
+            BOOST_REQUIRE_EQUAL(aes_encrypt_parallel(ssl_ctx, data, shadowed_key, parallel_tag, aad, 4), cipher_data);
+            BOOST_REQUIRE(parallel_tag == tag);
+            BOOST_REQUIRE_EQUAL(aes_decrypt_parallel(ssl_ctx, cipher_data, shadowed_key, tag, aad, 4), data);
+
+            auto cipher_batch = aes_encrypt_gcm_batch(ssl_ctx, batch, shadowed_key, aad);
+            BOOST_REQUIRE_EQUAL(aes_decrypt_gcm_batch(ssl_ctx, cipher_batch, shadowed_key, aad).data, data);
+
+            // Both sides should use the same cipher
+            BOOST_REQUIRE_THROW(aes_decrypt_parallel(default_context_with_crypto_api(), cipher_data, shadowed_key, tag, aad, 1), std::logic_error);
+            BOOST_REQUIRE_THROW(aes_decrypt_gcm_batch(default_context_with_crypto_api(), cipher_batch, shadowed_key, aad), std::logic_error);
+        }
+
+        // Auto mode depends on host so data without header are AES-256-GCM
+        {
+            auto& ssl_ctx = context::init(context::configurate().enable_libcrypto_api().set_aead_cipher(config::AEAD_CIPHER_auto));
+
+            BOOST_REQUIRE_EQUAL(ssl_ctx().headerless_aead_cipher(), config::AEAD_CIPHER_aes256_gcm);
+
+            aes_encryption_stream enc_stream(ssl_ctx, shadowed_key, aad);
+            enc_stream.start();
+            BOOST_REQUIRE_EQUAL(enc_stream.encrypt(data), default_cipher_data);
+            BOOST_REQUIRE(enc_stream.finalize() == default_tag);
+
+            aes_tag_type parallel_tag;
+            BOOST_REQUIRE_EQUAL(aes_encrypt_parallel(ssl_ctx, data, shadowed_key, parallel_tag, aad, 4), default_cipher_data);
+            BOOST_REQUIRE(parallel_tag == default_tag);
+
+            auto cipher_batch = aes_encrypt_gcm_batch(ssl_ctx, batch, shadowed_key, aad);
+            BOOST_REQUIRE_EQUAL(aes_decrypt_gcm_batch(default_context_with_crypto_api(), cipher_batch, shadowed_key, aad).data, data);
+        }
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 } // namespace tests
 } // namespace ssl_helpers
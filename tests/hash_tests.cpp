@@ -120,6 +120,40 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2("Password", "Salt", 8192, 512 / 8)), "a941ccbc34d1ee8ebbd1d34824a419c3dc4eac9cbc7c36ae6c7ca8725e2b618a6ad22241e787af937b0960cf85aa8ea3a258f243e05d3cc9b08af5dd93be046c");
     }
 
+    BOOST_AUTO_TEST_CASE(pbkdf2_prf_check)
+    {
+        print_current_test_name();
+
+        const std::string password { "Password" };
+        const std::string salt { "Salt" };
+
+        for (size_t threads_amount: { 1, 0 })
+        {
+            BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2(password, salt, 4096, 100, config::PBKDF2_PRF_sha1, threads_amount)),
+                                "f66df50f8aaa11e4d9721e1312ff2e66433a399c2c4b46d937b84e43cc9fc86e5856758c09d5ba3a3464d23908d1b641ca043cbabf04a43e07bcbaa8825ea7be55880bf85f5bb0bbbab14631ebfe15aa18fde5f61e6205560188f4934aa602c2f2710f5a");
+            BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2(password, salt, 4096, 100, config::PBKDF2_PRF_sha256, threads_amount)),
+                                "ccb76b6773746f4833e17e3e260724c483d1cf19b2e437c62dfd034f7c818860c35bb41b8940c44456ef8cc5211d92c5c8d93025d1dc1987b6e28764320f24f31df8929503b94b5c61a53f9d5f537ae80ddafddf6125b850ac43dbaa2b18b032cdf73ac9");
+            BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2(password, salt, 4096, 100, config::PBKDF2_PRF_sha512, threads_amount)),
+                                "af17008d05cd91948080cf6a28aa22d6069d7a81475137398ebad8ce5e5c588de93ba63aae4eaa21e1c40eec1eccf098d40241010600c2ea8fc56a70dfcda56c4c33f82e5a956f2063944c75e94c145178776cdfd6d18ae54e8cc4b1bde2c6fb8359488d");
+        }
+
+        BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2(password, salt, 4096, 128 / 8, config::PBKDF2_PRF_sha512)), "af17008d05cd91948080cf6a28aa22d6");
+
+        // RFC 7914 (11)
+        BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2("passwd", "salt", 1, 64, config::PBKDF2_PRF_sha256)),
+                            "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783");
+
+        // Password is longer than HMAC block (it is hashed)
+        const std::string long_password(150, 'P');
+        BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2(long_password, salt, 2, 32, config::PBKDF2_PRF_sha256)),
+                            "960fa45e75689d89e0b9a1af0660aa120c54b565a4ff7c9b78fa74459590c731");
+        BOOST_REQUIRE_EQUAL(to_hex(create_pbkdf2(long_password, salt, 2, 32, config::PBKDF2_PRF_sha512)),
+                            "df692cd3efd98b25716c58f52995ab05c5b6b11101220d773814ab214dea5c0b");
+
+        BOOST_REQUIRE_THROW(create_pbkdf2(password, salt, 0, 64, config::PBKDF2_PRF_sha256), std::logic_error);
+        BOOST_REQUIRE_THROW(create_pbkdf2(password, salt, 4096, 0, config::PBKDF2_PRF_sha256), std::logic_error);
+    }
+
     BOOST_AUTO_TEST_CASE(sha256_from_file_check)
     {
         print_current_test_name();
@@ -155,6 +189,26 @@ namespace tests {
         check_hash_from_file(create_md5_from_file, "75dcd9dcdc8448f41e08281ecd8de537");
     }
 
+    BOOST_AUTO_TEST_CASE(scattered_hash_check)
+    {
+        print_current_test_name();
+
+        const std::string data = create_test_data(1000);
+
+        const std::string header = data.substr(0, 10);
+        const std::string trailer = data.substr(990);
+        const buffer_view buffers[] = { header, {}, { data.data() + 10, 980 }, trailer };
+        const size_t count = sizeof(buffers) / sizeof(buffers[0]);
+
+        BOOST_CHECK_EQUAL(to_hex(create_ripemd160_from_buffers(buffers, count)), to_hex(create_ripemd160(data)));
+        BOOST_CHECK_EQUAL(to_hex(create_sha256_from_buffers(buffers, count)), to_hex(create_sha256(data)));
+        BOOST_CHECK_EQUAL(to_hex(create_sha512_from_buffers(buffers, count)), to_hex(create_sha512(data)));
+        BOOST_CHECK_EQUAL(to_hex(create_sha1_from_buffers(buffers, count)), to_hex(create_sha1(data)));
+        BOOST_CHECK_EQUAL(to_hex(create_md5_from_buffers(buffers, count, 8)), to_hex(create_md5(data, 8)));
+
+        BOOST_CHECK_EQUAL(to_hex(create_sha256_from_buffers(nullptr, 0)), to_hex(create_sha256(std::string {})));
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 } // namespace tests
 } // namespace ssl_helpers
@@ -109,6 +109,66 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(data, data_);
     }
 
+    BOOST_AUTO_TEST_CASE(parallel_stream_compatibility_check)
+    {
+        print_current_test_name();
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        for (size_t data_sz : { 1, 123, 1024 * 1024 + 3, 3 * 1024 * 1024 + 16 })
+        {
+            for (auto&& aad : { std::string {}, std::string { "Some AAD with odd size" } })
+            {
+                std::string data = create_test_data(data_sz);
+
+                aes_encryption_stream stream(ssl_ctx);
+                stream.start(shadowed_key, aad);
+                auto expected_cipher_data = stream.encrypt(data);
+                auto expected_tag = stream.finalize();
+
+                aes_tag_type tag;
+                auto cipher_data = aes_encrypt_parallel(ssl_ctx, data, shadowed_key, tag, aad, 4);
+
+                BOOST_REQUIRE_EQUAL(cipher_data.size(), data.size());
+                BOOST_REQUIRE(cipher_data == expected_cipher_data);
+                BOOST_REQUIRE(tag == expected_tag);
+
+                auto data_ = aes_decrypt_parallel(ssl_ctx, cipher_data, shadowed_key, tag, aad, 3);
+
+                BOOST_REQUIRE(data_ == data);
+            }
+        }
+
+        aes_tag_type tag;
+        auto cipher_data = aes_encrypt_parallel(ssl_ctx, std::string {}, shadowed_key, tag, "AAD only", 4);
+        BOOST_REQUIRE(cipher_data.empty());
+        BOOST_REQUIRE_NO_THROW(aes_decrypt_parallel(ssl_ctx, cipher_data, shadowed_key, tag, "AAD only", 4));
+        BOOST_REQUIRE_THROW(aes_decrypt_parallel(ssl_ctx, cipher_data, shadowed_key, tag, "AAD only!", 4), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(parallel_corrupted_data_check)
+    {
+        print_current_test_name();
+
+        const std::string check_key { "Secret Key" };
+        std::string shadowed_key = ssl_helpers::nxor_encode(check_key);
+
+        auto& ssl_ctx = default_context_with_crypto_api();
+
+        std::string data = create_test_data(1024 * 1024 + 5);
+
+        aes_tag_type tag;
+        auto cipher_data = aes_encrypt_parallel(ssl_ctx, data, shadowed_key, tag, {}, 4);
+
+        // Corrupt!
+        cipher_data[cipher_data.size() - 100] = ~cipher_data[cipher_data.size() - 100];
+
+        BOOST_REQUIRE_THROW(aes_decrypt_parallel(ssl_ctx, cipher_data, shadowed_key, tag, {}, 4), std::logic_error);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 } // namespace tests
 } // namespace ssl_helpers